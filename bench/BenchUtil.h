@@ -0,0 +1,53 @@
+/**
+ * @file BenchUtil.h
+ * @brief Small timing helpers shared by the benchmark executables
+ */
+
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock BenchClock;
+
+inline long long elapsedNanos(BenchClock::time_point start, BenchClock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+inline double elapsedMillis(BenchClock::time_point start, BenchClock::time_point end) {
+    return elapsedNanos(start, end) / 1e6;
+}
+
+// Parses argv[index] as a positive count, falling back to a default
+inline long benchArgCount(int argc, char** argv, int index, long fallback) {
+    if (argc > index) {
+        long value = std::atol(argv[index]);
+        if (value > 0) {
+            return value;
+        }
+    }
+    return fallback;
+}
+
+// Sorts the samples in place and prints p50/p90/p99/p99.9/max in nanoseconds
+inline void printPercentiles(const std::string& label, std::vector<long long>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    std::printf("%-28s p50=%6lld  p90=%6lld  p99=%7lld  p99.9=%8lld  max=%9lld ns\n",
+                label.c_str(),
+                samples[n * 50 / 100],
+                samples[n * 90 / 100],
+                samples[n * 99 / 100],
+                samples[n * 999 / 1000],
+                samples[n - 1]);
+}
+
+#endif // BENCHUTIL_H
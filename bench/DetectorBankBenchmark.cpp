@@ -0,0 +1,170 @@
+/**
+ * @file DetectorBankBenchmark.cpp
+ * @brief Threshold evaluation of a detector fleet: per-object virtual
+ *        getReading() vs. DetectorBank with the scalar, SSE2 and AVX2 kernels
+ *
+ * Usage: DetectorBankBenchmark [detectors] [passes]   (default 100000 / 1000)
+ *
+ * Before timing, every supported kernel is checked against the scalar kernel
+ * on random and edge-case inputs (INT_MIN/INT_MAX, equal level and threshold,
+ * sizes around the 64-entry word boundary), and the fleet bitmask is checked
+ * against the per-object comparison. Exits with 1 on any mismatch.
+ */
+
+#include "DetectorBank.h"
+#include "SmokeDetector.h"
+#include "GasDetector.h"
+#include "OutputSink.h"
+#include "BenchUtil.h"
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+typedef DetectorBank::Word Word;
+
+static const DetectorBank::Kernel KERNELS[] = {
+    DetectorBank::KERNEL_SCALAR, DetectorBank::KERNEL_SSE2, DetectorBank::KERNEL_AVX2
+};
+
+static bool bitSet(const std::vector<Word>& mask, size_t i) {
+    return (mask[i / DetectorBank::WORD_BITS] >> (i % DetectorBank::WORD_BITS)) & 1;
+}
+
+// Every supported kernel must produce the scalar kernel's mask and count
+static bool checkKernels() {
+    std::mt19937 rng(22);
+    std::uniform_int_distribution<int> small(-3, 3);
+    std::uniform_int_distribution<int> any(INT_MIN, INT_MAX);
+    std::uniform_int_distribution<int> pick(0, 5);
+    const int edges[] = { INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX };
+
+    for (size_t size = 0; size <= 300; ++size) {
+        for (int round = 0; round < 4; ++round) {
+            DetectorBank bank;
+            for (size_t i = 0; i < size; ++i) {
+                int threshold;
+                int level;
+                switch (pick(rng)) {
+                    case 0:  threshold = edges[rng() % 7]; level = edges[rng() % 7]; break;
+                    case 1:  threshold = level = any(rng); break;
+                    case 2:  threshold = any(rng); level = any(rng); break;
+                    default: threshold = small(rng); level = small(rng); break;
+                }
+                bank.add(threshold, level);
+            }
+            // Shrinking must leave the padding inert again
+            if (round == 3 && size > 0) {
+                bank.resize(size / 2, 0);
+            }
+
+            std::vector<Word> expected;
+            size_t expectedHits = bank.evaluate(expected, DetectorBank::KERNEL_SCALAR);
+            for (size_t i = 0; i < bank.size(); ++i) {
+                if (bitSet(expected, i) != (bank.getLevel(i) > bank.getThreshold(i))) {
+                    std::printf("scalar kernel wrong at %zu of %zu\n", i, bank.size());
+                    return false;
+                }
+            }
+            for (size_t k = 1; k < sizeof(KERNELS) / sizeof(KERNELS[0]); ++k) {
+                if (!DetectorBank::isSupported(KERNELS[k])) {
+                    continue;
+                }
+                std::vector<Word> mask;
+                size_t hits = bank.evaluate(mask, KERNELS[k]);
+                if (hits != expectedHits || mask != expected) {
+                    std::printf("%s kernel differs from scalar for %zu entries\n",
+                                DetectorBank::kernelName(KERNELS[k]), bank.size());
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 100000);
+    long passes = benchArgCount(argc, argv, 2, 1000);
+    std::printf("%ld detectors, %ld passes, default kernel %s\n\n", count, passes,
+                DetectorBank::kernelName(DetectorBank::bestKernel()));
+
+    bool consistent = checkKernels();
+    std::printf("kernel self-check: %s\n\n", consistent ? "ok" : "FAILED");
+
+    // Fleet with random sensitivities and mostly quiet levels
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+    std::cout.setstate(std::ios::failbit);
+    std::vector<Detector*> fleet;
+    DetectorBank bank;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> sensitivity(1, 10);
+    std::uniform_int_distribution<int> level(0, 100);
+    for (long i = 0; i < count; ++i) {
+        Detector* detector;
+        int value = level(rng);
+        if (i % 2 == 0) {
+            SmokeDetector* smoke = new NestSmokeDetector();
+            smoke->setSensitivity(sensitivity(rng));
+            smoke->setSmokeLevel(value);
+            detector = smoke;
+        } else {
+            GasDetector* gas = new KiddeGasDetector();
+            gas->setSensitivity(sensitivity(rng));
+            gas->setGasLevel(value);
+            detector = gas;
+        }
+        fleet.push_back(detector);
+        bank.add(detector->getThreshold(), detector->getReading());
+    }
+    std::cout.clear();
+
+    // Per object: one virtual call and a compare per detector
+    std::vector<Word> objectMask((fleet.size() + DetectorBank::WORD_BITS - 1) / DetectorBank::WORD_BITS);
+    size_t objectHits = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (long p = 0; p < passes; ++p) {
+        objectHits = 0;
+        for (size_t w = 0; w < objectMask.size(); ++w) {
+            objectMask[w] = 0;
+        }
+        for (size_t i = 0; i < fleet.size(); ++i) {
+            if (fleet[i]->getReading() > fleet[i]->getThreshold()) {
+                objectMask[i / DetectorBank::WORD_BITS] |= (Word)1 << (i % DetectorBank::WORD_BITS);
+                ++objectHits;
+            }
+        }
+    }
+    long long objectNanos = elapsedNanos(start, BenchClock::now());
+    double perObject = (double)objectNanos / ((double)passes * count);
+    std::printf("per-object getReading():  %8.3f ns/detector\n", perObject);
+
+    std::vector<Word> mask;
+    for (size_t k = 0; k < sizeof(KERNELS) / sizeof(KERNELS[0]); ++k) {
+        if (!DetectorBank::isSupported(KERNELS[k])) {
+            std::printf("DetectorBank %-7s      (not supported on this CPU)\n",
+                        DetectorBank::kernelName(KERNELS[k]));
+            continue;
+        }
+        size_t hits = 0;
+        start = BenchClock::now();
+        for (long p = 0; p < passes; ++p) {
+            hits = bank.evaluate(mask, KERNELS[k]);
+        }
+        long long nanos = elapsedNanos(start, BenchClock::now());
+        double perDetector = (double)nanos / ((double)passes * count);
+        std::printf("DetectorBank %-7s      %8.3f ns/detector  (%.1fx)\n",
+                    DetectorBank::kernelName(KERNELS[k]), perDetector, perObject / perDetector);
+        if (hits != objectHits || mask != objectMask) {
+            consistent = false;
+        }
+    }
+
+    std::printf("\n%zu of %ld detectors over threshold; results %s\n", objectHits, count,
+                consistent ? "match" : "MISMATCH");
+
+    for (size_t i = 0; i < fleet.size(); ++i) {
+        delete fleet[i];
+    }
+    return consistent ? 0 : 1;
+}
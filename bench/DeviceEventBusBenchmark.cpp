@@ -0,0 +1,190 @@
+/**
+ * @file DeviceEventBusBenchmark.cpp
+ * @brief Filtered fan-out of device events: scanning every subscriber's
+ *        filter vs. DeviceEventBus precomputed subscriber lists
+ *
+ * Usage: DeviceEventBusBenchmark [devices] [subscribers] [events]   (default 10000 / 100 / 1000000)
+ *
+ * Devices are spread over all twelve models. Each subscriber filters on a
+ * random device type (or any), brand (or any) and minimum severity. The
+ * scan baseline reads the device's type and brand once per event and tests
+ * every filter, as a plain observer list would.
+ */
+
+#include "DeviceEventBus.h"
+#include "DeviceRegistry.h"
+#include "Light.h"
+#include "Camera.h"
+#include "Television.h"
+#include "SmokeDetector.h"
+#include "GasDetector.h"
+#include "SoundSystem.h"
+#include "OutputSink.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+// Global allocation counter - every operator new in the process goes through here
+static unsigned long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+class CountingObserver : public IDeviceObserver {
+public:
+    unsigned long long events;
+    CountingObserver() : events(0) {}
+    virtual void onDeviceFailure(const std::string&, const std::string&) {}
+    virtual void onDeviceEvent(const DeviceEvent&) { ++events; }
+};
+
+// Baseline: one list, every filter tested per event
+struct ScanSubscriber {
+    IDeviceObserver* observer;
+    DeviceEventFilter filter;
+};
+
+static void scanPublish(const std::vector<ScanSubscriber>& subscribers, const DeviceEvent& event) {
+    std::string type = event.device.getDeviceType();
+    std::string brand = event.device.getBrand();
+    for (size_t i = 0; i < subscribers.size(); ++i) {
+        if (event.severity >= subscribers[i].filter.minSeverity &&
+            subscribers[i].filter.matches(type, brand)) {
+            subscribers[i].observer->onDeviceEvent(event);
+        }
+    }
+}
+
+static Device* makeDevice(long i) {
+    switch (i % 12) {
+        case 0:  return new PhilipsHueLight();
+        case 1:  return new IKEATradfriLight();
+        case 2:  return new SamsungCamera();
+        case 3:  return new XiaomiCamera();
+        case 4:  return new SamsungTV();
+        case 5:  return new LGTV();
+        case 6:  return new NestSmokeDetector();
+        case 7:  return new FirstAlertSmokeDetector();
+        case 8:  return new NestGasDetector();
+        case 9:  return new KiddeGasDetector();
+        case 10: return new SonosSoundSystem();
+        default: return new BoseSoundSystem();
+    }
+}
+
+static const DeviceKind KINDS[12] = {
+    KIND_LIGHT, KIND_LIGHT, KIND_CAMERA, KIND_CAMERA, KIND_TELEVISION, KIND_TELEVISION,
+    KIND_SMOKE_DETECTOR, KIND_SMOKE_DETECTOR, KIND_GAS_DETECTOR, KIND_GAS_DETECTOR,
+    KIND_SOUND_SYSTEM, KIND_SOUND_SYSTEM
+};
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 10000);
+    long subscriberCount = benchArgCount(argc, argv, 2, 100);
+    long events = benchArgCount(argc, argv, 3, 1000000);
+    std::printf("%ld devices, %ld subscribers, %ld events\n\n", count, subscriberCount, events);
+
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+    DeviceRegistry registry;
+    DeviceEventBus bus;
+    for (long i = 0; i < count; ++i) {
+        Device* device = makeDevice(i);
+        registry.add(device, KINDS[i % 12]);
+        bus.attach(device);
+    }
+    const std::vector<Device*>& devices = registry.getDevices();
+
+    // Filters drawn from the types and brands actually present
+    std::vector<std::string> types;
+    std::vector<std::string> brands;
+    for (long i = 0; i < 12 && i < count; ++i) {
+        types.push_back(devices[i]->getDeviceType());
+        brands.push_back(devices[i]->getBrand());
+    }
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<size_t> pickModel(0, types.size() - 1);
+    std::uniform_int_distribution<int> pickKind(0, 3);
+    std::uniform_int_distribution<int> pickSeverity(0, SEVERITY_COUNT - 1);
+
+    std::vector<CountingObserver> busObservers(subscriberCount);
+    std::vector<CountingObserver> scanObservers(subscriberCount);
+    std::vector<ScanSubscriber> scan;
+    for (long s = 0; s < subscriberCount; ++s) {
+        DeviceEventFilter filter;
+        int kind = pickKind(rng);   // 0 any, 1 type, 2 brand, 3 type + brand
+        size_t model = pickModel(rng);
+        if (kind & 1) {
+            filter.deviceType = types[model];
+        }
+        if (kind & 2) {
+            filter.brand = brands[model];
+        }
+        filter.minSeverity = (EventSeverity)pickSeverity(rng);
+
+        bus.subscribe(&busObservers[s], filter);
+        ScanSubscriber subscriber;
+        subscriber.observer = &scanObservers[s];
+        subscriber.filter = filter;
+        scan.push_back(subscriber);
+    }
+
+    std::vector<size_t> order(events);
+    std::uniform_int_distribution<size_t> pickDevice(0, devices.size() - 1);
+    for (long e = 0; e < events; ++e) {
+        order[e] = pickDevice(rng);
+    }
+
+    unsigned long long before = allocationCount;
+    BenchClock::time_point start = BenchClock::now();
+    for (long e = 0; e < events; ++e) {
+        const Device& device = *devices[order[e]];
+        scanPublish(scan, DeviceEvent(device, EVENT_FAILURE, (EventSeverity)(e % SEVERITY_COUNT),
+                                      "Device is inactive/failed"));
+    }
+    double scanNanos = (double)elapsedNanos(start, BenchClock::now()) / events;
+    double scanAllocs = (double)(allocationCount - before) / events;
+
+    before = allocationCount;
+    start = BenchClock::now();
+    for (long e = 0; e < events; ++e) {
+        devices[order[e]]->notifyFailure("Device is inactive/failed", (EventSeverity)(e % SEVERITY_COUNT));
+    }
+    double busNanos = (double)elapsedNanos(start, BenchClock::now()) / events;
+    double busAllocs = (double)(allocationCount - before) / events;
+
+    bool consistent = true;
+    for (long s = 0; s < subscriberCount; ++s) {
+        if (busObservers[s].events != scanObservers[s].events) {
+            consistent = false;
+        }
+    }
+
+    std::printf("scan all filters:  %8.1f ns/event  %6.2f allocs/event\n", scanNanos, scanAllocs);
+    std::printf("DeviceEventBus:    %8.1f ns/event  %6.2f allocs/event  (%zu routes)\n",
+                busNanos, busAllocs, bus.getRouteCount());
+    std::printf("\n%.1f deliveries per event; subscriber counts %s\n",
+                (double)bus.getDeliveredCount() / events, consistent ? "match" : "MISMATCH");
+
+    std::vector<Device*> all(devices);
+    registry.clear();
+    for (size_t i = 0; i < all.size(); ++i) {
+        delete all[i];
+    }
+    return consistent ? 0 : 1;
+}
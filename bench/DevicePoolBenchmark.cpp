@@ -0,0 +1,208 @@
+/**
+ * @file DevicePoolBenchmark.cpp
+ * @brief Slab-pooled devices vs. individually heap-allocated devices
+ *
+ * Usage: DevicePoolBenchmark [devices] [passes]   (default 200000 / 20)
+ *
+ * Measures allocation / release cost and the cost (time and, on Linux,
+ * hardware cache misses) of walking the device list the way displayStatus
+ * and the mode code do. Other allocations are interleaved with the devices
+ * to mimic a heap that has been in use for a while.
+ */
+
+#include "Light.h"
+#include "DevicePool.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+// Hardware cache-miss counter for the calling thread (no-op where unsupported)
+class CacheMissCounter {
+private:
+    int fd;
+
+public:
+    CacheMissCounter() : fd(-1) {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    bool isAvailable() const {
+        return fd >= 0;
+    }
+
+    void start() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    long long stop() {
+        long long value = 0;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+                value = 0;
+            }
+        }
+#endif
+        return value;
+    }
+};
+
+// Deterministic shuffle standing in for add/remove churn in the registry
+static void shuffle(std::vector<Device*>& devices) {
+    unsigned long long state = 0x2545F4914F6CDD1DULL;
+    for (size_t i = devices.size(); i > 1; --i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::swap(devices[i - 1], devices[state % i]);
+    }
+}
+
+static size_t walk(const std::vector<Device*>& devices) {
+    size_t on = 0;
+    for (size_t i = 0; i < devices.size(); ++i) {
+        on += devices[i]->isPoweredOn() ? 1 : 0;
+        on += devices[i]->isActive() ? 1 : 0;
+    }
+    return on;
+}
+
+static void reportWalk(const char* label, const std::vector<Device*>& devices, long passes,
+                       CacheMissCounter& counter) {
+    size_t sink = 0;
+    counter.start();
+    BenchClock::time_point start = BenchClock::now();
+    for (long p = 0; p < passes; ++p) {
+        sink += walk(devices);
+    }
+    BenchClock::time_point end = BenchClock::now();
+    long long misses = counter.stop();
+
+    double visits = (double)devices.size() * passes;
+    std::printf("%-30s %8.2f ns/device", label, elapsedNanos(start, end) / visits);
+    if (counter.isAvailable()) {
+        std::printf("  %6.3f cache misses/device", misses / visits);
+    }
+    std::printf("   (%zu)\n", sink);
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 200000);
+    long passes = benchArgCount(argc, argv, 2, 20);
+    std::printf("%ld PhilipsHueLight objects, %ld passes over the list\n", count, passes);
+
+    CacheMissCounter counter;
+    if (!counter.isAvailable()) {
+        std::printf("(hardware cache-miss counter unavailable, reporting time only)\n");
+    }
+    std::printf("\n");
+
+    std::vector<void*> fillers;
+    fillers.reserve(count);
+    unsigned int seed = 12345;
+
+    // --- Plain heap: one malloc per device, other allocations in between ---
+    {
+        std::vector<Device*> devices;
+        devices.reserve(count);
+
+        BenchClock::time_point start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            void* memory = std::malloc(sizeof(PhilipsHueLight));
+            devices.push_back(::new (memory) PhilipsHueLight());
+            seed = seed * 1103515245u + 12345u;
+            fillers.push_back(std::malloc(16 + (seed >> 16) % 512));
+        }
+        BenchClock::time_point end = BenchClock::now();
+        std::printf("%-30s %8.2f ns/device\n", "heap: construct", (double)elapsedNanos(start, end) / count);
+
+        reportWalk("heap: walk in order", devices, passes, counter);
+        shuffle(devices);
+        reportWalk("heap: walk after churn", devices, passes, counter);
+
+        start = BenchClock::now();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            devices[i]->~Device();
+            std::free(devices[i]);
+        }
+        end = BenchClock::now();
+        std::printf("%-30s %8.2f ns/device\n\n", "heap: destroy", (double)elapsedNanos(start, end) / count);
+
+        for (size_t i = 0; i < fillers.size(); ++i) {
+            std::free(fillers[i]);
+        }
+        fillers.clear();
+    }
+
+    // --- Slab pool: class operator new, same interleaved allocations ---
+    {
+        std::vector<Device*> devices;
+        devices.reserve(count);
+
+        BenchClock::time_point start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            devices.push_back(new PhilipsHueLight());
+            seed = seed * 1103515245u + 12345u;
+            fillers.push_back(std::malloc(16 + (seed >> 16) % 512));
+        }
+        BenchClock::time_point end = BenchClock::now();
+        std::printf("%-30s %8.2f ns/device\n", "pool: construct", (double)elapsedNanos(start, end) / count);
+
+        reportWalk("pool: walk in order", devices, passes, counter);
+        shuffle(devices);
+        reportWalk("pool: walk after churn", devices, passes, counter);
+
+        std::printf("\n");
+        DevicePool::printStats();
+        std::printf("\n");
+
+        start = BenchClock::now();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            delete devices[i];
+        }
+        size_t released = DevicePool::trimAll();
+        end = BenchClock::now();
+        std::printf("%-30s %8.2f ns/device  (%zu KB released)\n", "pool: destroy + trim",
+                    (double)elapsedNanos(start, end) / count, released / 1024);
+
+        for (size_t i = 0; i < fillers.size(); ++i) {
+            std::free(fillers[i]);
+        }
+    }
+    return 0;
+}
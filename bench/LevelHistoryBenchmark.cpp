@@ -0,0 +1,248 @@
+/**
+ * @file LevelHistoryBenchmark.cpp
+ * @brief Detector level history: ingest cost, compression, memory bound,
+ *        query and save/load time
+ *
+ * Usage: LevelHistoryBenchmark [detectors] [readingsPerDetector]   (default 1000 / 20000)
+ *
+ * Every detector reports about once a second (a fifth of the readings are a
+ * few ms early or late) with a slowly wandering level. The readings go
+ * through SensorPipeline with and without a LevelHistory attached. For a few
+ * detectors every reading is also kept in a plain vector, and the retained
+ * raw samples and all rollup buckets are checked against it, before and
+ * after a save/load round trip. Exits with 1 on any mismatch.
+ */
+
+#include "LevelHistory.h"
+#include "SensorPipeline.h"
+#include "DeviceRegistry.h"
+#include "SmokeDetector.h"
+#include "GasDetector.h"
+#include "OutputSink.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+static const size_t CHECKED = 8;   // Detectors with a reference copy
+static const long long ALL_TIME = 1LL << 62;
+
+struct Fleet {
+    DeviceRegistry registry;
+    SensorPipeline pipeline;
+    LevelHistory history;
+
+    Fleet(long count, bool withHistory) {
+        for (long i = 0; i < count; ++i) {
+            Detector* detector;
+            if (i % 2 == 0) {
+                detector = new NestSmokeDetector();
+                registry.add(detector, KIND_SMOKE_DETECTOR);
+            } else {
+                detector = new KiddeGasDetector();
+                registry.add(detector, KIND_GAS_DETECTOR);
+            }
+            if (withHistory) {
+                history.attach(detector);
+            }
+            pipeline.attach(detector);
+        }
+    }
+
+    ~Fleet() {
+        std::vector<Device*> all(registry.getDevices());
+        for (size_t i = 0; i < all.size(); ++i) {
+            pipeline.detach(static_cast<Detector*>(all[i]));
+            history.detach(static_cast<Detector*>(all[i]));
+        }
+        registry.clear();
+        for (size_t i = 0; i < all.size(); ++i) {
+            delete all[i];
+        }
+    }
+};
+
+static std::vector<SensorReading> makeReadings(const Fleet& fleet, long perDetector) {
+    const std::vector<Device*>& devices = fleet.registry.getDevices();
+    std::vector<SensorReading> readings;
+    readings.reserve(devices.size() * (size_t)perDetector);
+    std::vector<int> level(devices.size(), 10);
+    std::mt19937 rng(24);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> jitter(-3000, 3000);
+    std::uniform_int_distribution<int> step(-3, 3);
+    long long start = 1700000000000000LL;
+    for (long s = 0; s < perDetector; ++s) {
+        for (size_t d = 0; d < devices.size(); ++d) {
+            if (percent(rng) < 20) {
+                level[d] = std::max(0, std::min(100, level[d] + step(rng)));
+            }
+            SensorReading reading;
+            reading.detectorId = devices[d]->getDeviceId();
+            reading.level = level[d];
+            reading.timestamp = start + s * 1000000LL + (long long)d * 997 +
+                                (percent(rng) < 20 ? jitter(rng) : 0);
+            readings.push_back(reading);
+        }
+    }
+    return readings;
+}
+
+// Retained samples must be the tail of the reference, every rollup bucket must match
+static bool checkSeries(const LevelSeries& series, const std::vector<LevelSample>& reference) {
+    std::vector<LevelSample> samples;
+    series.getSamples(-ALL_TIME, ALL_TIME, samples);
+    if (samples.size() != series.getSampleCount() || samples.size() > reference.size() ||
+        series.getTotalCount() != reference.size()) {
+        return false;
+    }
+    size_t offset = reference.size() - samples.size();
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (samples[i].timestamp != reference[offset + i].timestamp ||
+            samples[i].level != reference[offset + i].level) {
+            return false;
+        }
+    }
+    for (int r = 0; r < LevelSeries::ROLLUP_COUNT; ++r) {
+        long long period = LevelSeries::periodOf((LevelSeries::Resolution)r);
+        std::vector<LevelRollup> rollups;
+        series.getRollups((LevelSeries::Resolution)r, -ALL_TIME, ALL_TIME, rollups);
+        for (size_t b = 0; b < rollups.size(); ++b) {
+            int low = 101;
+            int high = -1;
+            long long sum = 0;
+            unsigned count = 0;
+            for (size_t i = 0; i < reference.size(); ++i) {
+                if (reference[i].timestamp / period * period == rollups[b].start) {
+                    low = std::min(low, reference[i].level);
+                    high = std::max(high, reference[i].level);
+                    sum += reference[i].level;
+                    ++count;
+                }
+            }
+            if (count != rollups[b].count || low != rollups[b].min || high != rollups[b].max ||
+                (double)sum / count != rollups[b].avg) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 1000);
+    long perDetector = benchArgCount(argc, argv, 2, 20000);
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+
+    Fleet plain(count, false);
+    Fleet recorded(count, true);
+    std::vector<SensorReading> readings = makeReadings(recorded, perDetector);
+    size_t total = readings.size();
+    std::printf("%ld detectors, %zu readings\n\n", count, total);
+
+    // Reference copies for the first detectors (timestamps as the series stores them)
+    std::vector<std::vector<LevelSample> > reference(CHECKED);
+    for (size_t r = 0; r < total; ++r) {
+        size_t d = (size_t)(readings[r].detectorId - readings[0].detectorId);
+        if (d < CHECKED) {
+            LevelSample sample;
+            sample.level = readings[r].level;
+            sample.timestamp = reference[d].empty() ? readings[r].timestamp
+                               : std::max(readings[r].timestamp, reference[d].back().timestamp);
+            reference[d].push_back(sample);
+        }
+    }
+
+    std::cout.setstate(std::ios::failbit);
+    const size_t batch = 4096;
+    BenchClock::time_point start = BenchClock::now();
+    for (size_t r = 0; r < total; r += batch) {
+        plain.pipeline.ingest(&readings[r], std::min(batch, total - r));
+    }
+    long long plainNanos = elapsedNanos(start, BenchClock::now());
+    start = BenchClock::now();
+    for (size_t r = 0; r < total; r += batch) {
+        recorded.pipeline.ingest(&readings[r], std::min(batch, total - r));
+    }
+    long long recordedNanos = elapsedNanos(start, BenchClock::now());
+    std::cout.clear();
+
+    std::printf("pipeline without history: %8.2f ns/reading\n", (double)plainNanos / total);
+    std::printf("pipeline with history:    %8.2f ns/reading  (+%.2f ns)\n\n",
+                (double)recordedNanos / total, (double)(recordedNanos - plainNanos) / total);
+
+    const std::vector<Device*>& devices = recorded.registry.getDevices();
+    size_t retained = 0;
+    size_t encoded = 0;
+    size_t maxMemory = 0;
+    for (size_t d = 0; d < devices.size(); ++d) {
+        const LevelSeries* series = recorded.history.find(devices[d]->getDeviceId());
+        retained += series->getSampleCount();
+        encoded += series->getEncodedBytes();
+        maxMemory = std::max(maxMemory, series->getMemoryBytes());
+    }
+    std::printf("retained raw samples:     %zu of %zu (%.1f%%)\n", retained, total, 100.0 * retained / total);
+    std::printf("encoded size:             %.2f bytes/sample (%.1fx smaller than 12 byte time+level)\n",
+                (double)encoded / retained, 12.0 * retained / encoded);
+    std::printf("memory per detector:      %zu bytes max, %zu bytes for the whole history\n\n",
+                maxMemory, recorded.history.getMemoryBytes());
+
+    // Queries: last 10 minutes of raw samples, last hour in 1m rollups
+    const LevelSeries* first = recorded.history.find(devices[0]->getDeviceId());
+    std::vector<LevelSample> samples;
+    std::vector<LevelRollup> rollups;
+    LevelRollup summary;
+    const int queries = 1000;
+    start = BenchClock::now();
+    for (int q = 0; q < queries; ++q) {
+        samples.clear();
+        first->getSamples(first->getLastTime() - 600 * 1000000LL, first->getLastTime(), samples);
+    }
+    double rawMicros = elapsedNanos(start, BenchClock::now()) / 1e3 / queries;
+    start = BenchClock::now();
+    for (int q = 0; q < queries; ++q) {
+        rollups.clear();
+        first->getRollups(LevelSeries::ROLLUP_1M, first->getLastTime() - 3600 * 1000000LL,
+                          first->getLastTime(), rollups);
+        first->summarize(LevelSeries::ROLLUP_1M, first->getLastTime() - 3600 * 1000000LL,
+                         first->getLastTime(), summary);
+    }
+    double rollupMicros = elapsedNanos(start, BenchClock::now()) / 1e3 / queries;
+    std::printf("query last 10 min raw:    %8.2f us (%zu samples)\n", rawMicros, samples.size());
+    std::printf("query last hour at 1m:    %8.2f us (%zu buckets, avg %.1f%%)\n\n",
+                rollupMicros, rollups.size(), summary.avg);
+
+    bool consistent = true;
+    for (size_t d = 0; d < CHECKED && d < devices.size(); ++d) {
+        consistent = consistent && checkSeries(*recorded.history.find(devices[d]->getDeviceId()), reference[d]);
+    }
+
+    // Save, then load into a fresh fleet with the same device IDs
+    const char* path = "bench_levels.bin";
+    start = BenchClock::now();
+    bool saved = recorded.history.save(path);
+    double saveMillis = elapsedMillis(start, BenchClock::now());
+    long fileSize = 0;
+    if (FILE* f = std::fopen(path, "rb")) {
+        std::fseek(f, 0, SEEK_END);
+        fileSize = std::ftell(f);
+        std::fclose(f);
+    }
+    Fleet reloaded(count, true);
+    size_t restored = 0;
+    start = BenchClock::now();
+    bool loaded = reloaded.history.load(path, restored);
+    double loadMillis = elapsedMillis(start, BenchClock::now());
+    std::remove(path);
+    std::printf("save:                     %8.2f ms, %ld bytes\n", saveMillis, fileSize);
+    std::printf("load:                     %8.2f ms, %zu series restored\n", loadMillis, restored);
+
+    consistent = consistent && saved && loaded && restored == devices.size();
+    const std::vector<Device*>& again = reloaded.registry.getDevices();
+    for (size_t d = 0; consistent && d < CHECKED && d < again.size(); ++d) {
+        consistent = checkSeries(*reloaded.history.find(again[d]->getDeviceId()), reference[d]);
+    }
+
+    std::printf("\nresults %s\n", consistent ? "match" : "MISMATCH");
+    return consistent ? 0 : 1;
+}
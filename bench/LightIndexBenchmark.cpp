@@ -0,0 +1,82 @@
+/**
+ * @file LightIndexBenchmark.cpp
+ * @brief Regression check: adding lights one by one must stay linear
+ *
+ * Usage: LightIndexBenchmark [lights] [legacyLights]   (default 100000 / 10000)
+ *
+ * The old full rebuild of lightPtrs is quadratic, so it runs on a smaller set.
+ */
+
+#include "HomeController.h"
+#include "DeviceRegistry.h"
+#include "Light.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <vector>
+
+static void report(const char* label, long count, BenchClock::time_point start, BenchClock::time_point end) {
+    std::printf("%-34s %10.2f ms  %8.1f ns/op\n", label,
+                elapsedMillis(start, end), (double)elapsedNanos(start, end) / count);
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 100000);
+    long legacyCount = benchArgCount(argc, argv, 2, 10000);
+    std::printf("Adding lights one at a time\n\n");
+
+    // --- Old behaviour: every add rebuilt the whole light index with dynamic_cast ---
+    {
+        std::vector<Device*> lights;
+        std::vector<Light*> lightPtrs;
+
+        BenchClock::time_point start = BenchClock::now();
+        for (long i = 0; i < legacyCount; ++i) {
+            lights.push_back(new PhilipsHueLight());
+            lightPtrs.clear();
+            for (size_t j = 0; j < lights.size(); ++j) {
+                Light* light = dynamic_cast<Light*>(lights[j]);
+                if (light) {
+                    lightPtrs.push_back(light);
+                }
+            }
+        }
+        BenchClock::time_point end = BenchClock::now();
+        std::printf("(old rebuild uses %ld lights)\n", legacyCount);
+        report("rebuild on every add", legacyCount, start, end);
+        std::printf("\n");
+
+        for (size_t i = 0; i < lights.size(); ++i) {
+            delete lights[i];
+        }
+    }
+
+    // --- HomeController::addLight with the incremental index ---
+    {
+        HomeController* home = new HomeController();
+        size_t before = home->getDeviceRegistry().size(KIND_LIGHT);
+
+        BenchClock::time_point start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            home->addLight(i % 2 == 0 ? 1 : 2);
+        }
+        BenchClock::time_point end = BenchClock::now();
+        report("HomeController::addLight", count, start, end);
+
+        // Second half should cost the same as the first if adds are O(1)
+        start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            home->addLight(1);
+        }
+        end = BenchClock::now();
+        report("HomeController::addLight (2nd)", count, start, end);
+
+        size_t added = home->getDeviceRegistry().size(KIND_LIGHT) - before;
+        delete home;
+
+        if (added != (size_t)count * 2) {
+            std::printf("[ERROR] expected %ld new lights, registry has %zu\n", count * 2, added);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file LogBenchmark.cpp
+ * @brief Per-call latency of Storage::logDeviceOperation, sync vs. async mode
+ *
+ * Usage: LogBenchmark [calls]   (default 1000000)
+ */
+
+#include "Storage.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <fstream>
+
+static long fileSize(const std::string& path) {
+    std::ifstream in(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    return in.is_open() ? (long)in.tellg() : 0;
+}
+
+static void runMode(Storage* storage, const char* label, const char* file, long calls) {
+    std::vector<long long> samples;
+    samples.reserve(calls);
+
+    std::string binFile = Storage::eventLogFilename(file);
+    std::remove(file);
+    std::remove(binFile.c_str());
+    storage->openFile(file);
+
+    const std::string device = "Philips Hue White A19";
+    const std::string operation = "Powered ON";
+
+    BenchClock::time_point begin = BenchClock::now();
+    for (long i = 0; i < calls; ++i) {
+        BenchClock::time_point start = BenchClock::now();
+        storage->logDeviceOperation(device, operation);
+        samples.push_back(elapsedNanos(start, BenchClock::now()));
+    }
+    BenchClock::time_point enqueued = BenchClock::now();
+    storage->flush();
+    BenchClock::time_point flushed = BenchClock::now();
+    storage->closeFile();
+
+    printPercentiles(label, samples);
+    std::printf("%-28s total=%.1f ms (calls) + %.1f ms (final flush)\n", "",
+                elapsedMillis(begin, enqueued), elapsedMillis(enqueued, flushed));
+    std::printf("%-28s bytes/event: text=%.1f binary=%.1f\n", "",
+                (double)fileSize(file) / calls, (double)fileSize(binFile) / calls);
+    std::remove(file);
+    std::remove(binFile.c_str());
+}
+
+int main(int argc, char** argv) {
+    long calls = benchArgCount(argc, argv, 1, 1000000);
+    Storage* storage = Storage::getInstance();
+
+    std::printf("Storage::logDeviceOperation x %ld\n", calls);
+
+    storage->disableAsync();
+    runMode(storage, "sync", "bench_log_sync.txt", calls);
+
+    storage->enableAsync();
+    runMode(storage, "async (batch 256, 50 ms)", "bench_log_async.txt", calls);
+
+    storage->enableAsync(4096, 200, 65536);
+    runMode(storage, "async (batch 4096, 200 ms)", "bench_log_async.txt", calls);
+
+    storage->disableAsync();
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file MementoBenchmark.cpp
+ * @brief Name-keyed map mementos vs. keyframe + delta mementos
+ *
+ * Usage: MementoBenchmark [devices] [snapshots] [changesPerSnapshot] [historyCapacity]
+ *        (default 10000 / 500 / 10 / 50)
+ *
+ * Between snapshots a few random devices flip. The map baseline is the
+ * previous HomeMemento layout (one std::map<std::string,bool> node per
+ * device, held in a vector that is erased from the front once full);
+ * device names get an ID suffix so every device has its own entry, as on
+ * a real site.
+ */
+
+#include "StateManager.h"
+#include "DeviceRegistry.h"
+#include "OutputSink.h"
+#include "Light.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <map>
+#include <random>
+#include <sstream>
+
+typedef std::map<std::string, bool> LegacyMemento;
+
+static std::vector<std::string> uniqueNames(const std::vector<Device*>& devices) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < devices.size(); ++i) {
+        std::ostringstream oss;
+        oss << devices[i]->getName() << " #" << devices[i]->getDeviceId();
+        names.push_back(oss.str());
+    }
+    return names;
+}
+
+static void flipRandom(const std::vector<Device*>& devices, long changes, std::mt19937& rng) {
+    std::uniform_int_distribution<size_t> pick(0, devices.size() - 1);
+    for (long c = 0; c < changes; ++c) {
+        Device* device = devices[pick(rng)];
+        if (device->isPoweredOn()) {
+            device->powerOff();
+        } else {
+            device->powerOn();
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 10000);
+    long snapshots = benchArgCount(argc, argv, 2, 500);
+    long changes = benchArgCount(argc, argv, 3, 10);
+    size_t capacity = (size_t)benchArgCount(argc, argv, 4, 50);
+    std::printf("%ld devices, %ld snapshots, %ld flips between snapshots, history of %zu\n\n",
+                count, snapshots, changes, capacity);
+
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+    DeviceRegistry registry;
+    for (long i = 0; i < count; ++i) {
+        registry.add(new PhilipsHueLight(), KIND_LIGHT);
+    }
+    const std::vector<Device*>& devices = registry.getDevices();
+    std::vector<std::string> names = uniqueNames(devices);
+
+    // Map baseline
+    std::mt19937 rng(42);
+    std::vector<LegacyMemento*> legacy;
+    long long legacyNanos = 0;
+    for (long s = 0; s < snapshots; ++s) {
+        flipRandom(devices, changes, rng);
+        BenchClock::time_point start = BenchClock::now();
+        LegacyMemento* memento = new LegacyMemento();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            (*memento)[names[i]] = devices[i]->isPoweredOn();
+        }
+        if (legacy.size() >= capacity) {
+            delete legacy.front();
+            legacy.erase(legacy.begin());
+        }
+        legacy.push_back(memento);
+        legacyNanos += elapsedNanos(start, BenchClock::now());
+    }
+    // Node = std::string key + bool + red-black tree links (about 32 bytes)
+    size_t legacyBytes = 0;
+    for (size_t m = 0; m < legacy.size(); ++m) {
+        legacyBytes += sizeof(LegacyMemento);
+        for (LegacyMemento::const_iterator it = legacy[m]->begin(); it != legacy[m]->end(); ++it) {
+            legacyBytes += sizeof(LegacyMemento::value_type) + 32 + it->first.capacity();
+        }
+    }
+
+    // Keyframes + deltas
+    rng.seed(42);
+    StateManager manager(capacity);
+    long long deltaNanos = 0;
+    bool consistent = true;
+    for (long s = 0; s < snapshots; ++s) {
+        flipRandom(devices, changes, rng);
+        BenchClock::time_point start = BenchClock::now();
+        manager.saveState("Normal", devices);
+        deltaNanos += elapsedNanos(start, BenchClock::now());
+
+        // Self-check outside the timed region
+        if (s % 50 == 49 || s == snapshots - 1) {
+            PowerSnapshot snapshot;
+            manager.getSnapshot(manager.getHistorySize() - 1, snapshot);
+            for (size_t i = 0; i < devices.size(); ++i) {
+                if (snapshot.isPowered(devices[i]->getDeviceId()) != devices[i]->isPoweredOn()) {
+                    consistent = false;
+                }
+            }
+        }
+    }
+
+    std::printf("map mementos:   %9.2f us per snapshot  %10zu bytes for %zu snapshots\n",
+                legacyNanos / 1e3 / snapshots, legacyBytes, legacy.size());
+    std::printf("delta mementos: %9.2f us per snapshot  %10zu bytes for %d snapshots\n",
+                deltaNanos / 1e3 / snapshots, manager.getHistoryMemoryUsage(), manager.getHistorySize());
+    std::printf("\nreconstruction %s\n", consistent ? "matches device state" : "MISMATCH");
+
+    for (size_t m = 0; m < legacy.size(); ++m) {
+        delete legacy[m];
+    }
+    std::vector<Device*> all(devices);
+    registry.clear();
+    for (size_t i = 0; i < all.size(); ++i) {
+        delete all[i];
+    }
+    return consistent ? 0 : 1;
+}
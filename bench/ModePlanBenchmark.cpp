@@ -0,0 +1,142 @@
+/**
+ * @file ModePlanBenchmark.cpp
+ * @brief Blind per-device mode application vs. the diff-based mode plans
+ *
+ * Usage: ModePlanBenchmark [devicesPerKind] [rounds]   (default 20000 / 20)
+ *
+ * The blind loop is what the modes used to do: power every device of every
+ * group and dynamic_cast each light / sound system for its settings.
+ * Console output goes to the null device in verbose mode, so the cost of
+ * the "already ON/OFF" lines the blind loop prints is part of the result.
+ */
+
+#include "ModeManager.h"
+#include "DeviceRegistry.h"
+#include "OutputSink.h"
+#include "Light.h"
+#include "Television.h"
+#include "SoundSystem.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+static const char* NULL_DEVICE = "NUL";
+#else
+static const char* NULL_DEVICE = "/dev/null";
+#endif
+
+static void setAll(const std::vector<Device*>& devices, bool on) {
+    for (size_t i = 0; i < devices.size(); ++i) {
+        if (on) {
+            devices[i]->powerOn();
+        } else {
+            devices[i]->powerOff();
+        }
+    }
+}
+
+// The pre-plan implementation of ModeState::apply
+static void applyBlind(const ModeState* mode, const DeviceRegistry& registry) {
+    const ModePlan& plan = mode->getPlan();
+    const std::vector<Device*>& lights = registry.getDevices(KIND_LIGHT);
+    const std::vector<Device*>& sounds = registry.getDevices(KIND_SOUND_SYSTEM);
+
+    setAll(lights, plan.targets[ModePlan::GROUP_LIGHT].power);
+    if (!plan.targets[ModePlan::GROUP_LIGHT].color.empty()) {
+        for (size_t i = 0; i < lights.size(); ++i) {
+            Light* light = dynamic_cast<Light*>(lights[i]);
+            if (light) {
+                light->setColor(plan.targets[ModePlan::GROUP_LIGHT].color);
+            }
+        }
+    }
+    setAll(registry.getDevices(KIND_TELEVISION), plan.targets[ModePlan::GROUP_TV].power);
+    setAll(sounds, plan.targets[ModePlan::GROUP_SOUND].power);
+    if (plan.targets[ModePlan::GROUP_SOUND].playMusic) {
+        for (size_t i = 0; i < sounds.size(); ++i) {
+            SoundSystem* ss = dynamic_cast<SoundSystem*>(sounds[i]);
+            if (ss) {
+                ss->playMusic();
+            }
+        }
+    }
+}
+
+struct Scenario {
+    const char* label;
+    char from;
+    char to;
+};
+
+int main(int argc, char** argv) {
+    long perKind = benchArgCount(argc, argv, 1, 20000);
+    long rounds = benchArgCount(argc, argv, 2, 20);
+    std::printf("%ld lights + %ld TVs + %ld sound systems, %ld round trips per scenario\n\n",
+                perKind, perKind, perKind, rounds);
+
+    DeviceRegistry registry;
+    for (long i = 0; i < perKind; ++i) {
+        registry.add(new PhilipsHueLight(), KIND_LIGHT);
+        registry.add(new SamsungTV(), KIND_TELEVISION);
+        registry.add(new SonosSoundSystem(), KIND_SOUND_SYSTEM);
+    }
+
+    std::ofstream nullDevice(NULL_DEVICE);
+    std::streambuf* original = std::cout.rdbuf(nullDevice.rdbuf());
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_VERBOSE);
+
+    const Scenario scenarios[] = {
+        { "Cinema -> Cinema (nothing changes)", 'C', 'C' },
+        { "Normal <-> Evening (lights only)", 'N', 'E' },
+        { "Party <-> Cinema (everything)", 'P', 'C' }
+    };
+    const int scenarioCount = sizeof(scenarios) / sizeof(scenarios[0]);
+    double blindMillis[scenarioCount];
+    double planMillis[scenarioCount];
+    size_t transitions[scenarioCount];
+
+    ModeManager modes;
+    for (int s = 0; s < scenarioCount; ++s) {
+        // Blind loop
+        modes.setMode(scenarios[s].to);
+        modes.applyMode(registry);
+        BenchClock::time_point start = BenchClock::now();
+        for (long r = 0; r < rounds; ++r) {
+            modes.setMode(scenarios[s].from);
+            applyBlind(modes.getCurrentMode(), registry);
+            modes.setMode(scenarios[s].to);
+            applyBlind(modes.getCurrentMode(), registry);
+        }
+        blindMillis[s] = elapsedMillis(start, BenchClock::now());
+
+        // Compiled plans
+        transitions[s] = 0;
+        start = BenchClock::now();
+        for (long r = 0; r < rounds; ++r) {
+            modes.setMode(scenarios[s].from);
+            transitions[s] += modes.applyMode(registry);
+            modes.setMode(scenarios[s].to);
+            transitions[s] += modes.applyMode(registry);
+        }
+        planMillis[s] = elapsedMillis(start, BenchClock::now());
+    }
+
+    std::cout.rdbuf(original);
+
+    double applications = rounds * 2.0;
+    for (int s = 0; s < scenarioCount; ++s) {
+        std::printf("%s\n", scenarios[s].label);
+        std::printf("  blind: %9.3f ms per mode change\n", blindMillis[s] / applications);
+        std::printf("  plan:  %9.3f ms per mode change  (%.0f transitions each)\n",
+                    planMillis[s] / applications, transitions[s] / applications);
+    }
+
+    std::vector<Device*> devices(registry.getDevices());
+    registry.clear();
+    for (size_t i = 0; i < devices.size(); ++i) {
+        delete devices[i];
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file NotificationBenchmark.cpp
+ * @brief Device::notifyFailure latency and notification volume, synchronous
+ *        strategies vs. the coalescing, rate-limited dispatch queues
+ *
+ * Usage: NotificationBenchmark [devices] [rounds] [smsLatencyMs]   (default 50 / 3 / 20)
+ *
+ * Every round each failed device reports a failure once, as when a mode is
+ * applied to a house full of failed devices. Log, alarm and SMS are all
+ * enabled; the stub SMS gateway sleeps for the given latency per message.
+ * The synchronous baseline calls the strategies in turn on the failing
+ * thread, as NotificationSystem used to. Notification text is suppressed
+ * while timing.
+ */
+
+#include "NotificationSystem.h"
+#include "DeviceRegistry.h"
+#include "DeviceEventBus.h"
+#include "Light.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <iostream>
+
+// The previous observer: every strategy runs on the thread that raised the failure
+class SyncNotifier : public IDeviceObserver {
+private:
+    std::vector<NotificationStrategy*> strategies;
+public:
+    unsigned long long sent;
+    SyncNotifier() : sent(0) {}
+    void add(NotificationStrategy* strategy) { strategies.push_back(strategy); }
+    virtual void onDeviceFailure(const std::string& deviceName, const std::string& message) {
+        for (size_t i = 0; i < strategies.size(); ++i) {
+            strategies[i]->notify(deviceName, message);
+            ++sent;
+        }
+    }
+};
+
+static void runFailures(const std::vector<Device*>& devices, long rounds, std::vector<long long>& samples) {
+    samples.clear();
+    for (long r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < devices.size(); ++i) {
+            BenchClock::time_point start = BenchClock::now();
+            devices[i]->notifyFailure("Device is inactive/failed");
+            samples.push_back(elapsedNanos(start, BenchClock::now()));
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 50);
+    long rounds = benchArgCount(argc, argv, 2, 3);
+    int latency = (int)benchArgCount(argc, argv, 3, 20);
+    std::printf("%ld failed devices, %ld rounds, SMS gateway latency %d ms\n\n", count, rounds, latency);
+
+    DeviceRegistry registry;
+    DeviceEventBus bus;
+    for (long i = 0; i < count; ++i) {
+        Device* device = new PhilipsHueLight();
+        registry.add(device, KIND_LIGHT);
+        bus.attach(device);
+    }
+    const std::vector<Device*>& devices = registry.getDevices();
+    std::vector<long long> syncSamples;
+    std::vector<long long> asyncSamples;
+
+    std::cout.setstate(std::ios::failbit);
+
+    StubSmsGateway gateway;
+    gateway.setLatency(latency);
+    LogNotification log;
+    AlarmNotification alarm;
+    SMSNotification sms(&gateway);
+    SyncNotifier sync;
+    sync.add(&log);
+    sync.add(&alarm);
+    sync.add(&sms);
+    bus.subscribe(&sync);
+    BenchClock::time_point start = BenchClock::now();
+    runFailures(devices, rounds, syncSamples);
+    double syncMillis = elapsedMillis(start, BenchClock::now());
+
+    NotificationSystem* system = new NotificationSystem();
+    system->getSmsGateway()->setLatency(latency);
+    system->enableAlarm(true);
+    system->enableSMS(true);
+    bus.unsubscribeAll(&sync);
+    bus.subscribe(system);
+    start = BenchClock::now();
+    runFailures(devices, rounds, asyncSamples);
+    double postMillis = elapsedMillis(start, BenchClock::now());
+    system->flush();
+    double drainMillis = elapsedMillis(start, BenchClock::now());
+    unsigned long long smsSent = system->getSmsGateway()->getSentCount();
+    bus.unsubscribeAll(system);
+
+    std::cout.clear();
+    printPercentiles("synchronous strategies", syncSamples);
+    printPercentiles("dispatch queues", asyncSamples);
+    std::printf("\nsynchronous: %9.2f ms for all failures, %llu notifications, %llu SMS\n",
+                syncMillis, sync.sent, gateway.getSentCount());
+    std::printf("queued:      %9.2f ms to post, %.2f ms until every channel drained, %llu SMS\n\n",
+                postMillis, drainMillis, smsSent);
+    system->displayStatus();
+
+    delete system;
+    std::vector<Device*> all(devices);
+    registry.clear();
+    for (size_t i = 0; i < all.size(); ++i) {
+        delete all[i];
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file OutputSinkBenchmark.cpp
+ * @brief Mode application time with the verbose, buffered and silent output sinks
+ *
+ * Usage: OutputSinkBenchmark [devicesPerKind] [rounds]   (default 2000 / 10)
+ *
+ * Console output is sent to the null device so the terminal does not skew
+ * the result; every std::endl still costs a write system call.
+ */
+
+#include "ModeManager.h"
+#include "DeviceRegistry.h"
+#include "OutputSink.h"
+#include "Light.h"
+#include "Television.h"
+#include "SoundSystem.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+static const char* NULL_DEVICE = "NUL";
+#else
+static const char* NULL_DEVICE = "/dev/null";
+#endif
+
+int main(int argc, char** argv) {
+    long perKind = benchArgCount(argc, argv, 1, 2000);
+    long rounds = benchArgCount(argc, argv, 2, 10);
+    std::printf("%ld lights + %ld TVs + %ld sound systems, %ld x (Party, Cinema)\n\n",
+                perKind, perKind, perKind, rounds);
+
+    DeviceRegistry registry;
+    for (long i = 0; i < perKind; ++i) {
+        registry.add(new PhilipsHueLight(), KIND_LIGHT);
+        registry.add(new SamsungTV(), KIND_TELEVISION);
+        registry.add(new SonosSoundSystem(), KIND_SOUND_SYSTEM);
+    }
+
+    std::ofstream nullDevice(NULL_DEVICE);
+    std::streambuf* original = std::cout.rdbuf(nullDevice.rdbuf());
+
+    ModeManager modes;
+    OutputSink* sink = OutputSink::getInstance();
+    const OutputSink::Mode sinkModes[] = {
+        OutputSink::OUTPUT_VERBOSE, OutputSink::OUTPUT_BUFFERED, OutputSink::OUTPUT_SILENT
+    };
+    double millis[3];
+
+    for (int m = 0; m < 3; ++m) {
+        sink->setMode(sinkModes[m]);
+        BenchClock::time_point start = BenchClock::now();
+        for (long r = 0; r < rounds; ++r) {
+            modes.setMode('P');
+            modes.applyMode(registry);
+            modes.setMode('C');
+            modes.applyMode(registry);
+        }
+        millis[m] = elapsedMillis(start, BenchClock::now());
+    }
+
+    std::cout.rdbuf(original);
+    sink->setMode(OutputSink::OUTPUT_VERBOSE);
+
+    double applications = rounds * 2.0;
+    for (int m = 0; m < 3; ++m) {
+        std::printf("%-10s %10.2f ms total  %8.3f ms per mode change\n",
+                    OutputSink::modeName(sinkModes[m]), millis[m], millis[m] / applications);
+    }
+
+    std::vector<Device*> devices(registry.getDevices());
+    registry.clear();
+    for (size_t i = 0; i < devices.size(); ++i) {
+        delete devices[i];
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file RegistryBenchmark.cpp
+ * @brief Add / lookup / remove cost of DeviceRegistry vs. the old per-type vectors
+ *
+ * Usage: RegistryBenchmark [devices] [legacyDevices]   (default 100000 / 20000)
+ *
+ * The old layout is quadratic on removal, so it runs on a smaller set by default.
+ */
+
+#include "DeviceRegistry.h"
+#include "Light.h"
+#include "Camera.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+// Simple deterministic shuffle so every run removes in the same order
+static void shuffle(std::vector<Device*>& devices) {
+    unsigned long long state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = devices.size(); i > 1; --i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::swap(devices[i - 1], devices[state % i]);
+    }
+}
+
+static void report(const char* label, long count, BenchClock::time_point start, BenchClock::time_point end) {
+    std::printf("%-34s %10.2f ms  %8.1f ns/op\n", label,
+                elapsedMillis(start, end), (double)elapsedNanos(start, end) / count);
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 100000);
+    long legacyCount = std::min(count, benchArgCount(argc, argv, 2, 20000));
+    std::printf("Device registry with %ld devices (removal in random order)\n\n", count);
+
+    std::vector<Device*> devices;
+    devices.reserve(count);
+    for (long i = 0; i < count; ++i) {
+        if (i % 2 == 0) {
+            devices.push_back(new PhilipsHueLight());
+        } else {
+            devices.push_back(new SamsungCamera());
+        }
+    }
+    std::vector<Device*> removalOrder(devices);
+    shuffle(removalOrder);
+
+    // --- Old layout: allDevices + per-type vector, linear find + erase ---
+    {
+        std::vector<Device*> allDevices;
+        std::vector<Device*> lights;
+        std::vector<Device*> cameras;
+        std::vector<Device*> legacyOrder(devices.begin(), devices.begin() + legacyCount);
+        shuffle(legacyOrder);
+
+        BenchClock::time_point start = BenchClock::now();
+        for (long i = 0; i < legacyCount; ++i) {
+            allDevices.push_back(devices[i]);
+            (i % 2 == 0 ? lights : cameras).push_back(devices[i]);
+        }
+        BenchClock::time_point end = BenchClock::now();
+        std::printf("(old layout uses the first %ld devices)\n", legacyCount);
+        report("vectors: add", legacyCount, start, end);
+
+        start = BenchClock::now();
+        for (long i = 0; i < legacyCount; ++i) {
+            Device* device = legacyOrder[i];
+            std::vector<Device*>& typed = device->getDeviceType() == "Light" ? lights : cameras;
+            typed.erase(std::find(typed.begin(), typed.end(), device));
+            allDevices.erase(std::find(allDevices.begin(), allDevices.end(), device));
+        }
+        end = BenchClock::now();
+        report("vectors: remove", legacyCount, start, end);
+        std::printf("\n");
+    }
+
+    // --- DeviceRegistry ---
+    {
+        DeviceRegistry registry;
+
+        BenchClock::time_point start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            registry.add(devices[i], i % 2 == 0 ? KIND_LIGHT : KIND_CAMERA);
+        }
+        BenchClock::time_point end = BenchClock::now();
+        report("registry: add", count, start, end);
+
+        size_t found = 0;
+        start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            found += registry.find(removalOrder[i]->getDeviceId()) != NULL;
+        }
+        end = BenchClock::now();
+        report("registry: find by id", count, start, end);
+
+        start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            found += registry.findByName(removalOrder[i]->getName()) != NULL;
+        }
+        end = BenchClock::now();
+        report("registry: find by name", count, start, end);
+
+        start = BenchClock::now();
+        for (long i = 0; i < count; ++i) {
+            registry.remove(removalOrder[i]);
+        }
+        end = BenchClock::now();
+        report("registry: remove", count, start, end);
+
+        if (found != (size_t)count * 2 || registry.size() != 0) {
+            std::printf("[ERROR] registry lookups failed (%zu found, %zu left)\n", found, registry.size());
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < devices.size(); ++i) {
+        delete devices[i];
+    }
+    return 0;
+}
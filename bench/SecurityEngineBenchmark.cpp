@@ -0,0 +1,172 @@
+/**
+ * @file SecurityEngineBenchmark.cpp
+ * @brief Security events through SecuritySystem's queue and dispatch table:
+ *        cost per event against calling the handlers directly, and the
+ *        per-stage latency of the default motion sequence
+ *
+ * Usage: SecurityEngineBenchmark [events] [lights] [cameras]   (default 2000000 / 16 / 4)
+ *
+ * Part one uses counting handlers: motion (armed only) runs four of them,
+ * detection runs two plus one that needs a level of 50. The same events are
+ * replayed with the equivalent if/else calls on a second set of handlers;
+ * every handler must have run equally often. Part two posts motion events
+ * through the default rules (alarm, light blink, notification, camera
+ * recording) with real devices and prints the engine's stage metrics.
+ * Exits with 1 on any mismatch.
+ */
+
+#include "SecuritySystem.h"
+#include "NotificationSystem.h"
+#include "DeviceRegistry.h"
+#include "Light.h"
+#include "Camera.h"
+#include "Alarm.h"
+#include "OutputSink.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+class CountingHandler : public SecurityHandler {
+public:
+    unsigned long long hits;
+    long long sum;
+    CountingHandler(const std::string& name) : SecurityHandler(name), hits(0), sum(0) {}
+    virtual void handle(const SecurityEvent& event) {
+        ++hits;
+        sum += event.value;
+    }
+};
+
+static const int HANDLERS = 7;
+
+static void printMetrics(const SecuritySystem& engine) {
+    std::vector<SecurityStageMetrics> metrics;
+    engine.getMetrics(metrics);
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        if (metrics[i].calls == 0) {
+            continue;
+        }
+        std::printf("  %-18s %10llu calls  avg %9.1f ns  max %9.1f us\n", metrics[i].stage.c_str(),
+                    metrics[i].calls, (double)metrics[i].totalNanos / metrics[i].calls,
+                    metrics[i].maxNanos / 1e3);
+    }
+}
+
+int main(int argc, char** argv) {
+    long total = benchArgCount(argc, argv, 1, 2000000);
+    long lightCount = benchArgCount(argc, argv, 2, 16);
+    long cameraCount = benchArgCount(argc, argv, 3, 4);
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+
+    std::vector<SecurityEvent> events((size_t)total);
+    std::mt19937 rng(25);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (size_t i = 0; i < events.size(); ++i) {
+        bool motion = percent(rng) < 50;
+        events[i] = SecurityEvent(motion ? SECURITY_MOTION : SECURITY_DETECTION, "Bench device",
+                                  (int)(i % 64), motion ? 0 : percent(rng));
+    }
+    std::printf("%ld events\n\n", total);
+
+    // Part one: dispatch cost with trivial handlers
+    SecuritySystem engine(NULL, NULL);
+    engine.clearRules();
+    CountingHandler* viaEngine[HANDLERS];
+    CountingHandler* direct[HANDLERS];
+    for (int h = 0; h < HANDLERS; ++h) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "Stage %d", h);
+        viaEngine[h] = new CountingHandler(name);
+        direct[h] = new CountingHandler(name);
+    }
+    for (int h = 0; h < 4; ++h) {
+        engine.addRule(SECURITY_MOTION, viaEngine[h]);
+    }
+    engine.addRule(SECURITY_DETECTION, viaEngine[4], false);
+    engine.addRule(SECURITY_DETECTION, viaEngine[5], false);
+    engine.addRule(SECURITY_DETECTION, viaEngine[6], false, 50);
+    engine.activate();
+
+    BenchClock::time_point start = BenchClock::now();
+    for (size_t i = 0; i < events.size(); ++i) {
+        engine.post(events[i]);
+    }
+    long long engineNanos = elapsedNanos(start, BenchClock::now());
+
+    bool armed = true;
+    start = BenchClock::now();
+    for (size_t i = 0; i < events.size(); ++i) {
+        const SecurityEvent& event = events[i];
+        if (event.type == SECURITY_MOTION) {
+            if (armed) {
+                for (int h = 0; h < 4; ++h) {
+                    direct[h]->handle(event);
+                }
+            }
+        } else {
+            direct[4]->handle(event);
+            direct[5]->handle(event);
+            if (event.value >= 50) {
+                direct[6]->handle(event);
+            }
+        }
+    }
+    long long directNanos = elapsedNanos(start, BenchClock::now());
+
+    bool consistent = engine.getProcessedCount() == (unsigned long long)total && engine.getDroppedCount() == 0;
+    for (int h = 0; h < HANDLERS; ++h) {
+        consistent = consistent && viaEngine[h]->hits == direct[h]->hits && viaEngine[h]->sum == direct[h]->sum;
+        delete direct[h];   // viaEngine[] belong to the engine
+    }
+    std::printf("direct calls:             %8.2f ns/event\n", (double)directNanos / total);
+    std::printf("queue + dispatch table:   %8.2f ns/event (+%.2f ns, incl. stage timing)\n",
+                (double)engineNanos / total, (double)(engineNanos - directNanos) / total);
+    printMetrics(engine);
+
+    // Part two: the default motion sequence with real devices
+    DeviceRegistry registry;
+    std::vector<Light*> lights;
+    for (long i = 0; i < lightCount; ++i) {
+        Light* light = new PhilipsHueLight();
+        registry.add(light, KIND_LIGHT);
+        lights.push_back(light);
+    }
+    for (long i = 0; i < cameraCount; ++i) {
+        registry.add(new SamsungCamera(), KIND_CAMERA);
+    }
+    long motionEvents = std::min(total, 100000L);
+    {
+        NotificationSystem notifications;
+        SecuritySystem security(Alarm::getInstance(), &lights, &registry, &notifications);
+        security.activate();
+        std::cout.setstate(std::ios::failbit);
+        start = BenchClock::now();
+        for (long i = 0; i < motionEvents; ++i) {
+            security.post(SecurityEvent(SECURITY_MOTION, "Bench camera", (int)(i % 64)));
+        }
+        long long sequenceNanos = elapsedNanos(start, BenchClock::now());
+        notifications.flush();
+        std::cout.clear();
+
+        std::printf("\ndefault motion sequence, %ld lights, %ld cameras: %.2f us/event\n",
+                    lightCount, cameraCount, sequenceNanos / 1e3 / motionEvents);
+        printMetrics(security);
+
+        consistent = consistent && security.getProcessedCount() == (unsigned long long)motionEvents &&
+                     Alarm::getInstance()->isAlarmRinging();
+        const std::vector<Device*>& cameras = registry.getDevices(KIND_CAMERA);
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            consistent = consistent && static_cast<Camera*>(cameras[i])->isRecordingVideo();
+        }
+    }
+
+    std::vector<Device*> all(registry.getDevices());
+    registry.clear();
+    for (size_t i = 0; i < all.size(); ++i) {
+        delete all[i];
+    }
+
+    std::printf("\nresults %s\n", consistent ? "match" : "MISMATCH");
+    return consistent ? 0 : 1;
+}
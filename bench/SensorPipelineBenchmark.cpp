@@ -0,0 +1,169 @@
+/**
+ * @file SensorPipelineBenchmark.cpp
+ * @brief Replays detector readings: one setSmokeLevel/setGasLevel call per
+ *        reading vs. SensorPipeline batched ingestion
+ *
+ * Usage: SensorPipelineBenchmark [detectors] [readings] [batchSize]   (default 10000 / 10000000 / 4096)
+ *
+ * Half the detectors are smoke, half gas. Readings are low background
+ * noise with rare spikes over the threshold; every detection is reset after
+ * each pass over the replay buffer so alerts keep happening. Alert text is
+ * suppressed while timing. Both paths run on their own identical fleet and
+ * must end with the same detections, levels and EVENT_DETECTION count.
+ */
+
+#include "SensorPipeline.h"
+#include "DeviceEventBus.h"
+#include "DeviceRegistry.h"
+#include "SmokeDetector.h"
+#include "GasDetector.h"
+#include "OutputSink.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+class DetectionCounter : public IDeviceObserver {
+public:
+    unsigned long long detections;
+    DetectionCounter() : detections(0) {}
+    virtual void onDeviceFailure(const std::string&, const std::string&) {}
+    virtual void onDeviceEvent(const DeviceEvent& event) {
+        if (event.type == EVENT_DETECTION) {
+            ++detections;
+        }
+    }
+};
+
+struct Fleet {
+    DeviceRegistry registry;
+    DeviceEventBus bus;
+    DetectionCounter counter;
+    std::vector<Detector*> byId;   // Device ID -> detector
+
+    explicit Fleet(long count) {
+        bus.subscribe(&counter, DeviceEventFilter("", "", SEVERITY_CRITICAL));
+        for (long i = 0; i < count; ++i) {
+            Detector* detector;
+            if (i % 2 == 0) {
+                detector = new NestSmokeDetector();
+                registry.add(detector, KIND_SMOKE_DETECTOR);
+            } else {
+                detector = new KiddeGasDetector();
+                registry.add(detector, KIND_GAS_DETECTOR);
+            }
+            bus.attach(detector);
+            if ((size_t)detector->getDeviceId() >= byId.size()) {
+                byId.resize(detector->getDeviceId() + 1, NULL);
+            }
+            byId[detector->getDeviceId()] = detector;
+        }
+    }
+
+    ~Fleet() {
+        std::vector<Device*> all(registry.getDevices());
+        registry.clear();
+        for (size_t i = 0; i < all.size(); ++i) {
+            delete all[i];
+        }
+    }
+
+    void resetAll() {
+        const std::vector<Device*>& devices = registry.getDevices();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            static_cast<Detector*>(devices[i])->resetDetection();
+        }
+    }
+};
+
+static int levelOf(const Detector* detector) {
+    const SmokeDetector* smoke = dynamic_cast<const SmokeDetector*>(detector);
+    return smoke ? smoke->getSmokeLevel() : static_cast<const GasDetector*>(detector)->getGasLevel();
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 10000);
+    long total = benchArgCount(argc, argv, 2, 10000000);
+    size_t batch = (size_t)benchArgCount(argc, argv, 3, 4096);
+    std::printf("%ld detectors, %ld readings, batches of %zu\n\n", count, total, batch);
+
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+    Fleet single(count);
+    Fleet batched(count);
+    SensorPipeline pipeline;
+    const std::vector<Device*>& devices = batched.registry.getDevices();
+    for (size_t i = 0; i < devices.size(); ++i) {
+        pipeline.attach(static_cast<Detector*>(devices[i]));
+    }
+
+    // Replay buffer: about one reading in 20000 is a spike
+    size_t replaySize = (size_t)std::min(total, 1000000L);
+    std::vector<SensorReading> replay(replaySize);
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<size_t> pickDevice(0, devices.size() - 1);
+    std::uniform_int_distribution<int> noise(0, 20);
+    std::uniform_int_distribution<int> spike(0, 19999);
+    long long now = 1700000000000000LL;
+    for (size_t r = 0; r < replaySize; ++r) {
+        replay[r].detectorId = devices[pickDevice(rng)]->getDeviceId();
+        replay[r].level = spike(rng) == 0 ? 95 : noise(rng);
+        replay[r].timestamp = now + (long long)r * 10;
+    }
+
+    std::cout.setstate(std::ios::failbit);
+
+    // One call per reading, as setSmokeLevel/setGasLevel are used today
+    long long singleNanos = 0;
+    for (long done = 0; done < total;) {
+        size_t n = (size_t)std::min((long)replaySize, total - done);
+        BenchClock::time_point start = BenchClock::now();
+        for (size_t r = 0; r < n; ++r) {
+            Detector* detector = single.byId[replay[r].detectorId];
+            if (detector->getDeviceType() == "Smoke Detector") {
+                static_cast<SmokeDetector*>(detector)->setSmokeLevel(replay[r].level);
+            } else {
+                static_cast<GasDetector*>(detector)->setGasLevel(replay[r].level);
+            }
+        }
+        singleNanos += elapsedNanos(start, BenchClock::now());
+        done += (long)n;
+        if (done < total) {
+            single.resetAll();
+        }
+    }
+
+    long long batchNanos = 0;
+    for (long done = 0; done < total;) {
+        size_t n = (size_t)std::min((long)replaySize, total - done);
+        BenchClock::time_point start = BenchClock::now();
+        for (size_t r = 0; r < n; r += batch) {
+            pipeline.ingest(&replay[r], std::min(batch, n - r));
+        }
+        batchNanos += elapsedNanos(start, BenchClock::now());
+        done += (long)n;
+        if (done < total) {
+            batched.resetAll();
+        }
+    }
+
+    std::cout.clear();
+
+    bool consistent = single.counter.detections == batched.counter.detections &&
+                      pipeline.getTransitionCount() == batched.counter.detections;
+    const std::vector<Device*>& reference = single.registry.getDevices();
+    for (size_t i = 0; i < devices.size(); ++i) {
+        const Detector* a = static_cast<const Detector*>(reference[i]);
+        const Detector* b = static_cast<const Detector*>(devices[i]);
+        if (a->isDetected() != b->isDetected() || levelOf(a) != levelOf(b)) {
+            consistent = false;
+        }
+    }
+
+    std::printf("per-reading setters: %8.2f ns/reading  %8.1f M readings/s\n",
+                (double)singleNanos / total, total / (singleNanos / 1e3));
+    std::printf("SensorPipeline:      %8.2f ns/reading  %8.1f M readings/s\n",
+                (double)batchNanos / total, total / (batchNanos / 1e3));
+    std::printf("\n%llu detections; results %s\n", pipeline.getTransitionCount(),
+                consistent ? "match" : "MISMATCH");
+    return consistent ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file SignalFilterBenchmark.cpp
+ * @brief Noisy detector readings through SensorPipeline with different
+ *        SignalFilter settings: throughput and how many alerts come out
+ *
+ * Usage: SignalFilterBenchmark [detectors] [readings] [batchSize]   (default 10000 / 10000000 / 4096)
+ *
+ * Each detector hovers just below its threshold with +-12 noise, and now and
+ * then has a real event well above it for a while. Unfiltered with a
+ * hysteresis band, the noise alone keeps raising and clearing alerts; the
+ * smoothing + debounce settings should only alert on the real events.
+ * Every setting is replayed a second time reading by reading through
+ * setSmokeLevel/setGasLevel on a separate fleet; detections, filtered levels
+ * and EVENT_DETECTION counts must match.
+ */
+
+#include "SensorPipeline.h"
+#include "DeviceEventBus.h"
+#include "DeviceRegistry.h"
+#include "SmokeDetector.h"
+#include "GasDetector.h"
+#include "OutputSink.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+struct Setting {
+    const char* label;
+    SignalFilter::Mode mode;
+    int amount;
+    int debounce;
+    int hysteresis;
+};
+
+static const Setting SETTINGS[] = {
+    { "pass-through (latching)",    SignalFilter::FILTER_NONE,           0, 1, 0  },
+    { "raw, hysteresis 10",         SignalFilter::FILTER_NONE,           0, 1, 10 },
+    { "moving avg 8, debounce 3",   SignalFilter::FILTER_MOVING_AVERAGE, 8, 3, 10 },
+    { "EWMA 25%, debounce 3",       SignalFilter::FILTER_EWMA,          25, 3, 10 },
+};
+
+class DetectionCounter : public IDeviceObserver {
+public:
+    unsigned long long detections;
+    DetectionCounter() : detections(0) {}
+    virtual void onDeviceFailure(const std::string&, const std::string&) {}
+    virtual void onDeviceEvent(const DeviceEvent& event) {
+        if (event.type == EVENT_DETECTION) {
+            ++detections;
+        }
+    }
+};
+
+struct Fleet {
+    DeviceRegistry registry;
+    DeviceEventBus bus;
+    DetectionCounter counter;
+    std::vector<Detector*> byId;   // Device ID -> detector
+
+    Fleet(long count, const Setting& setting) {
+        bus.subscribe(&counter, DeviceEventFilter("", "", SEVERITY_CRITICAL));
+        for (long i = 0; i < count; ++i) {
+            Detector* detector;
+            if (i % 2 == 0) {
+                detector = new NestSmokeDetector();
+                registry.add(detector, KIND_SMOKE_DETECTOR);
+            } else {
+                detector = new KiddeGasDetector();
+                registry.add(detector, KIND_GAS_DETECTOR);
+            }
+            detector->setSmoothing(setting.mode, setting.amount);
+            detector->setDebounce(setting.debounce);
+            detector->setHysteresis(setting.hysteresis);
+            bus.attach(detector);
+            if ((size_t)detector->getDeviceId() >= byId.size()) {
+                byId.resize(detector->getDeviceId() + 1, NULL);
+            }
+            byId[detector->getDeviceId()] = detector;
+        }
+    }
+
+    ~Fleet() {
+        std::vector<Device*> all(registry.getDevices());
+        registry.clear();
+        for (size_t i = 0; i < all.size(); ++i) {
+            delete all[i];
+        }
+    }
+};
+
+// Below the threshold with noise that crosses it, plus rare sustained events
+static std::vector<SensorReading> makeReadings(const Fleet& fleet, size_t size) {
+    const std::vector<Device*>& devices = fleet.registry.getDevices();
+    std::vector<SensorReading> replay(size);
+    std::vector<int> eventLeft(fleet.byId.size(), 0);
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<size_t> pickDevice(0, devices.size() - 1);
+    std::uniform_int_distribution<int> noise(-12, 12);
+    std::uniform_int_distribution<int> startEvent(0, 2999);
+    long long now = 1700000000000000LL;
+    for (size_t r = 0; r < size; ++r) {
+        const Detector* detector = static_cast<const Detector*>(devices[pickDevice(rng)]);
+        int id = detector->getDeviceId();
+        if (eventLeft[id] == 0 && startEvent(rng) == 0) {
+            eventLeft[id] = 20;
+        }
+        int level = detector->getThreshold() - 8 + noise(rng);
+        if (eventLeft[id] > 0) {
+            level += 40;
+            --eventLeft[id];
+        }
+        replay[r].detectorId = id;
+        replay[r].level = level;
+        replay[r].timestamp = now + (long long)r * 10;
+    }
+    return replay;
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 10000);
+    long total = benchArgCount(argc, argv, 2, 10000000);
+    size_t batch = (size_t)benchArgCount(argc, argv, 3, 4096);
+    std::printf("%ld detectors, %ld readings, batches of %zu\n\n", count, total, batch);
+    std::printf("%-26s %12s %14s %10s %10s %10s\n", "setting", "ns/reading", "M readings/s",
+                "raised", "cleared", "per-call");
+
+    OutputSink::getInstance()->setMode(OutputSink::OUTPUT_SILENT);
+    bool consistent = true;
+    for (size_t s = 0; s < sizeof(SETTINGS) / sizeof(SETTINGS[0]); ++s) {
+        const Setting& setting = SETTINGS[s];
+        Fleet batched(count, setting);
+        Fleet single(count, setting);
+        SensorPipeline pipeline;
+        const std::vector<Device*>& devices = batched.registry.getDevices();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            pipeline.attach(static_cast<Detector*>(devices[i]));
+        }
+        size_t replaySize = (size_t)std::min(total, 1000000L);
+        std::vector<SensorReading> replay = makeReadings(batched, replaySize);
+
+        std::cout.setstate(std::ios::failbit);
+        long long nanos = 0;
+        for (long done = 0; done < total;) {
+            size_t n = (size_t)std::min((long)replaySize, total - done);
+            BenchClock::time_point start = BenchClock::now();
+            for (size_t r = 0; r < n; r += batch) {
+                pipeline.ingest(&replay[r], std::min(batch, n - r));
+            }
+            nanos += elapsedNanos(start, BenchClock::now());
+            done += (long)n;
+        }
+
+        // Reference: the same readings one setter call at a time
+        long long singleNanos = 0;
+        for (long done = 0; done < total;) {
+            size_t n = (size_t)std::min((long)replaySize, total - done);
+            BenchClock::time_point start = BenchClock::now();
+            for (size_t r = 0; r < n; ++r) {
+                Detector* detector = single.byId[replay[r].detectorId];
+                if (detector->getDeviceType() == "Smoke Detector") {
+                    static_cast<SmokeDetector*>(detector)->setSmokeLevel(replay[r].level);
+                } else {
+                    static_cast<GasDetector*>(detector)->setGasLevel(replay[r].level);
+                }
+            }
+            singleNanos += elapsedNanos(start, BenchClock::now());
+            done += (long)n;
+        }
+        std::cout.clear();
+
+        bool match = single.counter.detections == batched.counter.detections &&
+                     pipeline.getTransitionCount() == batched.counter.detections;
+        const std::vector<Device*>& reference = single.registry.getDevices();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            const Detector* a = static_cast<const Detector*>(reference[i]);
+            const Detector* b = static_cast<const Detector*>(devices[i]);
+            const SignalFilter& filter = b->getSignalFilter();
+            if (a->isDetected() != b->isDetected() || a->getReading() != b->getReading() ||
+                (!filter.isPassThrough() && a->getSignalFilter().getValue() != filter.getValue())) {
+                match = false;
+            }
+        }
+        consistent = consistent && match;
+
+        std::printf("%-26s %12.2f %14.1f %10llu %10llu %7.2f ns%s\n", setting.label,
+                    (double)nanos / total, total / (nanos / 1e3),
+                    pipeline.getTransitionCount(), pipeline.getReleaseCount(),
+                    (double)singleNanos / total, match ? "" : "  MISMATCH");
+    }
+
+    std::printf("\nresults %s\n", consistent ? "match" : "MISMATCH");
+    return consistent ? 0 : 1;
+}
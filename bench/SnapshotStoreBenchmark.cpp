@@ -0,0 +1,75 @@
+/**
+ * @file SnapshotStoreBenchmark.cpp
+ * @brief Snapshot store append throughput, file size and load (resume) time
+ *
+ * Usage: SnapshotStoreBenchmark [devices] [records] [changesPerRecord]   (default 10000 / 2000 / 10)
+ *
+ * Writes to msh_snapshots_bench.bin in the working directory and removes it
+ * afterwards. Appends include the batched fsync.
+ */
+
+#include "SnapshotStore.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <random>
+
+static const char* BENCH_PATH = "msh_snapshots_bench.bin";
+
+static long fileSize(const char* path) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        return 0;
+    }
+    std::fseek(f, 0, SEEK_END);
+    long size = std::ftell(f);
+    std::fclose(f);
+    return size;
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 10000);
+    long records = benchArgCount(argc, argv, 2, 2000);
+    long changes = benchArgCount(argc, argv, 3, 10);
+    std::printf("%ld devices, %ld records, %ld flips per record\n\n", count, records, changes);
+    std::remove(BENCH_PATH);
+
+    PowerSnapshot snapshot;
+    for (long id = 1; id <= count; ++id) {
+        snapshot.set((int)id, id % 3 == 0);
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(1, (int)count);
+    StoredSnapshot resumed;
+    bool found = false;
+    long long appendNanos = 0;
+    {
+        SnapshotStore store;
+        store.open(BENCH_PATH, resumed, found);
+        for (long r = 0; r < records; ++r) {
+            for (long c = 0; c < changes; ++c) {
+                int id = pick(rng);
+                snapshot.set(id, !snapshot.isPowered(id));
+            }
+            BenchClock::time_point start = BenchClock::now();
+            store.append("Normal", "Party", snapshot);
+            appendNanos += elapsedNanos(start, BenchClock::now());
+        }
+    }
+    long size = fileSize(BENCH_PATH);
+
+    BenchClock::time_point start = BenchClock::now();
+    SnapshotStore store;
+    store.open(BENCH_PATH, resumed, found);
+    double loadMillis = elapsedMillis(start, BenchClock::now());
+
+    bool matches = found && resumed.power.present == snapshot.present && resumed.power.power == snapshot.power;
+    std::printf("append:  %9.2f us per record (fsync every few records)\n", appendNanos / 1e3 / records);
+    std::printf("file:    %9ld bytes, %.1f bytes per record\n", size, (double)size / records);
+    std::printf("load:    %9.2f ms to resume from %zu records\n", loadMillis, store.getRecordCount());
+    std::printf("\nresumed snapshot %s\n", matches ? "matches the last one written" : "MISMATCH");
+
+    store.close();
+    std::remove(BENCH_PATH);
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file StateTableBenchmark.cpp
+ * @brief Per-device power loops vs. DeviceStateTable bulk operations
+ *
+ * Usage: StateTableBenchmark [devices] [rounds]   (default 100000 / 20)
+ *
+ * Console output of the power hooks is discarded so the numbers show the
+ * cost of the state handling itself.
+ */
+
+#include "DeviceStateTable.h"
+#include "DeviceRegistry.h"
+#include "Light.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+// Swallows everything written to it
+class NullBuffer : public std::streambuf {
+protected:
+    virtual int overflow(int c) {
+        return c;
+    }
+    virtual std::streamsize xsputn(const char*, std::streamsize n) {
+        return n;
+    }
+};
+
+static void report(const char* label, double nanos, double perDevice) {
+    std::printf("%-36s %10.2f ms  %8.2f ns/device\n", label, nanos / 1e6, nanos / perDevice);
+}
+
+int main(int argc, char** argv) {
+    long count = benchArgCount(argc, argv, 1, 100000);
+    long rounds = benchArgCount(argc, argv, 2, 20);
+    std::printf("%ld lights, %ld rounds per measurement\n\n", count, rounds);
+
+    DeviceRegistry registry;
+    for (long i = 0; i < count; ++i) {
+        registry.add(new PhilipsHueLight(), KIND_LIGHT);
+    }
+    const std::vector<Device*>& lights = registry.getDevices(KIND_LIGHT);
+    DeviceStateTable* table = DeviceStateTable::getInstance();
+
+    NullBuffer nullBuffer;
+    std::streambuf* original = std::cout.rdbuf(&nullBuffer);
+    double visits = (double)count * rounds;
+    double perLoop[4];
+    double perTable[4];
+    size_t sink = 0;
+
+    // Flip everything on and off
+    BenchClock::time_point start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < lights.size(); ++i) {
+            lights[i]->powerOn();
+        }
+        for (size_t i = 0; i < lights.size(); ++i) {
+            lights[i]->powerOff();
+        }
+    }
+    perLoop[0] = (double)elapsedNanos(start, BenchClock::now());
+
+    start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        sink += table->setPower(KIND_LIGHT, true);
+        sink += table->setPower(KIND_LIGHT, false);
+    }
+    perTable[0] = (double)elapsedNanos(start, BenchClock::now());
+
+    // Re-apply a state every device already has (the common case for modes)
+    start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < lights.size(); ++i) {
+            lights[i]->powerOff();
+        }
+    }
+    perLoop[1] = (double)elapsedNanos(start, BenchClock::now());
+
+    start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        sink += table->setPower(KIND_LIGHT, false);
+    }
+    perTable[1] = (double)elapsedNanos(start, BenchClock::now());
+
+    // Same, but through the list-based path ModeManager uses
+    start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        sink += table->setPower(lights, false);
+    }
+    perTable[2] = (double)elapsedNanos(start, BenchClock::now());
+
+    // Status counts
+    table->setPower(KIND_LIGHT, true);
+    start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < lights.size(); ++i) {
+            sink += lights[i]->isPoweredOn() ? 1 : 0;
+        }
+    }
+    perLoop[3] = (double)elapsedNanos(start, BenchClock::now());
+
+    start = BenchClock::now();
+    for (long r = 0; r < rounds; ++r) {
+        sink += table->countPowered(KIND_LIGHT);
+    }
+    perTable[3] = (double)elapsedNanos(start, BenchClock::now());
+
+    std::cout.rdbuf(original);
+
+    report("loop:  power on + off", perLoop[0], visits * 2);
+    report("table: power on + off", perTable[0], visits * 2);
+    std::printf("\n");
+    report("loop:  power off (no change)", perLoop[1], visits);
+    report("table: power off kind (no change)", perTable[1], visits);
+    report("table: power off list (no change)", perTable[2], visits);
+    std::printf("\n");
+    report("loop:  count powered", perLoop[3], visits);
+    report("table: count powered (popcount)", perTable[3], visits);
+    std::printf("\n(checksum %zu)\n", sink);
+
+    for (size_t i = lights.size(); i > 0; --i) {
+        Device* device = lights[i - 1];
+        registry.remove(device);
+        delete device;
+    }
+    return 0;
+}
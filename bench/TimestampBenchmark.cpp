@@ -0,0 +1,113 @@
+/**
+ * @file TimestampBenchmark.cpp
+ * @brief Allocations and time per timestamp / per log line, ctime() vs. TimestampFormatter
+ *
+ * Usage: TimestampBenchmark [iterations]   (default 1000000)
+ */
+
+#include "TimestampFormatter.h"
+#include "Storage.h"
+#include "StateManager.h"
+#include "BenchUtil.h"
+#include <ctime>
+#include <cstdio>
+#include <new>
+
+// Global allocation counter - every operator new in the process goes through here
+static unsigned long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// What Storage::getCurrentTimestamp and HomeMemento did before
+static std::string legacyTimestamp() {
+    time_t now = time(0);
+    char* dt = ctime(&now);
+    std::string timestamp(dt);
+    if (!timestamp.empty() && timestamp[timestamp.length()-1] == '\n') {
+        timestamp.erase(timestamp.length()-1);
+    }
+    return timestamp;
+}
+
+static void report(const char* label, long iterations, unsigned long long allocs,
+                   BenchClock::time_point start, BenchClock::time_point end) {
+    std::printf("%-34s %8.2f allocs/op  %8.1f ns/op\n", label,
+                (double)allocs / iterations, (double)elapsedNanos(start, end) / iterations);
+}
+
+int main(int argc, char** argv) {
+    long iterations = benchArgCount(argc, argv, 1, 1000000);
+    std::printf("Timestamp formatting x %ld\n", iterations);
+
+    size_t sink = 0;
+
+    unsigned long long before = allocationCount;
+    BenchClock::time_point start = BenchClock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += legacyTimestamp().size();
+    }
+    report("legacy time()+ctime()+string", iterations, allocationCount - before, start, BenchClock::now());
+
+    TimestampFormatter ctimeFormatter(TimestampFormatter::FORMAT_CTIME);
+    char buffer[TimestampFormatter::BUFFER_SIZE];
+    before = allocationCount;
+    start = BenchClock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += ctimeFormatter.formatNow(buffer);
+    }
+    report("TimestampFormatter ctime", iterations, allocationCount - before, start, BenchClock::now());
+
+    TimestampFormatter isoFormatter(TimestampFormatter::FORMAT_ISO8601_MICROS);
+    before = allocationCount;
+    start = BenchClock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += isoFormatter.formatNow(buffer);
+    }
+    report("TimestampFormatter iso8601 us", iterations, allocationCount - before, start, BenchClock::now());
+
+    // Whole log line through Storage (sync mode, timestamp + message building)
+    Storage* storage = Storage::getInstance();
+    const char* file = "bench_timestamp_log.txt";
+    std::remove(file);
+    storage->openFile(file);
+    const std::string message = "[INFO] Device 'Philips Hue White A19': Powered ON";
+    long lines = iterations / 10 > 0 ? iterations / 10 : 1;
+    before = allocationCount;
+    start = BenchClock::now();
+    for (long i = 0; i < lines; ++i) {
+        storage->log(message);
+    }
+    BenchClock::time_point end = BenchClock::now();
+    unsigned long long allocs = allocationCount - before;
+    storage->closeFile();
+    std::remove(file);
+    std::remove(Storage::eventLogFilename(file).c_str());
+    report("Storage::log (sync) per line", lines, allocs, start, end);
+
+    // Memento construction (timestamp no longer allocates)
+    before = allocationCount;
+    start = BenchClock::now();
+    for (long i = 0; i < lines; ++i) {
+        HomeMemento memento("Normal", "Normal");
+        sink += memento.getStateName().size();
+    }
+    report("HomeMemento construction", lines, allocationCount - before, start, BenchClock::now());
+
+    std::printf("(checksum %lu)\n", (unsigned long)sink);
+    return 0;
+}
@@ -1,6 +1,6 @@
 /**
  * @file AlarmHandler.h
- * @brief Handler that triggers the alarm in the security chain
+ * @brief Handler that triggers the alarm in the security sequence
  * @version 5.0
  * @date 03/12/2025
  * 
@@ -22,7 +22,7 @@ private:
     
 public:
     AlarmHandler(Alarm* alarm);
-    virtual void handleRequest();
+    virtual void handle(const SecurityEvent& event);
 };
 
 #endif // ALARMHANDLER_H
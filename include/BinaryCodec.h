@@ -0,0 +1,31 @@
+#ifndef BINARYCODEC_H
+#define BINARYCODEC_H
+
+#include <cstddef>
+#include <string>
+
+// Encoding helpers shared by the binary files (event log, snapshot store,
+// level history). Fixed-width integers are little-endian; varints are
+// LEB128-style, signed values zigzagged so small negatives stay small.
+// The readers never go past size and return false on a truncated value.
+class BinaryCodec {
+private:
+    BinaryCodec();
+
+public:
+    // CRC-32 (IEEE, as in zlib) of a record payload
+    static unsigned crc32(const char* data, size_t size);
+
+    static void putU32(char* out, unsigned value);
+    static unsigned getU32(const char* in);
+    static void putU64(std::string& out, unsigned long long value);
+    static unsigned long long getU64(const char* in);
+
+    static void putVarint(std::string& out, unsigned long long value);
+    static void putSignedVarint(std::string& out, long long value);
+    static bool getVarint(const char* data, size_t size, size_t& pos, unsigned long long& value);
+    static bool getSignedVarint(const char* data, size_t size, size_t& pos, long long& value);
+    static long long unzigzag(unsigned long long value);
+};
+
+#endif // BINARYCODEC_H
@@ -14,6 +14,7 @@
 #define CAMERA_H
 
 #include "Device.h"
+#include "DevicePool.h"
 
 class Camera : public Device
 {
@@ -35,6 +36,8 @@ public:
     virtual Device *clone() const = 0;
 
     void detectMotion(); // Used to trigger security, now independent
+    void startRecording(); // Powers the camera on if needed
+    bool isRecordingVideo() const;
     void setResolution(int res);
     int getResolution() const;
 };
@@ -46,6 +49,7 @@ public:
     SamsungCamera();
     virtual ~SamsungCamera();
     virtual Device *clone() const;
+    MSH_POOLED_DEVICE(SamsungCamera)
 };
 
 // Concrete Camera - Xiaomi
@@ -55,6 +59,7 @@ public:
     XiaomiCamera();
     virtual ~XiaomiCamera();
     virtual Device *clone() const;
+    MSH_POOLED_DEVICE(XiaomiCamera)
 };
 
 #endif // CAMERA_H
\ No newline at end of file
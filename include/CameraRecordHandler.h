@@ -0,0 +1,24 @@
+/**
+ * @file CameraRecordHandler.h
+ * @brief Handler that makes every camera record in the security sequence
+ *
+ * @patterns Chain of Responsibility
+ */
+
+#ifndef CAMERARECORDHANDLER_H
+#define CAMERARECORDHANDLER_H
+
+#include "SecurityHandler.h"
+
+class DeviceRegistry;
+
+class CameraRecordHandler : public SecurityHandler {
+private:
+    const DeviceRegistry* registry;
+
+public:
+    CameraRecordHandler(const DeviceRegistry* registry);
+    virtual void handle(const SecurityEvent& event);
+};
+
+#endif // CAMERARECORDHANDLER_H
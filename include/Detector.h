@@ -14,12 +14,46 @@
 #define DETECTOR_H
 
 #include "Device.h"
+#include "SignalFilter.h"
 #include <string>
 
+class SensorPipeline;
+class LevelSeries;
+
 class Detector : public Device {
+private:
+    friend class SensorPipeline;
+    friend class LevelHistory;
+
+    SensorPipeline* pipeline;   // Set while attached to a SensorPipeline
+    int pipelineSlot;
+    SignalFilter filter;        // The pipeline holds the live copy while attached
+    LevelSeries* history;       // Set while attached to a LevelHistory
+
+    SignalFilter& activeFilter();
+    const SignalFilter& activeFilter() const;
+    void filterChanged();
+
 protected:
     bool detected;
     int sensitivityLevel;
+
+    // Stores a reading in the subclass field without evaluating it
+    virtual void recordLevel(int level) = 0;
+    virtual void printAlert(int level) const = 0;
+    virtual const char* detectionMessage() const = 0;
+    // Latches the alert, prints it and publishes EVENT_DETECTION on the first one
+    void raiseDetection(int level);
+    // Clears the alert once the filtered level fell below the hysteresis band
+    void releaseDetection(int level);
+    // Runs a new reading through the signal filter and raises or releases the alert
+    void evaluateReading(int level);
+    // Re-checks the current state without feeding the filter a new sample
+    void checkDetection(int level);
+    // While attached, the pipeline's level column is the current reading
+    int currentLevel(int ownLevel) const;
+    // Also records the level in the detector's history
+    void levelChanged(int level);
     
 public:
     Detector(const std::string& brand, const std::string& model);
@@ -42,6 +76,19 @@ public:
     bool isDetected() const;
     void setSensitivity(int level);
     int getSensitivity() const;
+    // Readings above this level are a detection; higher sensitivity = lower threshold
+    int getThreshold() const;
+    // amount: moving average window in samples, or EWMA weight of a new reading in percent
+    void setSmoothing(SignalFilter::Mode mode, int amount);
+    // Consecutive filtered readings needed to raise (and, with a band, to clear) an alert
+    void setDebounce(int samples);
+    // Auto-clear once the filtered level is this far below the threshold; 0 latches
+    void setHysteresis(int band);
+    const SignalFilter& getSignalFilter() const;
+    // Recorded levels, NULL if the detector has no history
+    const LevelSeries* getLevelHistory() const;
+    // Latest smoke or gas level, 0-100
+    virtual int getReading() const = 0;
 };
 
 #endif // DETECTOR_H
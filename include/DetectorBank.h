@@ -0,0 +1,69 @@
+#ifndef DETECTORBANK_H
+#define DETECTORBANK_H
+
+#include <cstddef>
+#include <vector>
+
+// Fleet-level threshold evaluation: levels and thresholds of many detectors
+// in two aligned int arrays, compared in one pass into a detection bitmask
+// (bit i set when level[i] > threshold[i], as in SmokeDetector::detect).
+//
+// The arrays are padded to a multiple of 64 entries with thresholds no level
+// can exceed, so the SIMD kernels always work on whole mask words. The kernel
+// is picked at runtime from what the CPU supports (AVX2, SSE2, scalar); set
+// MSH_SIMD=scalar|sse2|avx2 or call setKernel to force one.
+class DetectorBank {
+public:
+    typedef unsigned long long Word;
+    static const size_t WORD_BITS = 64;
+
+    enum Kernel {
+        KERNEL_SCALAR,
+        KERNEL_SSE2,
+        KERNEL_AVX2
+    };
+
+private:
+    int* levels;
+    int* thresholds;
+    size_t count;
+    size_t capacity;     // Multiple of WORD_BITS
+    Kernel kernel;
+
+    DetectorBank(const DetectorBank&);
+    DetectorBank& operator=(const DetectorBank&);
+
+    void grow(size_t minimum);
+
+public:
+    DetectorBank();
+    ~DetectorBank();
+
+    // Returns the index of the new entry
+    size_t add(int threshold, int level = 0);
+    void resize(size_t newCount, int threshold, int level = 0);
+    void clear();
+    size_t size() const;
+
+    int getLevel(size_t index) const;
+    void setLevel(size_t index, int level);
+    int getThreshold(size_t index) const;
+    void setThreshold(size_t index, int threshold);
+    // Direct column access for bulk writers; size() entries are valid
+    int* levelData();
+    const int* levelData() const;
+    const int* thresholdData() const;
+
+    // Fills one bit per entry and returns how many are set
+    size_t evaluate(std::vector<Word>& mask) const;
+    size_t evaluate(std::vector<Word>& mask, Kernel with) const;
+
+    Kernel getKernel() const;
+    // Falls back to the best supported kernel if with is not available
+    void setKernel(Kernel with);
+    static bool isSupported(Kernel with);
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel with);
+};
+
+#endif // DETECTORBANK_H
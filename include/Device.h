@@ -4,11 +4,42 @@
 #include <string>
 #include <iostream>
 
+class Device;
+class DeviceEventBus;
+
+enum EventSeverity {
+    SEVERITY_INFO,
+    SEVERITY_WARNING,
+    SEVERITY_CRITICAL,
+    SEVERITY_COUNT
+};
+
+enum DeviceEventType {
+    EVENT_FAILURE,
+    EVENT_DETECTION     // A detector went from clear to alert
+};
+
+// What DeviceEventBus hands to observers. Only refers to the device and the
+// message, so publishing an event copies nothing.
+struct DeviceEvent {
+    const Device& device;
+    DeviceEventType type;
+    EventSeverity severity;
+    const char* message;
+    int value;          // Level that caused a detection, 0 otherwise
+
+    DeviceEvent(const Device& d, DeviceEventType t, EventSeverity s, const char* m, int v = 0)
+        : device(d), type(t), severity(s), message(m), value(v) {}
+};
+
 // Observer Pattern - Observer interface for device failure notifications
 class IDeviceObserver {
 public:
     virtual ~IDeviceObserver() {}
     virtual void onDeviceFailure(const std::string& deviceName, const std::string& message) = 0;
+    // Called by DeviceEventBus; the default passes failures and detections to
+    // onDeviceFailure with the device ID appended to the name ("Philips Hue Light #3")
+    virtual void onDeviceEvent(const DeviceEvent& event);
 };
 
 // Base Device class - Template Method Pattern
@@ -17,9 +48,24 @@ protected:
     std::string name;
     std::string brand;
     std::string model;
-    bool powerState;      // true = on, false = off
-    bool operationMode;   // true = active, false = inactive (failed)
-    IDeviceObserver* observer;
+    DeviceEventBus* eventBus;
+    int eventRoute;       // Subscriber lists for this device's type and brand
+    int deviceId;         // Assigned by DeviceRegistry, -1 if unregistered
+    int stateSlot;        // Power/active flags, level, colour and music live in DeviceStateTable
+
+    // Raw state access for subclasses - no hooks, no output
+    void setPowerState(bool on);
+    int getLevel() const;
+    void setLevel(int level);
+
+private:
+    friend class DeviceStateTable;
+
+    Device(const Device&);
+    Device& operator=(const Device&);
+
+    // Runs the doPowerOn/doPowerOff hook after the power bit flipped
+    void powerChanged(bool on);
 
 public:
     Device(const std::string& brand, const std::string& model);
@@ -38,18 +84,25 @@ public:
     virtual std::string getDeviceType() const = 0;
     
     // Getters and Setters
-    std::string getName() const;
+    const std::string& getName() const;
     std::string getBrand() const;
     std::string getModel() const;
     bool isPoweredOn() const;
     bool isActive() const;
+    int getDeviceId() const;
+    void setDeviceId(int id);
+    int getStateSlot() const;
     
     void setOperationMode(bool active);
-    void setObserver(IDeviceObserver* obs);
-    void notifyFailure(const std::string& message);
+    // Set by DeviceEventBus::attach/detach
+    void setEventBus(DeviceEventBus* bus, int route);
+    void notifyFailure(const char* message, EventSeverity severity = SEVERITY_WARNING);
+    void notifyEvent(DeviceEventType type, EventSeverity severity, const char* message, int value = 0);
     
     // Prototype Pattern - Clone method
     virtual Device* clone() const = 0;
+    // Hint that count clones are about to be made (pooled types pre-size their slab)
+    virtual void reserveClones(size_t count) const;
     
     // For copying configuration
     virtual void copyConfigurationFrom(const Device* other);
@@ -0,0 +1,78 @@
+#ifndef DEVICEEVENTBUS_H
+#define DEVICEEVENTBUS_H
+
+#include "Device.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Which events a subscriber wants; empty strings match everything
+struct DeviceEventFilter {
+    std::string deviceType;      // Device::getDeviceType(), e.g. "Light"
+    std::string brand;           // Device::getBrand(), e.g. "Philips"
+    EventSeverity minSeverity;
+
+    DeviceEventFilter(const std::string& type = "", const std::string& deviceBrand = "",
+                      EventSeverity severity = SEVERITY_INFO)
+        : deviceType(type), brand(deviceBrand), minSeverity(severity) {}
+
+    bool matches(const std::string& type, const std::string& deviceBrand) const;
+};
+
+// Observer Pattern - fan-out of device events to any number of observers.
+//
+// Devices are grouped into routes by (type, brand); attach() gives each
+// device its route index. Every route keeps one subscriber list per
+// severity, rebuilt when subscriptions change, so publish() indexes two
+// arrays and calls the observers in that list - no filter is evaluated and
+// nothing is allocated per event. Subscriptions are changed from the main
+// thread and never from inside onDeviceEvent.
+class DeviceEventBus {
+private:
+    struct Subscription {
+        int id;
+        IDeviceObserver* observer;
+        DeviceEventFilter filter;
+    };
+
+    struct Route {
+        std::string deviceType;
+        std::string brand;
+        std::vector<IDeviceObserver*> subscribers[SEVERITY_COUNT];
+    };
+
+    std::vector<Subscription> subscriptions;
+    std::vector<Route> routes;
+    std::unordered_map<std::string, int> routeIndex;   // "type\nbrand" -> routes index
+    int nextSubscriptionId;
+    unsigned long long publishedCount;
+    unsigned long long deliveredCount;
+
+    DeviceEventBus(const DeviceEventBus&);
+    DeviceEventBus& operator=(const DeviceEventBus&);
+
+    void buildRoute(Route& route) const;
+    void rebuildRoutes();
+
+public:
+    DeviceEventBus();
+
+    // Returns a subscription ID for unsubscribe
+    int subscribe(IDeviceObserver* observer, const DeviceEventFilter& filter = DeviceEventFilter());
+    bool unsubscribe(int subscriptionId);
+    // Drops every subscription of observer
+    void unsubscribeAll(IDeviceObserver* observer);
+
+    // Routes the device's events through this bus
+    void attach(Device* device);
+    void detach(Device* device);
+
+    void publish(int route, const DeviceEvent& event);
+
+    size_t getSubscriptionCount() const;
+    size_t getRouteCount() const;
+    unsigned long long getPublishedCount() const;
+    unsigned long long getDeliveredCount() const;
+};
+
+#endif // DEVICEEVENTBUS_H
@@ -0,0 +1,93 @@
+#ifndef DEVICEPOOL_H
+#define DEVICEPOOL_H
+
+#include <cstddef>
+#include <vector>
+
+// Slab allocator for one concrete device type.
+// Objects are carved out of large contiguous slabs, freed objects go on an
+// intrusive freelist, so allocation and release are a pointer pop/push.
+// Devices are only created and destroyed by the controller thread, so the
+// pool does no locking.
+class DevicePool {
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    const char* name;
+    size_t objectSize;
+    size_t slabObjects;        // Objects per slab when the pool grows on its own
+    std::vector<char*> slabs;
+    FreeNode* freeList;
+    size_t freeCount;
+    size_t liveCount;
+    size_t capacity;
+
+    DevicePool(const DevicePool&);
+    DevicePool& operator=(const DevicePool&);
+
+    void addSlab(size_t objects);
+    static std::vector<DevicePool*>& registry();
+
+public:
+    DevicePool(const char* name, size_t objectSize, size_t slabObjects = 256);
+    ~DevicePool();
+
+    void* allocate();
+    void release(void* p);
+
+    // Make sure the next count allocations come from one contiguous slab
+    void reserve(size_t count);
+    // Hands every slab back at once; only possible while no object is alive.
+    // Returns the number of bytes released.
+    size_t trim();
+
+    const char* getName() const;
+    size_t getObjectSize() const;
+    size_t getLiveCount() const;
+    size_t getCapacity() const;
+    size_t getSlabCount() const;
+
+    // Every pool created so far, for statistics and bulk teardown
+    static const std::vector<DevicePool*>& getPools();
+    static size_t trimAll();
+    static void printStats();
+};
+
+// Class-level operator new/delete routing a concrete device type to its pool.
+// Put MSH_POOLED_DEVICE(Type) in the class body and
+// MSH_DEFINE_POOLED_DEVICE(Type) in the .cpp file.
+#define MSH_POOLED_DEVICE(Type)                                  \
+public:                                                          \
+    static DevicePool& pool();                                   \
+    static void* operator new(std::size_t size);                 \
+    static void operator delete(void* p, std::size_t size);      \
+    virtual void reserveClones(size_t count) const;
+
+#define MSH_DEFINE_POOLED_DEVICE(Type)                           \
+    DevicePool& Type::pool() {                                   \
+        static DevicePool instance(#Type, sizeof(Type));         \
+        return instance;                                         \
+    }                                                            \
+    void* Type::operator new(std::size_t size) {                 \
+        if (size != sizeof(Type)) {                              \
+            return ::operator new(size);                         \
+        }                                                        \
+        return pool().allocate();                                \
+    }                                                            \
+    void Type::operator delete(void* p, std::size_t size) {      \
+        if (!p) {                                                \
+            return;                                              \
+        }                                                        \
+        if (size != sizeof(Type)) {                              \
+            ::operator delete(p);                                \
+            return;                                              \
+        }                                                        \
+        pool().release(p);                                       \
+    }                                                            \
+    void Type::reserveClones(size_t count) const {               \
+        pool().reserve(count);                                   \
+    }
+
+#endif // DEVICEPOOL_H
@@ -0,0 +1,74 @@
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class Device;
+
+// Device categories managed by HomeController
+enum DeviceKind {
+    KIND_LIGHT,
+    KIND_CAMERA,
+    KIND_TELEVISION,
+    KIND_SMOKE_DETECTOR,
+    KIND_GAS_DETECTOR,
+    KIND_SOUND_SYSTEM,
+    KIND_COUNT
+};
+
+// Registry of all connected devices.
+// Every device gets a stable integer ID (never reused). Lookups by ID and
+// by name are hash lookups, and the per-kind views are dense vectors.
+// Removal is O(1): the last element of each vector is swapped into the
+// hole, so the order inside a view changes after a removal.
+class DeviceRegistry {
+private:
+    struct Entry {
+        Device* device;
+        DeviceKind kind;
+        size_t allIndex;    // Position in allDevices
+        size_t kindIndex;   // Position in byKind[kind]
+        size_t nameIndex;   // Position in the byName bucket
+    };
+
+    std::unordered_map<int, Entry> entries;
+    std::unordered_map<std::string, std::vector<int> > byName;
+    std::vector<Device*> allDevices;
+    std::vector<Device*> byKind[KIND_COUNT];
+    int nextId;
+
+    DeviceRegistry(const DeviceRegistry&);
+    DeviceRegistry& operator=(const DeviceRegistry&);
+
+    static void swapRemove(std::vector<Device*>& list, size_t index,
+                           std::unordered_map<int, Entry>& entries, size_t Entry::*position);
+
+public:
+    DeviceRegistry();
+    ~DeviceRegistry();
+
+    // Returns the new device ID (also stored in the device)
+    int add(Device* device, DeviceKind kind);
+    // Unregisters without deleting; returns false if the device is unknown
+    bool remove(Device* device);
+    bool remove(int id);
+    void clear();
+    void reserve(DeviceKind kind, size_t count);
+
+    Device* find(int id) const;
+    // Devices of the same model share a name - returns any one of them
+    Device* findByName(const std::string& name) const;
+    std::vector<Device*> findAllByName(const std::string& name) const;
+    bool getKind(int id, DeviceKind& kind) const;
+    // Position of the device inside getDevices(kind); valid until the next add/remove
+    bool getKindIndex(int id, size_t& index) const;
+
+    const std::vector<Device*>& getDevices() const;
+    const std::vector<Device*>& getDevices(DeviceKind kind) const;
+    size_t size() const;
+    size_t size(DeviceKind kind) const;
+};
+
+#endif // DEVICEREGISTRY_H
@@ -0,0 +1,98 @@
+#ifndef DEVICESTATETABLE_H
+#define DEVICESTATETABLE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "DeviceRegistry.h"
+
+class Device;
+
+// Structure-of-arrays store for the hot per-device state.
+// Every Device owns one slot; power and active flags live in packed 64-bit
+// words, levels (brightness / volume) in a byte column, so bulk power
+// changes and status counts touch a few cache lines instead of every
+// device object. Light colours are interned to small ids and the music
+// flag of sound systems is one more bit column, so a mode change can find
+// the devices whose settings differ without visiting the rest. Kind masks
+// are maintained by DeviceRegistry.
+class DeviceStateTable {
+public:
+    typedef unsigned long long Word;
+    static const size_t WORD_BITS = 64;
+
+private:
+    static DeviceStateTable* instance;
+
+    std::vector<Word> usedBits;
+    std::vector<Word> powerBits;
+    std::vector<Word> activeBits;
+    std::vector<Word> registeredBits;           // Slots of devices in a registry
+    std::vector<Word> musicBits;
+    std::vector<Word> kindBits[KIND_COUNT];
+    std::vector<unsigned char> levels;
+    std::vector<unsigned short> colors;         // Index into colorNames
+    std::vector<std::string> colorNames;        // Id 0 is the empty colour
+    std::vector<Device*> owners;                // Slot -> device, for the hooks
+    std::vector<int> freeSlots;
+
+    DeviceStateTable();
+    DeviceStateTable(const DeviceStateTable&);
+    DeviceStateTable& operator=(const DeviceStateTable&);
+
+    static bool testBit(const std::vector<Word>& bits, int slot);
+    static void assignBit(std::vector<Word>& bits, int slot, bool value);
+
+    // Sets/clears power for every slot in mask; hooks run only for slots that flip
+    size_t applyPower(const std::vector<Word>& mask, bool on);
+
+public:
+    static DeviceStateTable* getInstance();
+
+    // Slot lifetime - called from the Device constructor / destructor
+    int acquire(Device* owner);
+    void release(int slot);
+
+    bool isPowered(int slot) const;
+    void setPowered(int slot, bool on);   // Raw bit, no hooks
+    bool isActive(int slot) const;
+    void setActive(int slot, bool active);
+    int getLevel(int slot) const;
+    void setLevel(int slot, int level);   // Clamped to 0-100
+    const std::string& getColor(int slot) const;
+    void setColor(int slot, const std::string& color);
+    bool isPlayingMusic(int slot) const;
+    void setPlayingMusic(int slot, bool playing);
+
+    // Id of a colour name, added on first use
+    int internColor(const std::string& color);
+
+    void setKind(int slot, DeviceKind kind);
+    void clearKind(int slot);
+
+    // Bulk power operations - return how many devices actually changed state
+    size_t setPower(DeviceKind kind, bool on);
+    size_t setPowerAll(bool on);          // Every registered device
+    size_t setPower(const std::vector<Device*>& devices, bool on);
+    size_t setPower(const std::vector<Word>& mask, bool on);
+
+    // Fills mask with the slots of a kind whose power differs from target;
+    // returns how many there are
+    size_t diffPower(DeviceKind kind, bool on, std::vector<Word>& mask) const;
+    // Same for settings: slots whose level differs (level >= 0), whose
+    // colour differs (color >= 0), or that are powered without music (music)
+    size_t diffSettings(DeviceKind kind, int level, int color, bool music,
+                        std::vector<Word>& mask) const;
+
+    // Device in a slot, NULL if the slot is free
+    Device* getOwner(int slot) const;
+
+    // Status queries are popcounts over the bit columns
+    size_t countRegistered() const;
+    size_t countPowered() const;
+    size_t countPowered(DeviceKind kind) const;
+    size_t countFailed() const;
+    size_t getSlotCount() const;
+};
+
+#endif // DEVICESTATETABLE_H
@@ -0,0 +1,97 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+// Binary structured event log, written alongside the text log.
+//
+// File layout: an 8 byte magic followed by length-prefixed records
+//   [varint length][u8 type][varint timestamp delta (us)][body]
+// Each session starts with EVENT_SESSION_START carrying an absolute
+// timestamp; later records store the delta to the previous record.
+// Device names, operations and mode/state names are interned once per
+// session (EVENT_DEFINE_STRING) and referenced by small integer ids.
+class EventLog {
+public:
+    enum EventType {
+        EVENT_SESSION_START = 0,
+        EVENT_DEFINE_STRING = 1,
+        EVENT_MENU_SELECTION = 2,
+        EVENT_DEVICE_OPERATION = 3,
+        EVENT_MODE_CHANGE = 4,
+        EVENT_STATE_CHANGE = 5
+    };
+
+    static const char MAGIC[8];
+
+private:
+    std::ofstream file;
+    std::string buffer;
+    std::unordered_map<std::string, unsigned> stringIds;
+    long long lastTimestamp;
+    bool isOpen;
+    mutable std::mutex mutex;
+
+    static const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    EventLog(const EventLog&);
+    EventLog& operator=(const EventLog&);
+
+    unsigned intern(const std::string& text);
+    void beginRecord(EventType type, long long timestamp, std::string& body);
+    void endRecord(const std::string& body);
+    void writeBuffer();
+
+public:
+    EventLog();
+    ~EventLog();
+
+    bool open(const std::string& fname, long long timestamp);
+    void close();
+    bool isFileOpen() const;
+    void flush();
+
+    void recordMenuSelection(long long timestamp, int option);
+    void recordDeviceOperation(long long timestamp, const std::string& deviceName, const std::string& operation);
+    void recordModeChange(long long timestamp, const std::string& fromMode, const std::string& toMode);
+    void recordStateChange(long long timestamp, const std::string& fromState, const std::string& toState);
+};
+
+// A decoded record with interned ids already resolved
+struct DecodedEvent {
+    EventLog::EventType type;
+    long long timestamp;   // Microseconds since the epoch
+    int number;            // Menu option
+    std::string first;     // Device name / from-mode / from-state
+    std::string second;    // Operation / to-mode / to-state
+
+    DecodedEvent() : type(EventLog::EVENT_SESSION_START), timestamp(0), number(0) {}
+
+    // Same message text Storage writes to msh_log.txt (without the timestamp)
+    std::string toText() const;
+};
+
+// Offline reader used by the msh-eventdump tool
+class EventLogReader {
+private:
+    std::vector<char> data;
+    size_t position;
+    long long lastTimestamp;
+    std::vector<std::string> strings;
+    std::string error;
+
+public:
+    EventLogReader();
+
+    bool open(const std::string& fname);
+    // Returns false at end of file or on a corrupt record (see getError)
+    bool next(DecodedEvent& event);
+    std::string getError() const;
+    size_t getFileSize() const;
+};
+
+#endif // EVENTLOG_H
@@ -14,6 +14,7 @@
 #define GASDETECTOR_H
 
 #include "Detector.h"
+#include "DevicePool.h"
 
 // Base Gas Detector class
 class GasDetector : public Detector {
@@ -30,6 +31,14 @@ public:
     virtual Device* clone() const = 0;
     virtual void detect();
     virtual void trigger(); // Override pure virtual
+    virtual int getReading() const;
+
+protected:
+    virtual void recordLevel(int level);
+    virtual void printAlert(int level) const;
+    virtual const char* detectionMessage() const;
+
+public:
     
     int getGasLevel() const;
     void setGasLevel(int level);  // For simulation
@@ -42,6 +51,7 @@ public:
     NestGasDetector();
     virtual ~NestGasDetector();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(NestGasDetector)
 };
 
 // Concrete Gas Detector - Kidde
@@ -50,6 +60,7 @@ public:
     KiddeGasDetector();
     virtual ~KiddeGasDetector();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(KiddeGasDetector)
 };
 
 #endif // GASDETECTOR_H
@@ -13,6 +13,8 @@
 
 #include <vector>
 #include <string>
+#include <chrono>
+#include "DeviceRegistry.h"
 
 // Forward declarations
 class Device;
@@ -30,27 +32,28 @@ class ModeManager;
 class StateManager;
 class SecuritySystem;
 class NotificationSystem;
+class DeviceEventBus;
+class SensorPipeline;
+class LevelHistory;
 class DeviceFactory;
+class DeviceStateTable;
 class DetectorFactory;
+struct PowerSnapshot;
 
 // Facade Pattern - Main controller for the entire system
 class HomeController {
 private:
-    // Devices organized by type
-    std::vector<Device*> lights;
-    std::vector<Device*> cameras;
-    std::vector<Device*> televisions;
-    std::vector<Device*> smokeDetectors;
-    std::vector<Device*> gasDetectors;
-    std::vector<Device*> soundSystems;
-    std::vector<Device*> allDevices;
+    // All devices, indexed by ID, name and type
+    DeviceRegistry* registry;
     
-    // Light pointers for security/detection systems
+    // Light pointers for security/detection systems, kept in step with the
+    // registry light view by registerDevice/unregisterDevice
     std::vector<Light*> lightPtrs;
     
     // Singleton instances
     Alarm* alarm;
     Storage* storage;
+    DeviceStateTable* stateTable;
     
     // Managers
     Menu* menu;
@@ -60,15 +63,21 @@ private:
     // Systems
     SecuritySystem* securitySystem;
     NotificationSystem* notificationSystem;
+    DeviceEventBus* eventBus;
+    SensorPipeline* sensorPipeline;   // Batched smoke/gas readings
+    LevelHistory* levelHistory;       // Recorded smoke/gas levels
     
     // System state
     bool isRunning;
     
     // Helper methods
     void initializeDefaultDevices();
-    void registerDevice(Device* device);
+    void registerDevice(Device* device, DeviceKind kind);
     void unregisterDevice(Device* device);
-    void updateLightPtrs();
+    static bool kindFromChar(char deviceType, DeviceKind& kind);
+    // Powers devices to match a snapshot in one batch; returns devices changed
+    size_t applySnapshot(const PowerSnapshot& snapshot, const std::string& label);
+    static double millisSince(std::chrono::steady_clock::time_point start);
     
     // Menu handlers
     void handleGetStatus();
@@ -107,6 +116,22 @@ public:
     void addTV(int brandChoice = 1);
     void addDetectorPair(int brandChoice = 1);
     void addSoundSystem(int brandChoice = 1);
+    // Registers prototype plus count-1 clones of it in one pass; returns devices added
+    int provisionDevices(Device* prototype, DeviceKind kind, int count);
+    
+    // Device lookup
+    const DeviceRegistry& getDeviceRegistry() const;
+    // Other components subscribe here for device events
+    DeviceEventBus& getEventBus();
+    // Sites push detector readings here in batches
+    SensorPipeline& getSensorPipeline();
+    LevelHistory& getLevelHistory();
+    Device* findDevice(int deviceId) const;
+    Device* findDeviceByName(const std::string& name) const;
+    
+    // Steps back (or forward) through the state history and restores device
+    // power, mode and system state in one batch; false if there is no entry
+    bool restoreHistory(bool previous);
     
     // Status
     void displayStatus() const;
@@ -0,0 +1,160 @@
+#ifndef LEVELHISTORY_H
+#define LEVELHISTORY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Detector;
+
+struct LevelSample {
+    long long timestamp;   // Microseconds since the epoch
+    int level;
+};
+
+// min/max/avg of the samples in [start, start + period)
+struct LevelRollup {
+    long long start;
+    int min;
+    int max;
+    double avg;
+    unsigned count;
+};
+
+// History of one detector's level with bounded memory.
+//
+// Raw samples go into a ring of fixed-size bit-packed blocks: each block
+// keeps its first sample in the header, then per sample a delta-of-delta
+// timestamp ('0' for a steady interval, otherwise a prefix plus 8/16/32/64
+// bits) and the level ('0' if unchanged, else '1' + 7 bits). When all
+// MAX_BLOCKS are full the oldest block is reused. Alongside, 1s/1m/1h
+// rollup rings keep min/max/sum/count buckets for longer than the raw data.
+// Timestamps must not go backwards; an older one is stored as the last one.
+class LevelSeries {
+public:
+    enum Resolution {
+        ROLLUP_1S,
+        ROLLUP_1M,
+        ROLLUP_1H,
+        ROLLUP_COUNT
+    };
+
+    static const size_t BLOCK_BYTES = 256;
+    static const size_t MAX_BLOCKS = 16;
+    static const size_t MAX_SAMPLE_BITS = 4 + 64 + 8;
+
+private:
+    struct Block {
+        long long firstTime;
+        long long lastTime;
+        long long lastDelta;
+        unsigned bitCount;
+        unsigned count;
+        unsigned char firstLevel;
+        unsigned char lastLevel;
+        unsigned char bits[BLOCK_BYTES + 8];   // Slack for word-sized writes
+    };
+
+    struct Bucket {
+        long long start;
+        unsigned long long sum;
+        unsigned count;
+        unsigned char min;
+        unsigned char max;
+    };
+
+    static const size_t SLOTS_1S = 60;   // Last minute
+    static const size_t SLOTS_1M = 60;   // Last hour
+    static const size_t SLOTS_1H = 24;   // Last day
+
+    std::string name;
+    std::vector<Block> blocks;       // Ring, grows up to MAX_BLOCKS
+    size_t oldest;                   // Index of the oldest block
+    unsigned long long totalCount;   // Samples ever appended (incl. evicted)
+
+    Bucket bucketsSecond[SLOTS_1S];
+    Bucket bucketsMinute[SLOTS_1M];
+    Bucket bucketsHour[SLOTS_1H];
+    size_t heads[ROLLUP_COUNT];      // Newest bucket per ring
+    size_t used[ROLLUP_COUNT];
+
+    Block& newestBlock();
+    const Block& blockAt(size_t age) const;   // 0 = oldest
+    Block& startBlock(long long timestamp, int level);
+    static void addToRing(Bucket* buckets, size_t slots, long long period, size_t& head, size_t& count,
+                          long long timestamp, int level);
+    void addToRollups(long long timestamp, int level);
+    Bucket* ring(Resolution resolution, size_t& slots);
+    const Bucket* ring(Resolution resolution, size_t& slots) const;
+    void decodeBlock(const Block& block, long long from, long long to, std::vector<LevelSample>& out) const;
+
+public:
+    explicit LevelSeries(const std::string& seriesName = "");
+
+    void append(long long timestamp, int level);
+    void clear();
+
+    // Retained raw samples in [from, to], oldest first; returns how many were added
+    size_t getSamples(long long from, long long to, std::vector<LevelSample>& out) const;
+    // Rollup buckets starting in [from, to], oldest first
+    size_t getRollups(Resolution resolution, long long from, long long to, std::vector<LevelRollup>& out) const;
+    // One rollup over all buckets starting in [from, to]; false if there are none
+    bool summarize(Resolution resolution, long long from, long long to, LevelRollup& out) const;
+
+    const std::string& getName() const;
+    bool isEmpty() const;
+    long long getFirstTime() const;   // Oldest retained raw sample
+    long long getLastTime() const;
+    int getLastLevel() const;
+    size_t getSampleCount() const;    // Retained raw samples
+    unsigned long long getTotalCount() const;
+    size_t getEncodedBytes() const;
+    size_t getMemoryBytes() const;
+
+    void serialize(std::string& out) const;
+    // Replaces this series with a serialized one; leaves it untouched on bad input
+    bool deserialize(const char* data, size_t size);
+
+    static long long periodOf(Resolution resolution);
+    static const char* resolutionName(Resolution resolution);
+};
+
+// Level history of every attached detector, keyed by device ID.
+//
+// Detectors feed their series through Detector::levelChanged (setter path,
+// wall-clock timestamps) and SensorPipeline::ingest (reading timestamps).
+// save()/load() write all series to one file:
+//   [8 byte magic] then per series [u32 length][u32 CRC-32][payload]
+//   payload = [varint device ID][varint len + name][LevelSeries::serialize]
+// On load a series is only restored into a detector with the same ID and
+// name; a damaged record is skipped. Detectors must be detached or
+// destroyed before the history is.
+class LevelHistory {
+private:
+    std::vector<LevelSeries*> byId;   // Device ID -> series, NULL if none
+    size_t seriesCount;
+
+    LevelHistory(const LevelHistory&);
+    LevelHistory& operator=(const LevelHistory&);
+
+public:
+    static const char MAGIC[8];
+    static const char* DEFAULT_PATH;
+
+    LevelHistory();
+    ~LevelHistory();
+
+    // The detector must already have its registry ID
+    void attach(Detector* detector);
+    void detach(Detector* detector);
+    LevelSeries* find(int deviceId) const;
+
+    bool save(const std::string& fname) const;
+    // Returns false if the file could not be read; restored counts the series taken over
+    bool load(const std::string& fname, size_t& restored);
+
+    size_t size() const;
+    size_t getMemoryBytes() const;
+};
+
+#endif // LEVELHISTORY_H
@@ -2,14 +2,11 @@
 #define LIGHT_H
 
 #include "Device.h"
+#include "DevicePool.h"
 #include <string>
 
 // Base Light class
 class Light : public Device {
-protected:
-    std::string color;
-    int brightness;  // 0-100
-
 public:
     Light(const std::string& brand, const std::string& model);
     virtual ~Light();
@@ -37,6 +34,7 @@ public:
     PhilipsHueLight();
     virtual ~PhilipsHueLight();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(PhilipsHueLight)
 };
 
 // Concrete Light classes - IKEA Tradfri
@@ -45,6 +43,7 @@ public:
     IKEATradfriLight();
     virtual ~IKEATradfriLight();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(IKEATradfriLight)
 };
 
 #endif // LIGHT_H
@@ -0,0 +1,24 @@
+/**
+ * @file LightBlinkHandler.h
+ * @brief Handler that blinks every light in the security sequence
+ *
+ * @patterns Chain of Responsibility
+ */
+
+#ifndef LIGHTBLINKHANDLER_H
+#define LIGHTBLINKHANDLER_H
+
+#include "SecurityHandler.h"
+#include "Light.h"
+#include <vector>
+
+class LightBlinkHandler : public SecurityHandler {
+private:
+    const std::vector<Light*>* lights;   // Owned by HomeController
+
+public:
+    LightBlinkHandler(const std::vector<Light*>* lights);
+    virtual void handle(const SecurityEvent& event);
+};
+
+#endif // LIGHTBLINKHANDLER_H
@@ -0,0 +1,83 @@
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <string>
+#include <map>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file (falls back to reading it into memory)
+class MappedFile {
+private:
+    const char* data;
+    size_t size;
+    bool mapped;   // true = mmap, false = heap copy
+#ifndef _WIN32
+    int fd;
+#endif
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+    const char* getData() const;
+    size_t getSize() const;
+};
+
+// Filter for LogReader::query - empty fields match everything
+struct LogQuery {
+    long long fromTime;    // Inclusive, see LogReader::parseTime
+    long long toTime;      // Inclusive
+    std::string level;     // "ALERT", "INFO", ...
+    std::string device;    // Device name as written by Storage::logDeviceOperation
+    std::string text;      // Free substring
+
+    LogQuery();
+};
+
+// Callback receiving each matching line (without the trailing newline)
+class LogLineSink {
+public:
+    virtual ~LogLineSink() {}
+    virtual void onLine(const char* line, size_t length) = 0;
+};
+
+// Query engine over msh_log.txt-style files ("[timestamp] [LEVEL] message").
+// Nothing is indexed up front: binary search on time probes byte offsets,
+// resynchronises to the next line, and remembers every timestamp it parsed
+// so later queries on the same file start from a denser index.
+class LogReader {
+private:
+    MappedFile file;
+    std::map<size_t, long long> timeIndex;   // line offset -> parsed time (lazy)
+
+    size_t lineStartAtOrAfter(size_t offset) const;
+    size_t lineEnd(size_t offset) const;
+    bool lineTime(size_t offset, long long& time);
+    size_t lowerBound(long long time);
+
+public:
+    static const long long NO_TIME;
+
+    bool open(const std::string& path);
+    size_t getSize() const;
+    size_t getIndexedLines() const;
+
+    // Returns the number of matching lines (each is passed to sink if given)
+    size_t query(const LogQuery& q, LogLineSink* sink);
+
+    // Timestamp prefix of a line ("Tue Nov 25 21:33:31 2025" or
+    // "2025-11-25T21:33:31.123456") as comparable microseconds. Also accepts
+    // "2025-11-25 21:33:31" for command-line input. Returns NO_TIME if invalid.
+    static long long parseTime(const char* text, size_t length);
+
+    // Substring search, SSE2-accelerated where available
+    static const char* findSubstring(const char* haystack, size_t haystackLength,
+                                     const char* needle, size_t needleLength);
+};
+
+#endif // LOGREADER_H
@@ -0,0 +1,55 @@
+#ifndef LOGRINGBUFFER_H
+#define LOGRINGBUFFER_H
+
+#include <string>
+#include <cstddef>
+#include <atomic>
+
+// A single queued log line waiting for the background writer
+struct LogRecord {
+    long long timestamp;  // Microseconds since the epoch
+    std::string message;
+
+    LogRecord() : timestamp(0) {}
+};
+
+// Bounded lock-free ring buffer (multi-producer / multi-consumer).
+// Each slot carries a sequence number so producers and the writer thread
+// never take a lock; slot strings are reused so steady-state pushes do not
+// allocate once every slot has grown to the typical line length.
+class LogRingBuffer {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    static const size_t CACHE_LINE = 64;
+
+    Slot* slots;
+    size_t capacity;   // always a power of two
+    size_t mask;
+
+    // Keep producer and consumer cursors on separate cache lines
+    char padding0[CACHE_LINE];
+    std::atomic<size_t> enqueuePos;
+    char padding1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeuePos;
+    char padding2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    LogRingBuffer(const LogRingBuffer&);
+    LogRingBuffer& operator=(const LogRingBuffer&);
+
+public:
+    explicit LogRingBuffer(size_t requestedCapacity);
+    ~LogRingBuffer();
+
+    // Returns false when the buffer is full (caller decides how to back off)
+    bool tryPush(long long timestamp, const std::string& message);
+    // Returns false when the buffer is empty
+    bool tryPop(LogRecord& out);
+
+    size_t getCapacity() const;
+};
+
+#endif // LOGRINGBUFFER_H
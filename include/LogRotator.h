@@ -0,0 +1,81 @@
+#ifndef LOGROTATOR_H
+#define LOGROTATOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// One closed log segment as listed in the manifest
+struct LogSegment {
+    unsigned sequence;
+    std::string firstTime;   // ISO-8601 local time of the first line
+    std::string lastTime;    // ISO-8601 local time of the last line
+    std::string path;        // Segment file (".gz" once compressed)
+
+    LogSegment() : sequence(0) {}
+};
+
+// Manifest of closed segments ("msh_log.manifest"), one tab-separated
+// line per segment: sequence, first time, last time, path.
+// The active log file itself is never listed - it is always the newest.
+class LogManifest {
+public:
+    static std::string manifestPath(const std::string& logFilename);
+    static bool load(const std::string& path, std::vector<LogSegment>& segments);
+    static bool save(const std::string& path, const std::vector<LogSegment>& segments);
+    // Segments whose [firstTime, lastTime] overlaps the given range (LogReader::parseTime units)
+    static std::vector<LogSegment> findSegments(const std::vector<LogSegment>& segments,
+                                                long long fromTime, long long toTime);
+};
+
+// Size/age based log rotation for Storage.
+// Storage closes, renames and reopens the active file itself (a few cheap
+// syscalls on the writing thread); compression, pruning of old segments and
+// manifest updates run on the rotator's own background thread.
+class LogRotator {
+private:
+    size_t maxBytes;         // 0 = no size limit
+    int maxAgeSeconds;       // 0 = no age limit
+    int maxSegments;         // Closed segments kept on disk
+    bool compress;
+
+    std::string logFilename;
+    std::string manifestFile;
+    unsigned nextSequence;
+    std::vector<LogSegment> segments;   // Owned by the background thread once running
+
+    std::thread worker;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<LogSegment> jobs;
+    bool running;
+    bool stopRequested;
+
+    LogRotator(const LogRotator&);
+    LogRotator& operator=(const LogRotator&);
+
+    void workerLoop();
+    void processSegment(LogSegment segment);
+
+public:
+    LogRotator();
+    ~LogRotator();
+
+    void setPolicy(size_t maxBytes, int maxAgeSeconds, int maxSegments, bool compress);
+    bool isEnabled() const;
+    static bool isCompressionAvailable();
+
+    void start(const std::string& filename);
+    void stop();   // Finishes pending compression before returning
+
+    bool shouldRotate(size_t segmentBytes, long long segmentOpenedAt, long long now) const;
+    // Path the active file should be renamed to for the next rotation
+    std::string nextSegmentPath();
+    // Hands a renamed segment to the background thread
+    void segmentClosed(const std::string& path, long long firstTime, long long lastTime);
+};
+
+#endif // LOGROTATOR_H
@@ -14,6 +14,9 @@
 #define MENU_H
 
 #include <string>
+#include <vector>
+
+class ModeState;
 
 // Command Pattern - Menu commands
 class MenuCommand {
@@ -42,7 +45,7 @@ public:
     void displayRemoveDeviceSubmenu() const;
     void displayPowerOnSubmenu() const;
     void displayPowerOffSubmenu() const;
-    void displayModeSubmenu() const;
+    void displayModeSubmenu(const std::vector<ModeState*>& modes) const;
     void displayStateSubmenu() const;
     
     int getMenuChoice() const;
@@ -0,0 +1,34 @@
+#ifndef MODECONFIG_H
+#define MODECONFIG_H
+
+#include <string>
+#include <vector>
+
+class ModeState;
+
+// JSON mode file ("msh_modes.json", or the path in MSH_MODES):
+//
+// { "modes": [ { "key": "R", "name": "Reading", "description": "...",
+//                "lights": { "power": true, "brightness": 60, "color": "warm" },
+//                "tvs": { "power": false },
+//                "soundSystems": { "power": true, "volume": 20, "music": true },
+//                "devices": [ { "name": "Bose Smart Soundbar 900", "power": false } ] } ] }
+//
+// A group left out of a mode is not touched by it. The file is parsed once
+// into ModePlans; nothing is read from the JSON while a mode is applied.
+class ModeConfig {
+public:
+    static const char* DEFAULT_PATH;
+
+    // Path from MSH_MODES, or DEFAULT_PATH
+    static std::string configuredPath();
+
+    // Parses path into newly allocated modes owned by the caller.
+    // On failure nothing is returned in modes and error says why.
+    static bool load(const std::string& path, std::vector<ModeState*>& modes, std::string& error);
+
+    // Modification time of path, -1 if it does not exist
+    static long long fileStamp(const std::string& path);
+};
+
+#endif // MODECONFIG_H
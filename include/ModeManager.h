@@ -14,29 +14,63 @@
 #include <string>
 #include <vector>
 
+#include "DeviceRegistry.h"
+#include "DeviceStateTable.h"
+
 // Forward declarations
 class Device;
-class Light;
-class Television;
-class SoundSystem;
+
+// Target state of one device group (or one device) within a mode
+struct ModeTarget {
+    bool managed;        // false leaves power alone
+    bool power;
+    int level;           // Brightness / volume, -1 leaves it alone
+    std::string color;   // Lights only - empty leaves the colour alone
+    bool playMusic;      // Sound systems only
+
+    ModeTarget();
+};
+
+// Per-device exception to the group targets, matched by device name
+struct ModeOverride {
+    std::string deviceName;
+    ModeTarget target;
+};
+
+// Compiled mode: one target per device group plus per-device overrides.
+// ModeManager diffs it against the DeviceStateTable and only touches
+// devices whose state differs.
+struct ModePlan {
+    enum Group {
+        GROUP_LIGHT,
+        GROUP_TV,
+        GROUP_SOUND,
+        GROUP_COUNT
+    };
+
+    ModeTarget targets[GROUP_COUNT];
+    std::vector<ModeOverride> overrides;
+
+    static DeviceKind kindOf(Group group);
+};
 
 // State Pattern - Mode States
 class ModeState {
 protected:
     std::string modeName;
-    bool lightOn;
-    bool tvOn;
-    bool musicOn;
+    char key;                 // Menu selection character
+    std::string description;
+    ModePlan plan;
 
 public:
-    ModeState(const std::string& name, bool light, bool tv, bool music);
+    ModeState(const std::string& name, char key, bool light, bool tv, bool music);
+    ModeState(const std::string& name, char key, const std::string& description, const ModePlan& plan);
     virtual ~ModeState();
     
-    virtual void apply(std::vector<Device*>& lights, 
-                      std::vector<Device*>& tvs,
-                      std::vector<Device*>& soundSystems) = 0;
-    
     std::string getName() const;
+    char getKey() const;
+    std::string getDescription() const;   // Generated from the plan when not given
+    const ModePlan& getPlan() const;
     bool isLightOn() const;
     bool isTVOn() const;
     bool isMusicOn() const;
@@ -44,56 +78,80 @@ public:
     virtual void display() const;
 };
 
-// Concrete Mode States
+// Built-in modes, used when no mode file is present
 class NormalMode : public ModeState {
 public:
     NormalMode();
-    virtual void apply(std::vector<Device*>& lights, 
-                      std::vector<Device*>& tvs,
-                      std::vector<Device*>& soundSystems);
 };
 
 class EveningMode : public ModeState {
 public:
     EveningMode();
-    virtual void apply(std::vector<Device*>& lights, 
-                      std::vector<Device*>& tvs,
-                      std::vector<Device*>& soundSystems);
 };
 
 class PartyMode : public ModeState {
 public:
     PartyMode();
-    virtual void apply(std::vector<Device*>& lights, 
-                      std::vector<Device*>& tvs,
-                      std::vector<Device*>& soundSystems);
 };
 
 class CinemaMode : public ModeState {
 public:
     CinemaMode();
-    virtual void apply(std::vector<Device*>& lights, 
-                      std::vector<Device*>& tvs,
-                      std::vector<Device*>& soundSystems);
+};
+
+// Mode defined in the mode file (see ModeConfig)
+class ConfiguredMode : public ModeState {
+public:
+    ConfiguredMode(const std::string& name, char key, const std::string& description, const ModePlan& plan);
 };
 
 // Mode Manager - Context class for State Pattern
 class ModeManager {
 private:
+    static const int KEY_SLOTS = 128;
+
     ModeState* currentMode;
-    NormalMode* normalMode;
-    EveningMode* eveningMode;
-    PartyMode* partyMode;
-    CinemaMode* cinemaMode;
+    std::vector<ModeState*> modes;
+    ModeState* modesByKey[KEY_SLOTS];   // Upper-case key -> mode
+
+    std::string configPath;
+    long long configStamp;              // Modification time of the loaded file, -1 if none
+
+    DeviceStateTable* stateTable;
+    std::vector<DeviceStateTable::Word> diffMask;      // Reused between applications
+    std::vector<DeviceStateTable::Word> overrideMask;  // Slots with a per-device power override
+
+    // Device matched by a per-device override, with its merged target
+    struct ResolvedOverride {
+        Device* device;
+        DeviceKind kind;
+        ModeTarget target;
+    };
+    std::vector<ResolvedOverride> resolved;
+
+    void installModes(const std::vector<ModeState*>& newModes);
+    void deleteModes();
+    size_t applyTarget(const ModeTarget& target, DeviceKind kind);
+    size_t applySettings(Device* device, DeviceKind kind, const ModeTarget& target);
 
 public:
     ModeManager();
     ~ModeManager();
 
+    // Replaces the built-in modes with the ones in a JSON mode file.
+    // Returns false (keeping the current modes) if it is missing or invalid.
+    bool loadModes(const std::string& path);
+    // Reloads the mode file if it changed on disk since it was loaded
+    bool reloadIfChanged();
+
     void setMode(char modeChar);
-    void applyMode(std::vector<Device*>& lights, 
-                   std::vector<Device*>& tvs,
-                   std::vector<Device*>& soundSystems);
+    // Selects a mode without applying it (state restore); false if unknown
+    bool setModeByName(const std::string& name);
+    const std::vector<ModeState*>& getModes() const;
+
+    // Brings every registered light, TV and sound system to the current
+    // mode's targets; returns the number of transitions issued
+    size_t applyMode(const DeviceRegistry& registry);
     
     ModeState* getCurrentMode() const;
     std::string getCurrentModeName() const;
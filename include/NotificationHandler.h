@@ -0,0 +1,27 @@
+/**
+ * @file NotificationHandler.h
+ * @brief Handler that passes a security event to the notification channels
+ *
+ * @patterns Chain of Responsibility
+ */
+
+#ifndef NOTIFICATIONHANDLER_H
+#define NOTIFICATIONHANDLER_H
+
+#include "SecurityHandler.h"
+
+class NotificationSystem;
+
+// Only enqueues; delivery happens on the notification worker threads
+class NotificationHandler : public SecurityHandler {
+private:
+    NotificationSystem* notifications;
+    std::string label;     // Reused per event
+    std::string message;
+
+public:
+    NotificationHandler(NotificationSystem* notifications);
+    virtual void handle(const SecurityEvent& event);
+};
+
+#endif // NOTIFICATIONHANDLER_H
@@ -0,0 +1,108 @@
+#ifndef NOTIFICATIONQUEUE_H
+#define NOTIFICATIONQUEUE_H
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+class NotificationStrategy;
+
+// A failure notification waiting for its channel
+struct PendingNotification {
+    std::string deviceName;
+    std::string message;
+};
+
+// Counters for one channel, read by NotificationSystem::displayStatus
+struct NotificationQueueStats {
+    size_t capacity;
+    size_t depth;                    // Waiting right now
+    unsigned long long accepted;
+    unsigned long long delivered;
+    unsigned long long dropped;
+    unsigned long long blocked;      // Posts that had to wait for room
+    unsigned long long rateLimited;  // Refused by the token bucket
+
+    NotificationQueueStats()
+        : capacity(0), depth(0), accepted(0), delivered(0), dropped(0), blocked(0), rateLimited(0) {}
+};
+
+// Token bucket: holds up to burst tokens and refills at rate tokens per
+// second; every notification takes one. A rate of 0 means no limit.
+class TokenBucket {
+private:
+    double rate;
+    double burst;
+    double tokens;
+    std::chrono::steady_clock::time_point lastRefill;
+
+public:
+    TokenBucket();
+    void configure(double ratePerSecond, double burstSize);
+    bool tryTake(std::chrono::steady_clock::time_point now);
+    bool isLimited() const;
+    double getRate() const;
+    double getBurst() const;
+};
+
+// Bounded queue with its own worker thread in front of one strategy.
+// post() only copies the text under a short lock, so the thread that raised
+// the failure never waits for the channel itself. When the queue is full the
+// overflow policy decides what happens to the new notification.
+class NotificationQueue {
+public:
+    enum OverflowPolicy {
+        DROP_NEWEST,    // Keep what is queued, discard the new one
+        DROP_OLDEST,    // Discard the oldest queued one to make room
+        BLOCK           // Wait up to blockTimeoutMs for room, then drop the new one
+    };
+
+private:
+    NotificationStrategy* strategy;
+    size_t capacity;
+    OverflowPolicy policy;
+    int blockTimeoutMs;
+    TokenBucket bucket;
+
+    std::thread worker;
+    mutable std::mutex queueMutex;
+    std::condition_variable itemReady;
+    std::condition_variable spaceFree;
+    std::condition_variable idle;
+    std::deque<PendingNotification> pending;
+    bool delivering;
+    bool stopRequested;
+
+    unsigned long long accepted;
+    unsigned long long delivered;
+    unsigned long long dropped;
+    unsigned long long blocked;
+    unsigned long long rateLimited;
+
+    NotificationQueue(const NotificationQueue&);
+    NotificationQueue& operator=(const NotificationQueue&);
+
+    void workerLoop();
+
+public:
+    NotificationQueue(NotificationStrategy* strategy, size_t capacity, OverflowPolicy policy,
+                      int blockTimeoutMs = 0);
+    ~NotificationQueue();   // Delivers what is still queued, then joins the worker
+
+    // Returns false when the notification was rate limited or dropped.
+    // Summaries pass bypassLimit so a burst is never hidden entirely.
+    bool post(const std::string& deviceName, const std::string& message, bool bypassLimit = false);
+    void setRateLimit(double ratePerSecond, double burst);
+    // Waits until everything posted so far has been delivered or dropped
+    void flush();
+
+    NotificationQueueStats getStats() const;
+    OverflowPolicy getPolicy() const;
+    std::string describeLimit() const;
+    static const char* policyName(OverflowPolicy p);
+};
+
+#endif // NOTIFICATIONQUEUE_H
@@ -2,8 +2,15 @@
 #define NOTIFICATIONSYSTEM_H
 
 #include "Device.h"
+#include "NotificationQueue.h"
 #include <string>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
 
 // Strategy Pattern - Notification strategies
 class NotificationStrategy {
@@ -31,33 +38,130 @@ public:
     virtual void notify(const std::string& deviceName, const std::string& message);
 };
 
+// Where SMSNotification hands its text; a real provider blocks on the network
+class SmsGateway {
+public:
+    virtual ~SmsGateway();
+    virtual bool send(const std::string& phone, const std::string& text) = 0;
+};
+
+// In-process stand-in for a provider: send() sleeps for the configured
+// latency (MSH_SMS_LATENCY_MS, default 0) and then prints the message
+class StubSmsGateway : public SmsGateway {
+private:
+    std::atomic<int> latencyMs;
+    std::atomic<unsigned long long> sentCount;
+
+public:
+    StubSmsGateway();
+    virtual bool send(const std::string& phone, const std::string& text);
+
+    void setLatency(int ms);
+    int getLatency() const;
+    unsigned long long getSentCount() const;
+};
+
 class SMSNotification : public NotificationStrategy {
 private:
+    SmsGateway* gateway;
+    std::mutex phoneMutex;   // notify() runs on the SMS worker thread
     std::string phoneNumber;
 public:
-    SMSNotification(const std::string& phone = "+90-555-123-4567");
+    SMSNotification(SmsGateway* gateway, const std::string& phone = "+90-555-123-4567");
     virtual void notify(const std::string& deviceName, const std::string& message);
     void setPhoneNumber(const std::string& phone);
 };
 
-// Observer Pattern - Notification System as Observer
+// Counters for the coalescing stage in front of the channel queues
+struct NotificationCounters {
+    unsigned long long received;     // onDeviceFailure calls
+    unsigned long long forwarded;    // Passed on to the channels individually
+    unsigned long long coalesced;    // Same device and message again within the window
+    unsigned long long summarized;   // Folded into a summary instead
+    unsigned long long summaries;
+
+    NotificationCounters() : received(0), forwarded(0), coalesced(0), summarized(0), summaries(0) {}
+};
+
+// Observer Pattern - Notification System as Observer.
+// Every strategy sits behind its own NotificationQueue and worker thread, so
+// onDeviceFailure only enqueues and returns; a slow channel (SMS) fills and
+// then drops from its own queue without delaying the others.
+//
+// Failures are coalesced first: a repeat of the same (device, message) within
+// the window is only counted, and once SUMMARY_AFTER devices have failed in
+// one window the rest are held back and reported together as
+// "N devices failed in the last 10s" when the window closes. Each channel
+// then applies its own token bucket (summaries are never rate limited).
 class NotificationSystem : public IDeviceObserver {
 private:
-    std::vector<NotificationStrategy*> strategies;
+    std::vector<NotificationQueue*> strategies;   // Enabled channels, guarded by dispatchMutex
     bool logEnabled;
     bool alarmEnabled;
     bool smsEnabled;
     
+    StubSmsGateway* smsGateway;
     LogNotification* logStrategy;
     AlarmNotification* alarmStrategy;
     SMSNotification* smsStrategy;
 
+    NotificationQueue* logQueue;
+    NotificationQueue* alarmQueue;
+    NotificationQueue* smsQueue;
+
+    static const size_t CHANNEL_COUNT = 3;
+    static const size_t QUEUE_CAPACITY = 64;
+    static const int ALARM_BLOCK_MS = 5;
+    static const size_t SUMMARY_AFTER = 3;
+    static const int DEFAULT_WINDOW_MS = 10000;
+    static const int LOG_BURST = 20;
+    static const int ALARM_BURST = 5;
+    static const int SMS_BURST = 3;
+
+    // Coalescing state; the summary thread closes each window on time
+    mutable std::mutex dispatchMutex;
+    std::condition_variable windowWakeup;
+    std::thread summaryThread;
+    bool stopRequested;
+    int windowMs;
+    bool windowOpen;
+    std::chrono::steady_clock::time_point windowEnd;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastForwarded;
+    std::unordered_set<std::string> windowDevices;
+    size_t windowHeld;
+    std::string keyBuffer;
+    std::string labelBuffer;
+    std::string messageBuffer;
+    NotificationCounters counters;
+
+    void enableChannel(NotificationQueue* queue, bool& enabled, bool enable, const char* label);
+    // Caller holds dispatchMutex; fill targets with the channels to post to
+    // once it is released and return how many (0 if coalesced or held back)
+    size_t dispatchFailure(const std::string& deviceName, const std::string& message, NotificationQueue** targets);
+    size_t closeWindow(std::chrono::steady_clock::time_point now, std::string& summaryText,
+                       NotificationQueue** targets);
+    static void postAll(NotificationQueue* const* targets, size_t count, const std::string& deviceName,
+                        const std::string& message, bool bypassLimit);
+    void summaryLoop();
+
 public:
     NotificationSystem();
-    virtual ~NotificationSystem();
+    virtual ~NotificationSystem();   // Delivers queued notifications first
     
     // IDeviceObserver implementation
     virtual void onDeviceFailure(const std::string& deviceName, const std::string& message);
+    virtual void onDeviceEvent(const DeviceEvent& event);
+
+    // Emits a pending summary now, then waits until every queued
+    // notification has been delivered or dropped
+    void flush();
+
+    // Coalescing window (MSH_NOTIFY_WINDOW_MS, default 10 s)
+    void setCoalesceWindow(int ms);
+    int getCoalesceWindow() const;
+    // Token bucket refill rates per channel (default 10/s, 1/s, 6/min); 0 disables a limit
+    void setRateLimits(double logPerSecond, double alarmPerSecond, double smsPerSecond);
+    NotificationCounters getCounters() const;
     
     // Enable/disable notifications
     void enableLog(bool enable);
@@ -70,6 +174,7 @@ public:
     bool isSMSEnabled() const;
     
     void setPhoneNumber(const std::string& phone);
+    StubSmsGateway* getSmsGateway() const;
     void displayStatus() const;
 };
 
@@ -0,0 +1,65 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <string>
+#include <ostream>
+
+// Singleton Pattern - destination for the per-device console chatter
+// (power changes, mode/state progress, security notices).
+// Status reports, menu feedback and alarms keep writing to std::cout.
+class OutputSink {
+public:
+    enum Mode {
+        OUTPUT_SILENT,     // Drop everything
+        OUTPUT_BUFFERED,   // Per-device lines inside a batch become one summary line
+        OUTPUT_VERBOSE     // Every line, as before
+    };
+
+private:
+    static OutputSink* instance;
+    Mode mode;
+    std::ostream nullStream;   // No streambuf - badbit stays set, so writes skip formatting
+
+    int batchDepth;
+    std::string batchLabel;
+    size_t batchPoweredOn;
+    size_t batchPoweredOff;
+
+    OutputSink();
+    OutputSink(const OutputSink&);
+    OutputSink& operator=(const OutputSink&);
+
+public:
+    static OutputSink* getInstance();
+
+    // Shorthand for getInstance()->stream()
+    static std::ostream& out();
+
+    // Initial mode comes from MSH_OUTPUT=silent|buffered|verbose (default verbose)
+    void setMode(Mode newMode);
+    Mode getMode() const;
+    static bool parseMode(const std::string& text, Mode& result);
+    static const char* modeName(Mode m);
+
+    // Where a line should go right now
+    std::ostream& stream();
+    bool isEnabled() const;
+
+    // Bulk operations bracket their work; batches may nest
+    void beginBatch(const std::string& label);
+    void endBatch();
+    void notePowerChange(bool on);
+};
+
+// RAII helper: OutputBatch batch("[MODE] Applying Party Mode");
+class OutputBatch {
+private:
+    OutputBatch(const OutputBatch&);
+    OutputBatch& operator=(const OutputBatch&);
+
+public:
+    explicit OutputBatch(const std::string& label);
+    ~OutputBatch();
+};
+
+#endif // OUTPUTSINK_H
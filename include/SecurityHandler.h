@@ -1,6 +1,6 @@
 /**
  * @file SecurityHandler.h
- * @brief Abstract Handler interface for Chain of Responsibility
+ * @brief Abstract Handler interface for the security rule engine
  * @version 5.0
  * @date 03/12/2025
  *
@@ -13,17 +13,39 @@
 #ifndef SECURITYHANDLER_H
 #define SECURITYHANDLER_H
 
+#include <string>
+
+enum SecurityEventType {
+    SECURITY_MOTION,      // A camera saw motion
+    SECURITY_DETECTION,   // A smoke/gas detector went from clear to alert
+    SECURITY_EVENT_COUNT
+};
+
+// What SecuritySystem queues and hands to each stage
+struct SecurityEvent {
+    SecurityEventType type;
+    std::string source;   // Device name
+    int deviceId;
+    int value;            // Detection level, 0 for motion
+    long long queuedAt;   // steady_clock nanoseconds, set by SecuritySystem::post
+
+    SecurityEvent(SecurityEventType t = SECURITY_MOTION, const std::string& src = "", int id = -1, int v = 0)
+        : type(t), source(src), deviceId(id), value(v), queuedAt(0) {}
+};
+
+// One stage of the security sequence. SecuritySystem decides which stages
+// run for an event (its rules) and in which order; a stage only acts.
 class SecurityHandler
 {
 protected:
-    SecurityHandler *next;
+    std::string name;
 
 public:
-    SecurityHandler();
+    explicit SecurityHandler(const std::string &name);
     virtual ~SecurityHandler();
 
-    void setNext(SecurityHandler *nextHandler);
-    virtual void handleRequest();
+    virtual void handle(const SecurityEvent &event) = 0;
+    const std::string &getName() const;
 };
 
 #endif // SECURITYHANDLER_H
@@ -7,32 +7,132 @@
  * @authors
  * - 220201047: Security System - Chain of Responsibility Manager
 
- * @patterns Chain of Responsibility, Facade (Subsystem)
+ * @patterns Chain of Responsibility, Facade (Subsystem), Observer
  */
 
 #ifndef SECURITYSYSTEM_H
 #define SECURITYSYSTEM_H
 
-#include "Alarm.h"
-#include "Light.h"
+#include "Device.h"
+#include "SecurityHandler.h"
+#include <deque>
+#include <string>
 #include <vector>
 
-class SecuritySystem
+class Alarm;
+class Light;
+class DeviceRegistry;
+class NotificationSystem;
+
+// Latency of one stage of the security sequence
+struct SecurityStageMetrics {
+    std::string stage;
+    unsigned long long calls;
+    long long totalNanos;
+    long long maxNanos;
+
+    SecurityStageMetrics() : calls(0), totalNanos(0), maxNanos(0) {}
+};
+
+// Security rule engine. Events (motion from simulateMotionDetection,
+// detections from the DeviceEventBus) go into a queue and are handled in
+// order. Rules say which handler runs for which event type; they are
+// compiled into one stage list per event type, so an event only looks at
+// its own stages. A handler that posts an event while running gets it
+// handled after the current one. Every stage is timed.
+//
+// Default rules: motion (armed only) -> alarm, light blink, notification,
+// camera recording; detection (always) -> alarm, light blink. Detections
+// are already notified by the NotificationSystem's own subscription.
+class SecuritySystem : public IDeviceObserver
 {
+public:
+    struct Rule {
+        SecurityEventType type;
+        SecurityHandler *handler;
+        bool armedOnly;   // Skipped while the system is disarmed
+        int minValue;     // Skipped for events with a lower value
+    };
+
+    static const size_t MAX_QUEUED = 256;
+
 private:
-    Alarm *alarm;
-    std::vector<Light *> *lights;
+    struct Stage {
+        SecurityHandler *handler;
+        size_t metric;    // Index into handlers / handlerStats
+        bool armedOnly;
+        int minValue;
+    };
+
+    struct Latency {
+        unsigned long long calls;
+        long long totalNanos;
+        long long maxNanos;
+
+        Latency() : calls(0), totalNanos(0), maxNanos(0) {}
+        void add(long long nanos);
+    };
 
     bool isActive;
 
+    std::vector<SecurityHandler *> handlers;   // Owned
+    std::vector<Rule> rules;
+    std::vector<Stage> table[SECURITY_EVENT_COUNT];
+    bool tableDirty;
+
+    std::deque<SecurityEvent> queue;
+    bool dispatching;
+    unsigned long long processedCount;
+    unsigned long long droppedCount;
+
+    std::vector<Latency> handlerStats;   // Parallel to handlers
+    Latency queueWait;
+    Latency eventStats[SECURITY_EVENT_COUNT];
+
+    SecuritySystem(const SecuritySystem &);
+    SecuritySystem &operator=(const SecuritySystem &);
+
+    size_t handlerIndex(SecurityHandler *handler);
+    void compileRules();
+    size_t drain(long long now);
+    static long long nowNanos();
+
 public:
-    SecuritySystem(Alarm *alarm, std::vector<Light *> *lights);
-    ~SecuritySystem();
+    // Any of the collaborators may be NULL; its handler then does nothing
+    SecuritySystem(Alarm *alarm, const std::vector<Light *> *lights,
+                   const DeviceRegistry *registry = NULL, NotificationSystem *notifications = NULL);
+    virtual ~SecuritySystem();
 
     void activate();
     void deactivate();
-    void handleMotionDetection();
+    bool isArmed() const;
+
+    // Takes ownership of the handler
+    SecurityHandler *addHandler(SecurityHandler *handler);
+    // Appends a stage for events of this type (also adds the handler if needed)
+    void addRule(SecurityEventType type, SecurityHandler *handler, bool armedOnly = true, int minValue = 0);
+    void clearRules();
+    const std::vector<Rule> &getRules() const;
+    size_t getStageCount(SecurityEventType type) const;
+
+    // Queues the event and handles the queue unless a handler is running;
+    // false if the queue was full and the event was dropped
+    bool post(const SecurityEvent &event);
+    // Handles queued events; returns how many
+    size_t processEvents();
+
+    // IDeviceObserver: detector alerts become SECURITY_DETECTION events
+    virtual void onDeviceFailure(const std::string &deviceName, const std::string &message);
+    virtual void onDeviceEvent(const DeviceEvent &event);
+
+    // Queue wait, then one entry per handler
+    void getMetrics(std::vector<SecurityStageMetrics> &out) const;
+    unsigned long long getProcessedCount() const;
+    unsigned long long getDroppedCount() const;
+    void resetMetrics();
+
     void displayStatus() const;
+    static const char *eventName(SecurityEventType type);
 };
 
-#endif // SECURITYSYSTEM_H
\ No newline at end of file
+#endif // SECURITYSYSTEM_H
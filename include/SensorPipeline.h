@@ -0,0 +1,102 @@
+#ifndef SENSORPIPELINE_H
+#define SENSORPIPELINE_H
+
+#include "DetectorBank.h"
+#include "SignalFilter.h"
+#include <cstddef>
+#include <vector>
+
+class Detector;
+class LevelSeries;
+
+// One sensor sample as it arrives from a site
+struct SensorReading {
+    int detectorId;        // Registry device ID of a smoke or gas detector
+    int level;             // 0-100, clamped on ingest
+    long long timestamp;   // Microseconds since the epoch
+};
+
+// A detector that went from clear to alert during an ingest
+struct SensorTransition {
+    int detectorId;
+    int level;             // Highest level seen in the batch
+    long long timestamp;   // The detector's last reading in the batch
+};
+
+// Batched ingestion for smoke and gas detectors.
+//
+// Attached detectors get a slot in a set of parallel arrays. ingest() first
+// scatters the readings into per-slot peak/last columns, then compares every
+// peak with its slot limit in one SIMD pass (DetectorBank, peaks as levels,
+// limits as thresholds) and raises the slots set in the resulting bitmask, or
+// checks just the touched slots when few detectors reported.
+// A latched (already detected) slot has a limit above 100, so only real
+// clear-to-alert transitions come out of the loop; those go through
+// Detector::raiseDetection (alert line + EVENT_DETECTION on the bus).
+// Detectors keep their limit in sync by calling refresh() when their
+// sensitivity or detection state changes. While a detector is attached its
+// current level lives in the pipeline (getLevel), so an ingest never has to
+// touch the detector objects unless one of them raises an alert.
+// Detectors with a SignalFilter (smoothing, debounce or hysteresis) skip the
+// peak compare: their filter state also lives in a pipeline column and is
+// stepped once per reading, in order, and its raise/release edges are applied
+// as they happen.
+class SensorPipeline {
+private:
+    std::vector<Detector*> detectors;     // Per slot, NULL for a free slot
+    DetectorBank bank;                    // Per slot: peak this batch (-1 if none) vs threshold, or LATCHED once detected
+    std::vector<DetectorBank::Word> hitMask;
+    std::vector<int> levels;              // Current level per slot
+    std::vector<long long> lastTimes;
+    std::vector<SignalFilter> filters;    // Live filter state per slot
+    std::vector<int> thresholds;          // Unlatched threshold, for the filters
+    std::vector<unsigned char> filtered;  // 1 when the slot's filter is not a pass-through
+    std::vector<LevelSeries*> histories;  // Every reading is recorded here if set
+    std::vector<int> slotOfId;            // Device ID -> slot, -1 if not attached
+    std::vector<int> freeSlots;
+    std::vector<int> touched;             // Slots that got readings this batch
+    std::vector<SensorTransition> transitions;
+
+    unsigned long long readingCount;
+    unsigned long long transitionCount;
+    unsigned long long releaseCount;      // Alerts cleared by a filter's hysteresis band
+    unsigned long long unknownCount;      // Readings for IDs that are not attached
+
+    static const int LATCHED = 101;
+
+    SensorPipeline(const SensorPipeline&);
+    SensorPipeline& operator=(const SensorPipeline&);
+
+    void raise(int slot, int level);
+    void stepFilter(int slot, int level);
+
+public:
+    SensorPipeline();
+    ~SensorPipeline();
+
+    // The detector must already have its registry ID
+    void attach(Detector* detector);
+    // keepLevel hands the current level back to the detector (false while it is being destroyed)
+    void detach(Detector* detector, bool keepLevel = true);
+    // Re-reads threshold, filter, history and detection state of the detector in slot
+    void refresh(int slot);
+    // Current level of an attached detector (Detector::getReading goes here)
+    int getLevel(int slot) const;
+    void setLevel(int slot, int level);
+    // Filter of an attached detector (Detector::getSignalFilter goes here)
+    SignalFilter& getFilter(int slot);
+    const SignalFilter& getFilter(int slot) const;
+
+    // Returns the number of clear-to-alert transitions in this batch
+    size_t ingest(const SensorReading* readings, size_t count);
+    // Transitions of the last ingest
+    const std::vector<SensorTransition>& getTransitions() const;
+
+    size_t size() const;
+    unsigned long long getReadingCount() const;
+    unsigned long long getTransitionCount() const;
+    unsigned long long getReleaseCount() const;
+    unsigned long long getUnknownCount() const;
+};
+
+#endif // SENSORPIPELINE_H
@@ -0,0 +1,79 @@
+#ifndef SIGNALFILTER_H
+#define SIGNALFILTER_H
+
+// Per-detector smoothing, debounce and hysteresis for 0-100 sensor levels.
+//
+// Every reading is first smoothed (none, moving average over up to
+// MAX_WINDOW samples, or EWMA), then compared with the detector threshold.
+// An alert is raised only after `debounce` consecutive smoothed values above
+// the threshold. With a hysteresis band the alert clears by itself once
+// `debounce` consecutive values are at or below threshold - band; with no
+// band it stays latched until cleared (Detector::resetDetection).
+//
+// All state is fixed-size and integer-only, so filters can live by value in
+// a detector or in a SensorPipeline column. The default filter passes
+// readings through unchanged and latches on the first one over threshold.
+class SignalFilter {
+public:
+    enum Mode {
+        FILTER_NONE,
+        FILTER_MOVING_AVERAGE,
+        FILTER_EWMA
+    };
+
+    enum Signal {
+        SIGNAL_QUIET,       // No alert, or alerting but not above threshold
+        SIGNAL_RAISED,      // Clear -> alert on this reading
+        SIGNAL_ALERT,       // Still alerting and above threshold
+        SIGNAL_RELEASED     // Alert -> clear on this reading (hysteresis)
+    };
+
+    static const int MAX_WINDOW = 16;
+    static const int MAX_DEBOUNCE = 100;
+    static const int MAX_HYSTERESIS = 100;
+
+private:
+    // Configuration
+    unsigned char mode;
+    unsigned char window;        // Moving average samples
+    unsigned char debounce;      // Consecutive samples to raise or release
+    unsigned char hysteresis;    // Band below threshold, 0 = latch
+    unsigned short alpha;        // EWMA weight of a new sample, 1/256 units
+
+    // State
+    bool alarmed;
+    unsigned char run;           // Consecutive samples toward the next edge
+    unsigned char head;
+    unsigned char filled;
+    unsigned short sum;
+    int smoothed;                // EWMA in 1/256 units
+    int value;                   // Last filtered level
+    unsigned char history[MAX_WINDOW];
+
+public:
+    SignalFilter();
+
+    // amount: window in samples (moving average) or new-sample weight in percent (EWMA)
+    void setSmoothing(Mode newMode, int amount);
+    void setDebounce(int samples);
+    void setHysteresis(int band);
+    // Takes other's configuration and starts from a clean state
+    void configureFrom(const SignalFilter& other);
+    // Drops history and alert state
+    void reset();
+    // Overrides the alert state (the detection was raised or reset elsewhere)
+    void setAlarmed(bool on);
+
+    Signal step(int level, int threshold);
+
+    bool isPassThrough() const;
+    bool isAlarmed() const;
+    int getValue() const;
+    Mode getMode() const;
+    int getAmount() const;
+    int getDebounce() const;
+    int getHysteresis() const;
+    static const char* modeName(Mode mode);
+};
+
+#endif // SIGNALFILTER_H
@@ -14,6 +14,7 @@
 #define SMOKEDETECTOR_H
 
 #include "Detector.h"
+#include "DevicePool.h"
 
 // Base Smoke Detector class
 class SmokeDetector : public Detector {
@@ -29,6 +30,14 @@ public:
     virtual Device* clone() const = 0;
     virtual void detect();
     virtual void trigger(); // Override pure virtual
+    virtual int getReading() const;
+
+protected:
+    virtual void recordLevel(int level);
+    virtual void printAlert(int level) const;
+    virtual const char* detectionMessage() const;
+
+public:
     
     int getSmokeLevel() const;
     void setSmokeLevel(int level);  // For simulation
@@ -40,6 +49,7 @@ public:
     NestSmokeDetector();
     virtual ~NestSmokeDetector();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(NestSmokeDetector)
 };
 
 // Concrete Smoke Detector - First Alert
@@ -48,6 +58,7 @@ public:
     FirstAlertSmokeDetector();
     virtual ~FirstAlertSmokeDetector();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(FirstAlertSmokeDetector)
 };
 
 #endif // SMOKEDETECTOR_H
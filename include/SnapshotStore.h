@@ -0,0 +1,80 @@
+#ifndef SNAPSHOTSTORE_H
+#define SNAPSHOTSTORE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "StateManager.h"
+
+// A snapshot as read back from disk
+struct StoredSnapshot {
+    std::string stateName;
+    std::string modeName;
+    long long timestamp;     // Microseconds since the epoch
+    PowerSnapshot power;
+
+    StoredSnapshot() : timestamp(0) {}
+};
+
+// Append-only on-disk store for StateManager snapshots ("msh_snapshots.bin").
+//
+// File layout: an 8 byte magic followed by records
+//   [u32 payload length][u32 CRC-32 of payload][payload]
+// payload = [u8 type][varint timestamp][varint len + state][varint len + mode][body]
+// A keyframe body holds the presence and power bitsets, a delta body the
+// changes since the previous record (PowerSnapshot::diff, ID gaps as varints).
+// Every record is handed to the OS when appended; fsync runs once per
+// SYNC_BATCH records and on sync()/close(). A record that fails to write is
+// truncated away at once; a torn or corrupt tail left by a crash is dropped
+// on the next open, and long files are compacted to one keyframe.
+class SnapshotStore {
+public:
+    enum RecordType {
+        RECORD_KEYFRAME = 1,
+        RECORD_DELTA = 2
+    };
+
+    static const char MAGIC[8];
+    static const char* DEFAULT_PATH;
+
+private:
+    FILE* file;
+    std::string path;
+    long fileSize;                 // Bytes of complete records; a failed append is cut back to it
+    std::string record;            // Reused encode buffer
+    std::vector<unsigned> changes;
+    PowerSnapshot lastWritten;
+    size_t recordCount;
+    unsigned sinceKeyframe;
+    unsigned unsynced;
+
+    static const unsigned SYNC_BATCH = 8;
+    static const unsigned KEYFRAME_INTERVAL = 64;
+    static const size_t COMPACT_RECORDS = 4096;
+
+    SnapshotStore(const SnapshotStore&);
+    SnapshotStore& operator=(const SnapshotStore&);
+
+    void encode(const std::string& state, const std::string& mode, long long timestamp,
+                const PowerSnapshot& snapshot, bool keyframe);
+    bool writeRecord();
+    bool rewrite(const StoredSnapshot& latest);
+
+public:
+    SnapshotStore();
+    ~SnapshotStore();
+
+    // Reads every valid record, leaving the newest snapshot in latest, then
+    // opens the file for appending. found is false for a new or empty store.
+    bool open(const std::string& fname, StoredSnapshot& latest, bool& found);
+    void close();
+    bool isOpen() const;
+
+    bool append(const std::string& state, const std::string& mode, const PowerSnapshot& snapshot);
+    void sync();
+
+    size_t getRecordCount() const;
+    std::string getPath() const;
+};
+
+#endif // SNAPSHOTSTORE_H
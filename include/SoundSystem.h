@@ -2,12 +2,12 @@
 #define SOUNDSYSTEM_H
 
 #include "Device.h"
+#include "DevicePool.h"
 #include <string>
 
 // Base Sound System class
 class SoundSystem : public Device {
 protected:
-    int volume;      // 0-100
     bool isMuted;
     std::string currentSource;  // Bluetooth, AUX, etc.
 
@@ -33,6 +33,7 @@ public:
     
     void playMusic();
     void stopMusic();
+    bool isPlayingMusic() const;
 };
 
 // Concrete Sound System - Sonos
@@ -41,6 +42,7 @@ public:
     SonosSoundSystem();
     virtual ~SonosSoundSystem();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(SonosSoundSystem)
 };
 
 // Concrete Sound System - Bose
@@ -49,6 +51,7 @@ public:
     BoseSoundSystem();
     virtual ~BoseSoundSystem();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(BoseSoundSystem)
 };
 
 #endif // SOUNDSYSTEM_H
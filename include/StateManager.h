@@ -3,26 +3,64 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include "TimestampFormatter.h"
 
 // Forward declarations
 class Device;
+class SnapshotStore;
+struct StoredSnapshot;
 
-// Memento Pattern - State snapshot
+// Power state of every device at one point in time, as packed bitsets
+// indexed by device ID (DeviceRegistry IDs are small and dense)
+struct PowerSnapshot {
+    typedef unsigned long long Word;
+    static const size_t WORD_BITS = 64;
+
+    std::vector<Word> present;   // Device existed when the snapshot was taken
+    std::vector<Word> power;
+
+    void clear();
+    void set(int id, bool on);
+    bool contains(int id) const;
+    bool isPowered(int id) const;
+    size_t count() const;
+
+    // Devices that appeared, disappeared or flipped between two snapshots,
+    // sorted by ID, each as (id << 2) | present << 1 | power
+    static void diff(const PowerSnapshot& from, const PowerSnapshot& to, std::vector<unsigned>& changes);
+    // Applies a list produced by diff
+    void apply(const std::vector<unsigned>& changes);
+};
+
+// Memento Pattern - State snapshot.
+// Either a keyframe holding the full bitsets, or a delta holding only the
+// devices that changed since the previous memento in the history.
 class HomeMemento {
 private:
     std::string stateName;
-    std::map<std::string, bool> devicePowerStates;
     std::string modeName;
-    std::string timestamp;
+    char timestamp[TimestampFormatter::BUFFER_SIZE];
+
+    bool keyframe;
+    PowerSnapshot full;                 // Keyframes only
+    std::vector<unsigned> changes;      // Deltas only, see PowerSnapshot::diff
 
 public:
     HomeMemento(const std::string& state, const std::string& mode);
+    // Reuses this memento for a new snapshot (history slots are recycled)
+    void reset(const std::string& state, const std::string& mode);
     
-    void addDeviceState(const std::string& deviceName, bool powerState);
+    void setKeyframe(const PowerSnapshot& snapshot);
+    void setDelta(const std::vector<unsigned>& deltaChanges);
+    bool isKeyframe() const;
+    size_t getChangeCount() const;
+    size_t getMemoryUsage() const;
+
+    // Keyframes replace snapshot, deltas bring it from the previous memento's state to this one's
+    void applyTo(PowerSnapshot& snapshot) const;
+
     std::string getStateName() const;
     std::string getModeName() const;
-    std::map<std::string, bool> getDevicePowerStates() const;
     std::string getTimestamp() const;
     void display() const;
 };
@@ -72,7 +110,13 @@ public:
 class StateManager {
 private:
     SystemState* currentState;
-    std::vector<HomeMemento*> stateHistory;
+
+    // Circular history: entry i lives in slots[(head + i) % capacity].
+    // Slots are constructed once and recycled, never deleted.
+    std::vector<HomeMemento> slots;
+    size_t capacity;
+    size_t head;
+    int historyCount;
     int currentHistoryIndex;
     
     // System states
@@ -81,24 +125,54 @@ private:
     LowPowerState* lowPowerState;
     SleepState* sleepState;
     
-    static const int MAX_HISTORY = 50;
+    static const size_t DEFAULT_HISTORY = 50;
+    static const int KEYFRAME_INTERVAL = 16;   // At most this many deltas between keyframes
+
+    PowerSnapshot latest;    // State recorded by the newest memento
+    PowerSnapshot current;   // Scratch for saveState
+    int sinceKeyframe;
+    std::vector<unsigned> delta;
+
+    HomeMemento& entry(int index);
+    const HomeMemento& entry(int index) const;
+    SnapshotStore* store;    // NULL until openStore
+
+    void packDevices(const std::vector<Device*>& allDevices, PowerSnapshot& snapshot) const;
+    void rebuildLatest();
+    SystemState* findState(const std::string& name) const;
 
 public:
-    StateManager();
+    // Capacity 0 takes MSH_HISTORY from the environment, else DEFAULT_HISTORY
+    explicit StateManager(size_t historyCapacity = 0);
     ~StateManager();
 
     // State management
     void setState(char stateChar);
+    bool setStateByName(const std::string& name);
     void applyState();
     SystemState* getCurrentState() const;
     std::string getCurrentStateName() const;
     
-    // Memento operations
+    // Memento operations. Restoring moves through the history and brings back
+    // the system state; HomeController restores devices and mode from getMemento.
     void saveState(const std::string& modeName, const std::vector<Device*>& allDevices);
     bool restorePreviousState();
     bool restoreNextState();
+    int getCurrentHistoryIndex() const;
+    const HomeMemento* getMemento(int index) const;
     void displayHistory() const;
     int getHistorySize() const;
+    size_t getHistoryCapacity() const;
+    // Reconstructs the device power states recorded by history entry index
+    bool getSnapshot(int index, PowerSnapshot& snapshot) const;
+    size_t getHistoryMemoryUsage() const;
+
+    // Persistence - once a store is open every saved state is appended to it.
+    // found tells whether it held a snapshot to resume from.
+    bool openStore(const std::string& path, StoredSnapshot& resumed, bool& found);
+    // Appends the current device state without adding a history entry
+    void persistState(const std::string& modeName, const std::vector<Device*>& allDevices);
+    void syncStore();
     
     void displayCurrentState() const;
 };
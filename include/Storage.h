@@ -4,6 +4,15 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "TimestampFormatter.h"
+#include "EventLog.h"
+#include "LogRotator.h"
+
+class LogRingBuffer;
 
 // Singleton Pattern for Storage/Logging
 class Storage {
@@ -12,29 +21,88 @@ private:
     std::ofstream logFile;
     std::string filename;
     bool isOpen;
-    
+    TimestampFormatter timestampFormatter;  // Used by whichever thread writes the file
+
+    // Binary event log written next to the text log (e.g. msh_log.bin)
+    EventLog eventLog;
+    bool eventLogEnabled;
+
+    // Segmented logging - touched only by the thread that writes logFile
+    LogRotator rotator;
+    size_t rotationMaxBytes;          // Policy for the next openFile()
+    int rotationMaxAgeSeconds;
+    int rotationMaxSegments;
+    bool rotationCompress;
+    size_t segmentBytes;
+    long long segmentOpenedAt;
+    long long segmentFirstTime;
+    long long segmentLastTime;
+
+    // Asynchronous logging - records are queued and written by a background thread
+    bool asyncMode;
+    size_t asyncBatchSize;
+    int asyncFlushIntervalMs;
+    size_t asyncQueueCapacity;
+    LogRingBuffer* ringBuffer;
+    std::thread writerThread;
+    std::mutex writerMutex;
+    std::condition_variable writerWakeup;
+    std::condition_variable flushDone;
+    std::atomic<bool> writerRunning;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> flushRequested;
+    std::atomic<size_t> enqueuedCount;
+    std::atomic<size_t> writtenCount;
+
     // Private constructor for Singleton
     Storage();
     Storage(const Storage&);
     Storage& operator=(const Storage&);
-    
-    std::string getCurrentTimestamp() const;
+
+    void appendLine(std::string& out, long long when, const std::string& message);
+    void noteWritten(size_t bytes, long long firstTime, long long lastTime);
+    void rotateIfNeeded(long long now);
+
+    void startWriter();
+    void stopWriter();
+    void writerLoop();
+    void enqueue(long long when, const std::string& message);
 
 public:
     static Storage* getInstance();
     ~Storage();
-    
+
     bool openFile(const std::string& fname = "msh_log.txt");
     void closeFile();
     bool isFileOpen() const;
-    
+
+    void setTimestampFormat(TimestampFormatter::Format format);
+    TimestampFormatter::Format getTimestampFormat() const;
+
+    // Binary event log - takes effect on the next openFile()
+    void setEventLogEnabled(bool enabled);
+    bool isEventLogEnabled() const;
+    static std::string eventLogFilename(const std::string& logFilename);
+
+    // Roll msh_log.txt over to msh_log.000001.txt etc. after maxBytes or
+    // maxAgeSeconds (0 disables either limit), keeping maxSegments closed
+    // segments. Takes effect on the next openFile(); an open file keeps the
+    // policy it was opened with.
+    void setRotationPolicy(size_t maxBytes, int maxAgeSeconds, int maxSegments = 10, bool compress = true);
+
+    // Asynchronous mode: group-commit style batching on a writer thread
+    void enableAsync(size_t batchSize = 256, int flushIntervalMs = 50, size_t queueCapacity = 8192);
+    void disableAsync();
+    bool isAsync() const;
+    void flush();  // Blocks until every queued record reached the file
+
     // Logging methods
     void log(const std::string& message);
     void logInfo(const std::string& message);
     void logWarning(const std::string& message);
     void logError(const std::string& message);
     void logAlert(const std::string& message);
-    
+
     // Operation logging
     void logMenuSelection(int option);
     void logDeviceOperation(const std::string& deviceName, const std::string& operation);
@@ -42,7 +110,7 @@ public:
     void logStateChange(const std::string& fromState, const std::string& toState);
     void logSystemStart();
     void logSystemShutdown();
-    
+
     std::string getFilename() const;
 };
 
@@ -2,6 +2,7 @@
 #define TELEVISION_H
 
 #include "Device.h"
+#include "DevicePool.h"
 #include <string>
 
 // Base Television class
@@ -9,7 +10,6 @@ class Television : public Device {
 protected:
     int screenSize;      // inches
     std::string resolution;
-    int volume;          // 0-100
     int channel;
     bool smartTV;
 
@@ -40,6 +40,7 @@ public:
     SamsungTV();
     virtual ~SamsungTV();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(SamsungTV)
 };
 
 // Concrete TV classes - LG
@@ -48,6 +49,7 @@ public:
     LGTV();
     virtual ~LGTV();
     virtual Device* clone() const;
+    MSH_POOLED_DEVICE(LGTV)
 };
 
 #endif // TELEVISION_H
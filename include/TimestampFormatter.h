@@ -0,0 +1,47 @@
+#ifndef TIMESTAMPFORMATTER_H
+#define TIMESTAMPFORMATTER_H
+
+#include <ctime>
+#include <cstddef>
+
+// Shared timestamp service for log lines and mementos.
+// Formats into a caller-provided buffer and caches the second-resolution
+// part, so consecutive calls within the same second only copy bytes.
+// An instance is not thread-safe; each thread keeps its own formatter.
+class TimestampFormatter {
+public:
+    enum Format {
+        FORMAT_CTIME,          // "Tue Nov 25 21:33:31 2025" (classic msh_log.txt)
+        FORMAT_ISO8601_MICROS  // "2025-11-25T21:33:31.123456", monotonic clock
+    };
+
+    static const size_t BUFFER_SIZE = 32;
+
+private:
+    Format activeFormat;
+    time_t cachedSecond;
+    char cachedPrefix[BUFFER_SIZE];
+    size_t cachedLength;
+
+    void refreshPrefix(time_t second);
+
+public:
+    explicit TimestampFormatter(Format fmt = FORMAT_CTIME);
+
+    void setFormat(Format fmt);
+    Format getFormat() const;
+
+    // Current time in microseconds since the epoch for the active format.
+    // The ISO-8601 format uses a monotonic clock anchored to the wall clock
+    // at first use, so timestamps never step backwards.
+    long long now() const;
+    static long long wallClockMicros();
+    static long long monotonicMicros();
+
+    // Writes a NUL-terminated timestamp into buffer and returns its length.
+    // buffer must hold at least BUFFER_SIZE bytes.
+    size_t format(long long micros, char* buffer);
+    size_t formatNow(char* buffer);
+};
+
+#endif // TIMESTAMPFORMATTER_H
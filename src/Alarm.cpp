@@ -1,4 +1,5 @@
 #include "Alarm.h"
+#include "OutputSink.h"
 #include <sstream>
 
 // Initialize static instance pointer
@@ -7,7 +8,7 @@ Alarm* Alarm::instance = NULL;
 Alarm::Alarm() 
     : Device("MSH", "Integrated Alarm"), isRinging(false), volumeLevel(100) {
     // Alarm is always on
-    powerState = true;
+    setPowerState(true);
 }
 
 Alarm* Alarm::getInstance() {
@@ -20,15 +21,15 @@ Alarm* Alarm::getInstance() {
 Alarm::~Alarm() {}
 
 void Alarm::powerOff() {
-    std::cout << "[WARNING] Alarm is a CRITICAL device and cannot be powered off!" << std::endl;
+    OutputSink::out() << "[WARNING] Alarm is a CRITICAL device and cannot be powered off!" << std::endl;
 }
 
 void Alarm::doPowerOn() {
-    std::cout << "  -> Alarm system activated." << std::endl;
+    OutputSink::out() << "  -> Alarm system activated." << std::endl;
 }
 
 void Alarm::doPowerOff() {
-    std::cout << "  -> Alarm cannot be turned off (critical device)." << std::endl;
+    OutputSink::out() << "  -> Alarm cannot be turned off (critical device)." << std::endl;
 }
 
 std::string Alarm::getDeviceType() const {
@@ -54,7 +55,7 @@ void Alarm::ring() {
 
 void Alarm::stop() {
     isRinging = false;
-    std::cout << "[INFO] Alarm stopped." << std::endl;
+    OutputSink::out() << "[INFO] Alarm stopped." << std::endl;
 }
 
 bool Alarm::isAlarmRinging() const {
@@ -65,7 +66,7 @@ void Alarm::setVolume(int vol) {
     if (vol < 0) vol = 0;
     if (vol > 100) vol = 100;
     volumeLevel = vol;
-    std::cout << "[INFO] Alarm volume set to: " << volumeLevel << "%" << std::endl;
+    OutputSink::out() << "[INFO] Alarm volume set to: " << volumeLevel << "%" << std::endl;
 }
 
 int Alarm::getVolume() const {
@@ -11,16 +11,13 @@
  */
 
 #include "AlarmHandler.h"
-#include <iostream>
+#include "OutputSink.h"
 
-AlarmHandler::AlarmHandler(Alarm* alarm) : alarm(alarm) {}
+AlarmHandler::AlarmHandler(Alarm* alarm) : SecurityHandler("Alarm"), alarm(alarm) {}
 
-void AlarmHandler::handleRequest() {
-    std::cout << "[SECURITY] Triggering Alarm..." << std::endl;
+void AlarmHandler::handle(const SecurityEvent&) {
+    OutputSink::out() << "[SECURITY] Triggering Alarm..." << std::endl;
     if (alarm) {
-        alarm->trigger();
+        alarm->ring();
     }
-    
-    // Pass to next handler
-    SecurityHandler::handleRequest();
 }
@@ -0,0 +1,96 @@
+#include "BinaryCodec.h"
+
+namespace {
+
+struct CrcTable {
+    unsigned entries[256];
+
+    CrcTable() {
+        for (unsigned i = 0; i < 256; ++i) {
+            unsigned c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+}
+
+unsigned BinaryCodec::crc32(const char* data, size_t size) {
+    static const CrcTable table;   // Built once, even with several writer threads
+    unsigned crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table.entries[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void BinaryCodec::putU32(char* out, unsigned value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (char)((value >> (8 * i)) & 0xFF);
+    }
+}
+
+unsigned BinaryCodec::getU32(const char* in) {
+    unsigned value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= (unsigned)(unsigned char)in[i] << (8 * i);
+    }
+    return value;
+}
+
+void BinaryCodec::putU64(std::string& out, unsigned long long value) {
+    for (int i = 0; i < 8; ++i) {
+        out += (char)((value >> (8 * i)) & 0xFF);
+    }
+}
+
+unsigned long long BinaryCodec::getU64(const char* in) {
+    unsigned long long value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= (unsigned long long)(unsigned char)in[i] << (8 * i);
+    }
+    return value;
+}
+
+void BinaryCodec::putVarint(std::string& out, unsigned long long value) {
+    while (value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+void BinaryCodec::putSignedVarint(std::string& out, long long value) {
+    putVarint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+bool BinaryCodec::getVarint(const char* data, size_t size, size_t& pos, unsigned long long& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= size) {
+            return false;
+        }
+        unsigned char byte = (unsigned char)data[pos++];
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryCodec::getSignedVarint(const char* data, size_t size, size_t& pos, long long& value) {
+    unsigned long long raw;
+    if (!getVarint(data, size, pos, raw)) {
+        return false;
+    }
+    value = unzigzag(raw);
+    return true;
+}
+
+long long BinaryCodec::unzigzag(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
@@ -11,6 +11,7 @@
  */
 
 #include "Camera.h"
+#include "OutputSink.h"
 #include <iostream>
 #include <sstream>
 
@@ -30,7 +31,7 @@ std::string Camera::getStatus() const
 {
     std::ostringstream oss;
     oss << Device::getStatus() << " | Res: " << resolution << "p";
-    if (powerState && isRecording)
+    if (isPoweredOn() && isRecording)
         oss << " [REC]";
     return oss.str();
 }
@@ -38,24 +39,45 @@ std::string Camera::getStatus() const
 void Camera::doPowerOn()
 {
     isRecording = true;
-    std::cout << "  -> Camera started recording." << std::endl;
+    OutputSink::out() << "  -> Camera started recording." << std::endl;
 }
 
 void Camera::doPowerOff()
 {
     isRecording = false;
-    std::cout << "  -> Camera stopped recording." << std::endl;
+    OutputSink::out() << "  -> Camera stopped recording." << std::endl;
 }
 
 void Camera::detectMotion()
 {
-    if (!powerState)
+    if (!isPoweredOn())
         return;
 
-    std::cout << "[INFO] Camera " << name << " detected motion." << std::endl;
+    OutputSink::out() << "[INFO] Camera " << name << " detected motion." << std::endl;
     // Security System trigger removed in V3.0
 }
 
+void Camera::startRecording()
+{
+    if (!isActive())
+        return; // A failed camera cannot record
+    if (!isPoweredOn())
+    {
+        powerOn(); // doPowerOn starts the recording
+        return;
+    }
+    if (!isRecording)
+    {
+        isRecording = true;
+        OutputSink::out() << "  -> Camera started recording." << std::endl;
+    }
+}
+
+bool Camera::isRecordingVideo() const
+{
+    return isPoweredOn() && isRecording;
+}
+
 void Camera::setResolution(int res)
 {
     if (res != 720 && res != 1080 && res != 2160)
@@ -64,7 +86,7 @@ void Camera::setResolution(int res)
         return;
     }
     resolution = res;
-    std::cout << "[INFO] Camera resolution set to " << resolution << "p" << std::endl;
+    OutputSink::out() << "[INFO] Camera resolution set to " << resolution << "p" << std::endl;
 }
 
 int Camera::getResolution() const
@@ -87,6 +109,8 @@ Device *SamsungCamera::clone() const
     return newCam;
 }
 
+MSH_DEFINE_POOLED_DEVICE(SamsungCamera)
+
 // Xiaomi Camera
 XiaomiCamera::XiaomiCamera()
     : Camera("Xiaomi", "Mi Home Security 360")
@@ -100,4 +124,6 @@ Device *XiaomiCamera::clone() const
     XiaomiCamera *newCam = new XiaomiCamera();
     newCam->copyConfigurationFrom(this);
     return newCam;
-}
\ No newline at end of file
+}
+
+MSH_DEFINE_POOLED_DEVICE(XiaomiCamera)
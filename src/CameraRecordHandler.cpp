@@ -0,0 +1,25 @@
+/**
+ * @file CameraRecordHandler.cpp
+ * @brief Implementation of Camera Record Handler
+ *
+ * @patterns Chain of Responsibility
+ */
+
+#include "CameraRecordHandler.h"
+#include "DeviceRegistry.h"
+#include "Camera.h"
+#include "OutputSink.h"
+
+CameraRecordHandler::CameraRecordHandler(const DeviceRegistry* registry)
+    : SecurityHandler("Camera recording"), registry(registry) {}
+
+void CameraRecordHandler::handle(const SecurityEvent&) {
+    if (!registry) {
+        return;
+    }
+    // Only Camera objects are ever registered as KIND_CAMERA
+    const std::vector<Device*>& cameras = registry->getDevices(KIND_CAMERA);
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        static_cast<Camera*>(cameras[i])->startRecording();
+    }
+}
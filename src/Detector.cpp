@@ -11,34 +11,58 @@
  */
 
 #include "Detector.h"
+#include "OutputSink.h"
+#include "SensorPipeline.h"
+#include "LevelHistory.h"
+#include "TimestampFormatter.h"
+#include <iomanip>
 #include <sstream>
 
 Detector::Detector(const std::string& brand, const std::string& model)
-    : Device(brand, model), detected(false), sensitivityLevel(5) {
+    : Device(brand, model), pipeline(NULL), pipelineSlot(-1), history(NULL), detected(false), sensitivityLevel(5) {
     // Detectors start powered on by default - critical devices
-    powerState = true;
+    setPowerState(true);
 }
 
-Detector::~Detector() {}
+Detector::~Detector() {
+    if (pipeline) {
+        pipeline->detach(this, false);   // Subclass part is already gone
+    }
+}
 
 void Detector::powerOff() {
-    std::cout << "[WARNING] " << name << " is a CRITICAL device and cannot be powered off!" << std::endl;
+    OutputSink::out() << "[WARNING] " << name << " is a CRITICAL device and cannot be powered off!" << std::endl;
     // Do not change powerState - keep it on
 }
 
 void Detector::doPowerOn() {
-    std::cout << "  -> Detector " << name << " monitoring activated." << std::endl;
+    OutputSink::out() << "  -> Detector " << name << " monitoring activated." << std::endl;
 }
 
 void Detector::doPowerOff() {
     // This should never be called for detectors
-    std::cout << "  -> Detector " << name << " cannot be turned off (critical device)." << std::endl;
+    OutputSink::out() << "  -> Detector " << name << " cannot be turned off (critical device)." << std::endl;
 }
 
 std::string Detector::getStatus() const {
     std::ostringstream oss;
     oss << Device::getStatus() << " | Sensitivity: " << sensitivityLevel << "/10";
     oss << ", Detection: " << (detected ? "ALERT!" : "Clear");
+    const SignalFilter& f = activeFilter();
+    if (!f.isPassThrough()) {
+        oss << " | Filter: " << SignalFilter::modeName(f.getMode());
+        if (f.getMode() != SignalFilter::FILTER_NONE) {
+            oss << " " << f.getAmount() << (f.getMode() == SignalFilter::FILTER_EWMA ? "%" : "");
+        }
+        oss << ", debounce " << f.getDebounce() << ", hysteresis " << f.getHysteresis()
+            << " (level " << f.getValue() << "%)";
+    }
+    LevelRollup minute;
+    if (history && history->summarize(LevelSeries::ROLLUP_1S, history->getLastTime() - 59 * 1000000LL,
+                                      history->getLastTime(), minute)) {
+        oss << " | Last minute: min " << minute.min << "%, avg " << std::fixed << std::setprecision(1)
+            << minute.avg << "%, max " << minute.max << "% (" << minute.count << " readings)";
+    }
     return oss.str();
 }
 
@@ -47,6 +71,11 @@ void Detector::copyConfigurationFrom(const Device* other) {
     const Detector* otherDet = dynamic_cast<const Detector*>(other);
     if (otherDet) {
         this->sensitivityLevel = otherDet->sensitivityLevel;
+        activeFilter().configureFrom(otherDet->activeFilter());
+        activeFilter().setAlarmed(detected);
+        if (pipeline) {
+            pipeline->refresh(pipelineSlot);
+        }
     }
 }
 
@@ -54,20 +83,141 @@ void Detector::setSensitivity(int level) {
     if (level < 1) level = 1;
     if (level > 10) level = 10;
     sensitivityLevel = level;
-    std::cout << "[INFO] " << name << " sensitivity set to: " << sensitivityLevel << "/10" << std::endl;
+    if (pipeline) {
+        pipeline->refresh(pipelineSlot);
+    }
+    OutputSink::out() << "[INFO] " << name << " sensitivity set to: " << sensitivityLevel << "/10" << std::endl;
 }
 
 int Detector::getSensitivity() const {
     return sensitivityLevel;
 }
 
+int Detector::getThreshold() const {
+    return (10 - sensitivityLevel) * 10;
+}
+
+SignalFilter& Detector::activeFilter() {
+    return pipeline ? pipeline->getFilter(pipelineSlot) : filter;
+}
+
+const SignalFilter& Detector::activeFilter() const {
+    return pipeline ? pipeline->getFilter(pipelineSlot) : filter;
+}
+
+void Detector::filterChanged() {
+    activeFilter().setAlarmed(detected);   // A filter reset must not forget a latched alert
+    if (pipeline) {
+        pipeline->refresh(pipelineSlot);
+    }
+}
+
+void Detector::setSmoothing(SignalFilter::Mode mode, int amount) {
+    activeFilter().setSmoothing(mode, amount);
+    filterChanged();
+    OutputSink::out() << "[INFO] " << name << " smoothing set to: " << SignalFilter::modeName(mode)
+                      << " " << activeFilter().getAmount() << std::endl;
+}
+
+void Detector::setDebounce(int samples) {
+    activeFilter().setDebounce(samples);
+    filterChanged();
+    OutputSink::out() << "[INFO] " << name << " debounce set to: " << activeFilter().getDebounce() << " readings" << std::endl;
+}
+
+void Detector::setHysteresis(int band) {
+    activeFilter().setHysteresis(band);
+    filterChanged();
+    OutputSink::out() << "[INFO] " << name << " hysteresis set to: " << activeFilter().getHysteresis() << std::endl;
+}
+
+const SignalFilter& Detector::getSignalFilter() const {
+    return activeFilter();
+}
+
+void Detector::raiseDetection(int level) {
+    bool first = !detected;
+    detected = true;
+    printAlert(level);
+    if (first) {
+        if (pipeline) {
+            pipeline->refresh(pipelineSlot);
+        }
+        notifyEvent(EVENT_DETECTION, SEVERITY_CRITICAL, detectionMessage(), level);
+    }
+}
+
+void Detector::releaseDetection(int level) {
+    if (!detected) {
+        return;
+    }
+    detected = false;
+    if (pipeline) {
+        pipeline->refresh(pipelineSlot);
+    }
+    OutputSink::out() << "[INFO] " << name << " detection cleared. Level: " << level << "%" << std::endl;
+}
+
+void Detector::evaluateReading(int level) {
+    SignalFilter& f = activeFilter();
+    SignalFilter::Signal signal = f.step(level, getThreshold());
+    if (signal == SignalFilter::SIGNAL_RELEASED) {
+        releaseDetection(f.getValue());
+        return;
+    }
+    if (signal == SignalFilter::SIGNAL_QUIET) {
+        return;
+    }
+    if (!isPoweredOn() || !isActive()) {
+        if (signal == SignalFilter::SIGNAL_RAISED) {
+            f.setAlarmed(false);   // Raise again once the detector is back
+        }
+        return;
+    }
+    raiseDetection(f.getValue());
+}
+
+void Detector::checkDetection(int level) {
+    if (!isPoweredOn() || !isActive()) return;
+
+    const SignalFilter& f = activeFilter();
+    if (f.isPassThrough()) {
+        if (level > getThreshold()) {
+            raiseDetection(level);
+        }
+    } else if (f.isAlarmed() && f.getValue() > getThreshold()) {
+        raiseDetection(f.getValue());
+    }
+}
+
 bool Detector::isDetected() const {
     return detected;
 }
 
+int Detector::currentLevel(int ownLevel) const {
+    return pipeline ? pipeline->getLevel(pipelineSlot) : ownLevel;
+}
+
+void Detector::levelChanged(int level) {
+    if (pipeline) {
+        pipeline->setLevel(pipelineSlot, level);
+    }
+    if (history) {
+        history->append(TimestampFormatter::wallClockMicros(), level);
+    }
+}
+
+const LevelSeries* Detector::getLevelHistory() const {
+    return history;
+}
+
 void Detector::resetDetection() {
     detected = false;
-    std::cout << "[INFO] " << name << " detection reset." << std::endl;
+    activeFilter().setAlarmed(false);
+    if (pipeline) {
+        pipeline->refresh(pipelineSlot);
+    }
+    OutputSink::out() << "[INFO] " << name << " detection reset." << std::endl;
 }
 
 void Detector::reset() {
@@ -0,0 +1,295 @@
+#include "DetectorBank.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MSH_HAVE_SSE2 1
+#endif
+
+// AVX2 is compiled per function and only called after a CPU check
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MSH_HAVE_AVX2 1
+#define MSH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+typedef DetectorBank::Word Word;
+
+const size_t ALIGNMENT = 32;   // One AVX2 register
+
+int* allocateInts(size_t count) {
+    void* memory = NULL;
+#ifdef _WIN32
+    memory = _aligned_malloc(count * sizeof(int), ALIGNMENT);
+#else
+    if (posix_memalign(&memory, ALIGNMENT, count * sizeof(int)) != 0) {
+        memory = NULL;
+    }
+#endif
+    return static_cast<int*>(memory);
+}
+
+void freeInts(int* data) {
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    std::free(data);
+#endif
+}
+
+size_t popcount(Word word) {
+#ifdef __GNUC__
+    return (size_t)__builtin_popcountll(word);
+#else
+    size_t bits = 0;
+    for (; word; word &= word - 1) {
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+size_t evaluateScalar(const int* levels, const int* thresholds, size_t words, Word* mask) {
+    size_t hits = 0;
+    for (size_t w = 0; w < words; ++w) {
+        const int* level = levels + w * DetectorBank::WORD_BITS;
+        const int* threshold = thresholds + w * DetectorBank::WORD_BITS;
+        Word bits = 0;
+        for (size_t b = 0; b < DetectorBank::WORD_BITS; ++b) {
+            bits |= (Word)(level[b] > threshold[b]) << b;
+        }
+        mask[w] = bits;
+        hits += popcount(bits);
+    }
+    return hits;
+}
+
+#ifdef MSH_HAVE_SSE2
+size_t evaluateSSE2(const int* levels, const int* thresholds, size_t words, Word* mask) {
+    size_t hits = 0;
+    for (size_t w = 0; w < words; ++w) {
+        const int* level = levels + w * DetectorBank::WORD_BITS;
+        const int* threshold = thresholds + w * DetectorBank::WORD_BITS;
+        Word bits = 0;
+        for (size_t b = 0; b < DetectorBank::WORD_BITS; b += 4) {
+            __m128i l = _mm_load_si128(reinterpret_cast<const __m128i*>(level + b));
+            __m128i t = _mm_load_si128(reinterpret_cast<const __m128i*>(threshold + b));
+            bits |= (Word)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(l, t))) << b;
+        }
+        mask[w] = bits;
+        hits += popcount(bits);
+    }
+    return hits;
+}
+#endif
+
+#ifdef MSH_HAVE_AVX2
+MSH_TARGET_AVX2
+size_t evaluateAVX2(const int* levels, const int* thresholds, size_t words, Word* mask) {
+    size_t hits = 0;
+    for (size_t w = 0; w < words; ++w) {
+        const int* level = levels + w * DetectorBank::WORD_BITS;
+        const int* threshold = thresholds + w * DetectorBank::WORD_BITS;
+        Word bits = 0;
+        for (size_t b = 0; b < DetectorBank::WORD_BITS; b += 8) {
+            __m256i l = _mm256_load_si256(reinterpret_cast<const __m256i*>(level + b));
+            __m256i t = _mm256_load_si256(reinterpret_cast<const __m256i*>(threshold + b));
+            bits |= (Word)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(l, t))) << b;
+        }
+        mask[w] = bits;
+        hits += popcount(bits);
+    }
+    return hits;
+}
+#endif
+
+DetectorBank::Kernel configuredKernel() {
+    const char* env = std::getenv("MSH_SIMD");
+    std::string name = env ? env : "";
+    if (name == "scalar") {
+        return DetectorBank::KERNEL_SCALAR;
+    }
+    if (name == "sse2" && DetectorBank::isSupported(DetectorBank::KERNEL_SSE2)) {
+        return DetectorBank::KERNEL_SSE2;
+    }
+    if (name == "avx2" && DetectorBank::isSupported(DetectorBank::KERNEL_AVX2)) {
+        return DetectorBank::KERNEL_AVX2;
+    }
+    return DetectorBank::bestKernel();
+}
+
+}
+
+const size_t DetectorBank::WORD_BITS;
+
+DetectorBank::DetectorBank()
+    : levels(NULL), thresholds(NULL), count(0), capacity(0), kernel(configuredKernel()) {
+}
+
+DetectorBank::~DetectorBank() {
+    freeInts(levels);
+    freeInts(thresholds);
+}
+
+void DetectorBank::grow(size_t minimum) {
+    size_t newCapacity = capacity ? capacity * 2 : WORD_BITS;
+    while (newCapacity < minimum) {
+        newCapacity *= 2;
+    }
+    int* newLevels = allocateInts(newCapacity);
+    int* newThresholds = allocateInts(newCapacity);
+    if (count > 0) {
+        std::memcpy(newLevels, levels, count * sizeof(int));
+        std::memcpy(newThresholds, thresholds, count * sizeof(int));
+    }
+    // Padding never fires: nothing is greater than INT_MAX
+    for (size_t i = count; i < newCapacity; ++i) {
+        newLevels[i] = 0;
+        newThresholds[i] = INT_MAX;
+    }
+    freeInts(levels);
+    freeInts(thresholds);
+    levels = newLevels;
+    thresholds = newThresholds;
+    capacity = newCapacity;
+}
+
+size_t DetectorBank::add(int threshold, int level) {
+    if (count == capacity) {
+        grow(count + 1);
+    }
+    levels[count] = level;
+    thresholds[count] = threshold;
+    return count++;
+}
+
+void DetectorBank::resize(size_t newCount, int threshold, int level) {
+    if (newCount > capacity) {
+        grow(newCount);
+    }
+    for (size_t i = count; i < newCount; ++i) {
+        levels[i] = level;
+        thresholds[i] = threshold;
+    }
+    for (size_t i = newCount; i < count; ++i) {
+        levels[i] = 0;
+        thresholds[i] = INT_MAX;
+    }
+    count = newCount;
+}
+
+void DetectorBank::clear() {
+    resize(0, INT_MAX);
+}
+
+size_t DetectorBank::size() const {
+    return count;
+}
+
+int DetectorBank::getLevel(size_t index) const {
+    return levels[index];
+}
+
+void DetectorBank::setLevel(size_t index, int level) {
+    levels[index] = level;
+}
+
+int DetectorBank::getThreshold(size_t index) const {
+    return thresholds[index];
+}
+
+void DetectorBank::setThreshold(size_t index, int threshold) {
+    thresholds[index] = threshold;
+}
+
+int* DetectorBank::levelData() {
+    return levels;
+}
+
+const int* DetectorBank::levelData() const {
+    return levels;
+}
+
+const int* DetectorBank::thresholdData() const {
+    return thresholds;
+}
+
+size_t DetectorBank::evaluate(std::vector<Word>& mask) const {
+    return evaluate(mask, kernel);
+}
+
+size_t DetectorBank::evaluate(std::vector<Word>& mask, Kernel with) const {
+    size_t words = (count + WORD_BITS - 1) / WORD_BITS;
+    mask.resize(words);
+    if (words == 0) {
+        return 0;
+    }
+    switch (with) {
+#ifdef MSH_HAVE_AVX2
+        case KERNEL_AVX2:
+            if (isSupported(KERNEL_AVX2)) {
+                return evaluateAVX2(levels, thresholds, words, &mask[0]);
+            }
+            break;
+#endif
+#ifdef MSH_HAVE_SSE2
+        case KERNEL_SSE2:
+            return evaluateSSE2(levels, thresholds, words, &mask[0]);
+#endif
+        default:
+            break;
+    }
+    return evaluateScalar(levels, thresholds, words, &mask[0]);
+}
+
+DetectorBank::Kernel DetectorBank::getKernel() const {
+    return kernel;
+}
+
+void DetectorBank::setKernel(Kernel with) {
+    kernel = isSupported(with) ? with : bestKernel();
+}
+
+bool DetectorBank::isSupported(Kernel with) {
+    switch (with) {
+        case KERNEL_SCALAR:
+            return true;
+        case KERNEL_SSE2:
+#ifdef MSH_HAVE_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case KERNEL_AVX2:
+#ifdef MSH_HAVE_AVX2
+            return __builtin_cpu_supports("avx2") != 0;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+DetectorBank::Kernel DetectorBank::bestKernel() {
+    if (isSupported(KERNEL_AVX2)) {
+        return KERNEL_AVX2;
+    }
+    if (isSupported(KERNEL_SSE2)) {
+        return KERNEL_SSE2;
+    }
+    return KERNEL_SCALAR;
+}
+
+const char* DetectorBank::kernelName(Kernel with) {
+    switch (with) {
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSE2:   return "sse2";
+        case KERNEL_AVX2:   return "avx2";
+    }
+    return "unknown";
+}
@@ -1,45 +1,64 @@
 #include "Device.h"
+#include "DeviceStateTable.h"
+#include "OutputSink.h"
+#include "DeviceEventBus.h"
+#include <sstream>
 
 Device::Device(const std::string& brand, const std::string& model)
-    : brand(brand), model(model), powerState(false), operationMode(true), observer(NULL) {
+    : brand(brand), model(model), eventBus(NULL), eventRoute(-1), deviceId(-1) {
     name = brand + " " + model;
+    stateSlot = DeviceStateTable::getInstance()->acquire(this);
 }
 
-Device::~Device() {}
+Device::~Device() {
+    DeviceStateTable::getInstance()->release(stateSlot);
+}
 
 void Device::powerOn() {
-    if (!operationMode) {
-        std::cout << "[WARNING] " << name << " is inactive/failed and cannot be powered on." << std::endl;
+    DeviceStateTable* table = DeviceStateTable::getInstance();
+    if (!table->isActive(stateSlot)) {
+        OutputSink::out() << "[WARNING] " << name << " is inactive/failed and cannot be powered on." << std::endl;
         notifyFailure("Device is inactive/failed");
         return;
     }
-    if (!powerState) {
-        powerState = true;
-        doPowerOn();
-        std::cout << "[INFO] " << name << " powered ON." << std::endl;
+    if (!table->isPowered(stateSlot)) {
+        table->setPowered(stateSlot, true);
+        powerChanged(true);
     } else {
-        std::cout << "[INFO] " << name << " is already ON." << std::endl;
+        OutputSink::out() << "[INFO] " << name << " is already ON." << std::endl;
     }
 }
 
 void Device::powerOff() {
-    if (powerState) {
-        powerState = false;
-        doPowerOff();
-        std::cout << "[INFO] " << name << " powered OFF." << std::endl;
+    DeviceStateTable* table = DeviceStateTable::getInstance();
+    if (table->isPowered(stateSlot)) {
+        table->setPowered(stateSlot, false);
+        powerChanged(false);
+    } else {
+        OutputSink::out() << "[INFO] " << name << " is already OFF." << std::endl;
+    }
+}
+
+void Device::powerChanged(bool on) {
+    OutputSink* sink = OutputSink::getInstance();
+    sink->notePowerChange(on);
+    if (on) {
+        doPowerOn();
+        sink->stream() << "[INFO] " << name << " powered ON." << std::endl;
     } else {
-        std::cout << "[INFO] " << name << " is already OFF." << std::endl;
+        doPowerOff();
+        sink->stream() << "[INFO] " << name << " powered OFF." << std::endl;
     }
 }
 
 std::string Device::getStatus() const {
     std::string status = name + " [" + getDeviceType() + "] - ";
-    status += powerState ? "ON" : "OFF";
-    status += operationMode ? " (Active)" : " (FAILED)";
+    status += isPoweredOn() ? "ON" : "OFF";
+    status += isActive() ? " (Active)" : " (FAILED)";
     return status;
 }
 
-std::string Device::getName() const {
+const std::string& Device::getName() const {
     return name;
 }
 
@@ -52,34 +71,76 @@ std::string Device::getModel() const {
 }
 
 bool Device::isPoweredOn() const {
-    return powerState;
+    return DeviceStateTable::getInstance()->isPowered(stateSlot);
 }
 
 bool Device::isActive() const {
-    return operationMode;
+    return DeviceStateTable::getInstance()->isActive(stateSlot);
+}
+
+void Device::setPowerState(bool on) {
+    DeviceStateTable::getInstance()->setPowered(stateSlot, on);
+}
+
+int Device::getLevel() const {
+    return DeviceStateTable::getInstance()->getLevel(stateSlot);
+}
+
+void Device::setLevel(int level) {
+    DeviceStateTable::getInstance()->setLevel(stateSlot, level);
+}
+
+int Device::getDeviceId() const {
+    return deviceId;
+}
+
+void Device::setDeviceId(int id) {
+    deviceId = id;
+}
+
+int Device::getStateSlot() const {
+    return stateSlot;
 }
 
 void Device::setOperationMode(bool active) {
-    operationMode = active;
+    DeviceStateTable::getInstance()->setActive(stateSlot, active);
     if (!active) {
-        std::cout << "[WARNING] " << name << " has been marked as FAILED/INACTIVE." << std::endl;
-        notifyFailure("Device marked as failed");
+        OutputSink::out() << "[WARNING] " << name << " has been marked as FAILED/INACTIVE." << std::endl;
+        notifyFailure("Device marked as failed", SEVERITY_CRITICAL);
     }
 }
 
-void Device::setObserver(IDeviceObserver* obs) {
-    observer = obs;
+void Device::setEventBus(DeviceEventBus* bus, int route) {
+    eventBus = bus;
+    eventRoute = route;
 }
 
-void Device::notifyFailure(const std::string& message) {
-    if (observer) {
-        observer->onDeviceFailure(name, message);
+void Device::notifyFailure(const char* message, EventSeverity severity) {
+    notifyEvent(EVENT_FAILURE, severity, message);
+}
+
+void Device::notifyEvent(DeviceEventType type, EventSeverity severity, const char* message, int value) {
+    if (eventBus) {
+        eventBus->publish(eventRoute, DeviceEvent(*this, type, severity, message, value));
+    }
+}
+
+void IDeviceObserver::onDeviceEvent(const DeviceEvent& event) {
+    // Names repeat across identical models; the ID tells observers which one failed
+    if (event.device.getDeviceId() >= 0) {
+        std::ostringstream label;
+        label << event.device.getName() << " #" << event.device.getDeviceId();
+        onDeviceFailure(label.str(), event.message);
+    } else {
+        onDeviceFailure(event.device.getName(), event.message);
     }
 }
 
 void Device::copyConfigurationFrom(const Device* other) {
     if (other) {
         // Base configuration copy - derived classes override for specific config
-        this->operationMode = other->operationMode;
+        DeviceStateTable::getInstance()->setActive(stateSlot, other->isActive());
     }
 }
+
+void Device::reserveClones(size_t) const {}
@@ -0,0 +1,125 @@
+#include "DeviceEventBus.h"
+
+bool DeviceEventFilter::matches(const std::string& type, const std::string& deviceBrand) const {
+    return (deviceType.empty() || deviceType == type) && (brand.empty() || brand == deviceBrand);
+}
+
+DeviceEventBus::DeviceEventBus()
+    : nextSubscriptionId(1), publishedCount(0), deliveredCount(0) {
+}
+
+int DeviceEventBus::subscribe(IDeviceObserver* observer, const DeviceEventFilter& filter) {
+    if (!observer) {
+        return -1;
+    }
+    Subscription subscription;
+    subscription.id = nextSubscriptionId++;
+    subscription.observer = observer;
+    subscription.filter = filter;
+    subscriptions.push_back(subscription);
+    rebuildRoutes();
+    return subscription.id;
+}
+
+bool DeviceEventBus::unsubscribe(int subscriptionId) {
+    for (std::vector<Subscription>::iterator it = subscriptions.begin(); it != subscriptions.end(); ++it) {
+        if (it->id == subscriptionId) {
+            subscriptions.erase(it);
+            rebuildRoutes();
+            return true;
+        }
+    }
+    return false;
+}
+
+void DeviceEventBus::unsubscribeAll(IDeviceObserver* observer) {
+    size_t kept = 0;
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+        if (subscriptions[i].observer != observer) {
+            subscriptions[kept++] = subscriptions[i];
+        }
+    }
+    if (kept != subscriptions.size()) {
+        subscriptions.resize(kept);
+        rebuildRoutes();
+    }
+}
+
+void DeviceEventBus::buildRoute(Route& route) const {
+    for (int s = 0; s < SEVERITY_COUNT; ++s) {
+        route.subscribers[s].clear();
+    }
+    // Subscription order is kept, so observers see events in the order they subscribed
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+        const Subscription& subscription = subscriptions[i];
+        if (!subscription.filter.matches(route.deviceType, route.brand)) {
+            continue;
+        }
+        for (int s = subscription.filter.minSeverity; s < SEVERITY_COUNT; ++s) {
+            route.subscribers[s].push_back(subscription.observer);
+        }
+    }
+}
+
+void DeviceEventBus::rebuildRoutes() {
+    for (size_t r = 0; r < routes.size(); ++r) {
+        buildRoute(routes[r]);
+    }
+}
+
+void DeviceEventBus::attach(Device* device) {
+    if (!device) {
+        return;
+    }
+    std::string type = device->getDeviceType();
+    std::string brand = device->getBrand();
+    std::string key = type + '\n' + brand;
+
+    int route;
+    std::unordered_map<std::string, int>::const_iterator it = routeIndex.find(key);
+    if (it != routeIndex.end()) {
+        route = it->second;
+    } else {
+        route = (int)routes.size();
+        routes.push_back(Route());
+        routes.back().deviceType = type;
+        routes.back().brand = brand;
+        buildRoute(routes.back());
+        routeIndex[key] = route;
+    }
+    device->setEventBus(this, route);
+}
+
+void DeviceEventBus::detach(Device* device) {
+    if (device) {
+        device->setEventBus(NULL, -1);
+    }
+}
+
+void DeviceEventBus::publish(int route, const DeviceEvent& event) {
+    ++publishedCount;
+    if (route < 0 || (size_t)route >= routes.size()) {
+        return;
+    }
+    const std::vector<IDeviceObserver*>& subscribers = routes[route].subscribers[event.severity];
+    for (size_t i = 0; i < subscribers.size(); ++i) {
+        subscribers[i]->onDeviceEvent(event);
+    }
+    deliveredCount += subscribers.size();
+}
+
+size_t DeviceEventBus::getSubscriptionCount() const {
+    return subscriptions.size();
+}
+
+size_t DeviceEventBus::getRouteCount() const {
+    return routes.size();
+}
+
+unsigned long long DeviceEventBus::getPublishedCount() const {
+    return publishedCount;
+}
+
+unsigned long long DeviceEventBus::getDeliveredCount() const {
+    return deliveredCount;
+}
@@ -0,0 +1,136 @@
+#include "DevicePool.h"
+#include <new>
+#include <iostream>
+#include <iomanip>
+
+DevicePool::DevicePool(const char* name, size_t objectSize, size_t slabObjects)
+    : name(name), objectSize(objectSize), slabObjects(slabObjects ? slabObjects : 1),
+      freeList(NULL), freeCount(0), liveCount(0), capacity(0) {
+    // Every slot must be able to hold the freelist link and stay aligned
+    const size_t align = alignof(std::max_align_t);
+    if (this->objectSize < sizeof(FreeNode)) {
+        this->objectSize = sizeof(FreeNode);
+    }
+    this->objectSize = (this->objectSize + align - 1) / align * align;
+
+    registry().push_back(this);
+}
+
+DevicePool::~DevicePool() {
+    std::vector<DevicePool*>& pools = registry();
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (pools[i] == this) {
+            pools.erase(pools.begin() + i);
+            break;
+        }
+    }
+    // Objects still alive at exit (e.g. leaked by a caller) keep their memory
+    trim();
+}
+
+std::vector<DevicePool*>& DevicePool::registry() {
+    // Constructed by the first pool, so it outlives every pool
+    static std::vector<DevicePool*> pools;
+    return pools;
+}
+
+void DevicePool::addSlab(size_t objects) {
+    char* slab = static_cast<char*>(::operator new(objects * objectSize));
+    slabs.push_back(slab);
+
+    // Thread the new slots onto the freelist back to front so that
+    // allocations walk the slab in address order
+    for (size_t i = objects; i > 0; --i) {
+        FreeNode* node = reinterpret_cast<FreeNode*>(slab + (i - 1) * objectSize);
+        node->next = freeList;
+        freeList = node;
+    }
+    freeCount += objects;
+    capacity += objects;
+}
+
+void* DevicePool::allocate() {
+    if (!freeList) {
+        addSlab(slabObjects);
+    }
+    FreeNode* node = freeList;
+    freeList = node->next;
+    --freeCount;
+    ++liveCount;
+    return node;
+}
+
+void DevicePool::release(void* p) {
+    FreeNode* node = static_cast<FreeNode*>(p);
+    node->next = freeList;
+    freeList = node;
+    ++freeCount;
+    --liveCount;
+}
+
+void DevicePool::reserve(size_t count) {
+    if (count > freeCount) {
+        addSlab(count - freeCount);
+    }
+}
+
+size_t DevicePool::trim() {
+    if (liveCount != 0 || slabs.empty()) {
+        return 0;
+    }
+    size_t released = capacity * objectSize;
+    for (size_t i = 0; i < slabs.size(); ++i) {
+        ::operator delete(slabs[i]);
+    }
+    slabs.clear();
+    freeList = NULL;
+    freeCount = 0;
+    capacity = 0;
+    return released;
+}
+
+const char* DevicePool::getName() const {
+    return name;
+}
+
+size_t DevicePool::getObjectSize() const {
+    return objectSize;
+}
+
+size_t DevicePool::getLiveCount() const {
+    return liveCount;
+}
+
+size_t DevicePool::getCapacity() const {
+    return capacity;
+}
+
+size_t DevicePool::getSlabCount() const {
+    return slabs.size();
+}
+
+const std::vector<DevicePool*>& DevicePool::getPools() {
+    return registry();
+}
+
+size_t DevicePool::trimAll() {
+    size_t released = 0;
+    std::vector<DevicePool*>& pools = registry();
+    for (size_t i = 0; i < pools.size(); ++i) {
+        released += pools[i]->trim();
+    }
+    return released;
+}
+
+void DevicePool::printStats() {
+    const std::vector<DevicePool*>& pools = registry();
+    std::cout << "--- DEVICE POOLS ---" << std::endl;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        const DevicePool* pool = pools[i];
+        std::cout << "  " << std::left << std::setw(26) << pool->getName() << std::right
+                  << " live: " << std::setw(7) << pool->getLiveCount()
+                  << "  capacity: " << std::setw(7) << pool->getCapacity()
+                  << "  slabs: " << std::setw(4) << pool->getSlabCount()
+                  << "  object: " << pool->getObjectSize() << " B" << std::endl;
+    }
+}
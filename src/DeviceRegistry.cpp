@@ -0,0 +1,158 @@
+#include "DeviceRegistry.h"
+#include "Device.h"
+#include "DeviceStateTable.h"
+
+DeviceRegistry::DeviceRegistry() : nextId(1) {}
+
+DeviceRegistry::~DeviceRegistry() {}
+
+int DeviceRegistry::add(Device* device, DeviceKind kind) {
+    if (!device || kind >= KIND_COUNT) {
+        return -1;
+    }
+
+    int id = nextId++;
+    std::vector<int>& bucket = byName[device->getName()];
+
+    Entry entry;
+    entry.device = device;
+    entry.kind = kind;
+    entry.allIndex = allDevices.size();
+    entry.kindIndex = byKind[kind].size();
+    entry.nameIndex = bucket.size();
+    entries[id] = entry;
+
+    allDevices.push_back(device);
+    byKind[kind].push_back(device);
+    bucket.push_back(id);
+
+    device->setDeviceId(id);
+    DeviceStateTable::getInstance()->setKind(device->getStateSlot(), kind);
+    return id;
+}
+
+void DeviceRegistry::swapRemove(std::vector<Device*>& list, size_t index,
+                                std::unordered_map<int, Entry>& entries, size_t Entry::*position) {
+    Device* last = list.back();
+    if (index != list.size() - 1) {
+        list[index] = last;
+        entries[last->getDeviceId()].*position = index;
+    }
+    list.pop_back();
+}
+
+bool DeviceRegistry::remove(Device* device) {
+    return device && remove(device->getDeviceId());
+}
+
+bool DeviceRegistry::remove(int id) {
+    std::unordered_map<int, Entry>::iterator it = entries.find(id);
+    if (it == entries.end()) {
+        return false;
+    }
+    Entry entry = it->second;
+
+    swapRemove(allDevices, entry.allIndex, entries, &Entry::allIndex);
+    swapRemove(byKind[entry.kind], entry.kindIndex, entries, &Entry::kindIndex);
+
+    // Same trick for the name bucket, which holds IDs instead of pointers
+    std::unordered_map<std::string, std::vector<int> >::iterator bucketIt = byName.find(entry.device->getName());
+    if (bucketIt != byName.end()) {
+        std::vector<int>& bucket = bucketIt->second;
+        int lastId = bucket.back();
+        if (entry.nameIndex != bucket.size() - 1) {
+            bucket[entry.nameIndex] = lastId;
+            entries[lastId].nameIndex = entry.nameIndex;
+        }
+        bucket.pop_back();
+        if (bucket.empty()) {
+            byName.erase(bucketIt);
+        }
+    }
+
+    entries.erase(id);
+    entry.device->setDeviceId(-1);
+    DeviceStateTable::getInstance()->clearKind(entry.device->getStateSlot());
+    return true;
+}
+
+void DeviceRegistry::clear() {
+    DeviceStateTable* table = DeviceStateTable::getInstance();
+    for (size_t i = 0; i < allDevices.size(); ++i) {
+        allDevices[i]->setDeviceId(-1);
+        table->clearKind(allDevices[i]->getStateSlot());
+    }
+    entries.clear();
+    byName.clear();
+    allDevices.clear();
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        byKind[k].clear();
+    }
+}
+
+void DeviceRegistry::reserve(DeviceKind kind, size_t count) {
+    if (kind >= KIND_COUNT) {
+        return;
+    }
+    byKind[kind].reserve(byKind[kind].size() + count);
+    allDevices.reserve(allDevices.size() + count);
+    entries.reserve(entries.size() + count);
+}
+
+Device* DeviceRegistry::find(int id) const {
+    std::unordered_map<int, Entry>::const_iterator it = entries.find(id);
+    return it != entries.end() ? it->second.device : NULL;
+}
+
+Device* DeviceRegistry::findByName(const std::string& name) const {
+    std::unordered_map<std::string, std::vector<int> >::const_iterator it = byName.find(name);
+    if (it == byName.end() || it->second.empty()) {
+        return NULL;
+    }
+    return find(it->second.front());
+}
+
+std::vector<Device*> DeviceRegistry::findAllByName(const std::string& name) const {
+    std::vector<Device*> result;
+    std::unordered_map<std::string, std::vector<int> >::const_iterator it = byName.find(name);
+    if (it != byName.end()) {
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            result.push_back(find(it->second[i]));
+        }
+    }
+    return result;
+}
+
+bool DeviceRegistry::getKind(int id, DeviceKind& kind) const {
+    std::unordered_map<int, Entry>::const_iterator it = entries.find(id);
+    if (it == entries.end()) {
+        return false;
+    }
+    kind = it->second.kind;
+    return true;
+}
+
+bool DeviceRegistry::getKindIndex(int id, size_t& index) const {
+    std::unordered_map<int, Entry>::const_iterator it = entries.find(id);
+    if (it == entries.end()) {
+        return false;
+    }
+    index = it->second.kindIndex;
+    return true;
+}
+
+const std::vector<Device*>& DeviceRegistry::getDevices() const {
+    return allDevices;
+}
+
+const std::vector<Device*>& DeviceRegistry::getDevices(DeviceKind kind) const {
+    return byKind[kind < KIND_COUNT ? kind : KIND_LIGHT];
+}
+
+size_t DeviceRegistry::size() const {
+    return allDevices.size();
+}
+
+size_t DeviceRegistry::size(DeviceKind kind) const {
+    return kind < KIND_COUNT ? byKind[kind].size() : 0;
+}
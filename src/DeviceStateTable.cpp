@@ -0,0 +1,324 @@
+#include "DeviceStateTable.h"
+#include "Device.h"
+
+DeviceStateTable* DeviceStateTable::instance = NULL;
+
+namespace {
+
+inline size_t popcount(DeviceStateTable::Word w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_popcountll(w);
+#else
+    size_t n = 0;
+    while (w) {
+        w &= w - 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline int lowestBit(DeviceStateTable::Word w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    while (!(w & 1)) {
+        w >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+size_t countBits(const std::vector<DeviceStateTable::Word>& bits) {
+    size_t n = 0;
+    for (size_t w = 0; w < bits.size(); ++w) {
+        n += popcount(bits[w]);
+    }
+    return n;
+}
+
+}
+
+DeviceStateTable::DeviceStateTable() : colorNames(1) {}
+
+DeviceStateTable* DeviceStateTable::getInstance() {
+    if (instance == NULL) {
+        instance = new DeviceStateTable();
+    }
+    return instance;
+}
+
+bool DeviceStateTable::testBit(const std::vector<Word>& bits, int slot) {
+    return (bits[slot / WORD_BITS] >> (slot % WORD_BITS)) & 1;
+}
+
+void DeviceStateTable::assignBit(std::vector<Word>& bits, int slot, bool value) {
+    Word bit = (Word)1 << (slot % WORD_BITS);
+    if (value) {
+        bits[slot / WORD_BITS] |= bit;
+    } else {
+        bits[slot / WORD_BITS] &= ~bit;
+    }
+}
+
+int DeviceStateTable::acquire(Device* owner) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        owners[slot] = owner;
+    } else {
+        slot = (int)owners.size();
+        owners.push_back(owner);
+        levels.push_back(0);
+        colors.push_back(0);
+        if (slot % WORD_BITS == 0) {
+            // Grow every bit column by one word
+            usedBits.push_back(0);
+            powerBits.push_back(0);
+            activeBits.push_back(0);
+            registeredBits.push_back(0);
+            musicBits.push_back(0);
+            for (int k = 0; k < KIND_COUNT; ++k) {
+                kindBits[k].push_back(0);
+            }
+        }
+    }
+
+    // New devices start powered off and active
+    assignBit(usedBits, slot, true);
+    assignBit(powerBits, slot, false);
+    assignBit(activeBits, slot, true);
+    assignBit(musicBits, slot, false);
+    levels[slot] = 0;
+    colors[slot] = 0;
+    return slot;
+}
+
+void DeviceStateTable::release(int slot) {
+    if (slot < 0 || slot >= (int)owners.size()) {
+        return;
+    }
+    clearKind(slot);
+    assignBit(usedBits, slot, false);
+    assignBit(powerBits, slot, false);
+    assignBit(activeBits, slot, false);
+    assignBit(musicBits, slot, false);
+    owners[slot] = NULL;
+    freeSlots.push_back(slot);
+}
+
+bool DeviceStateTable::isPowered(int slot) const {
+    return testBit(powerBits, slot);
+}
+
+void DeviceStateTable::setPowered(int slot, bool on) {
+    assignBit(powerBits, slot, on);
+}
+
+bool DeviceStateTable::isActive(int slot) const {
+    return testBit(activeBits, slot);
+}
+
+void DeviceStateTable::setActive(int slot, bool active) {
+    assignBit(activeBits, slot, active);
+}
+
+int DeviceStateTable::getLevel(int slot) const {
+    return levels[slot];
+}
+
+void DeviceStateTable::setLevel(int slot, int level) {
+    if (level < 0) level = 0;
+    if (level > 100) level = 100;
+    levels[slot] = (unsigned char)level;
+}
+
+const std::string& DeviceStateTable::getColor(int slot) const {
+    return colorNames[colors[slot]];
+}
+
+void DeviceStateTable::setColor(int slot, const std::string& color) {
+    colors[slot] = (unsigned short)internColor(color);
+}
+
+bool DeviceStateTable::isPlayingMusic(int slot) const {
+    return testBit(musicBits, slot);
+}
+
+void DeviceStateTable::setPlayingMusic(int slot, bool playing) {
+    assignBit(musicBits, slot, playing);
+}
+
+// Homes use a handful of colours, so a linear search is enough
+int DeviceStateTable::internColor(const std::string& color) {
+    for (size_t i = 0; i < colorNames.size(); ++i) {
+        if (colorNames[i] == color) {
+            return (int)i;
+        }
+    }
+    if (colorNames.size() > 0xFFFF) {
+        return 0;
+    }
+    colorNames.push_back(color);
+    return (int)colorNames.size() - 1;
+}
+
+void DeviceStateTable::setKind(int slot, DeviceKind kind) {
+    clearKind(slot);
+    if (kind < KIND_COUNT) {
+        assignBit(kindBits[kind], slot, true);
+        assignBit(registeredBits, slot, true);
+    }
+}
+
+void DeviceStateTable::clearKind(int slot) {
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        assignBit(kindBits[k], slot, false);
+    }
+    assignBit(registeredBits, slot, false);
+}
+
+size_t DeviceStateTable::applyPower(const std::vector<Word>& mask, bool on) {
+    size_t changed = 0;
+    size_t words = mask.size();
+
+    for (size_t w = 0; w < words; ++w) {
+        Word flip;
+        Word refused = 0;
+        if (on) {
+            flip = mask[w] & ~powerBits[w] & activeBits[w];
+            // Failed devices go through Device::powerOn for the warning/notification
+            refused = mask[w] & ~powerBits[w] & ~activeBits[w] & usedBits[w];
+            powerBits[w] |= flip;
+        } else {
+            flip = mask[w] & powerBits[w];
+            powerBits[w] &= ~flip;
+        }
+
+        // Bits are already updated; now run the hooks of the devices that flipped
+        while (flip) {
+            int slot = (int)(w * WORD_BITS) + lowestBit(flip);
+            flip &= flip - 1;
+            owners[slot]->powerChanged(on);
+            ++changed;
+        }
+        while (refused) {
+            int slot = (int)(w * WORD_BITS) + lowestBit(refused);
+            refused &= refused - 1;
+            owners[slot]->powerOn();
+        }
+    }
+    return changed;
+}
+
+size_t DeviceStateTable::setPower(DeviceKind kind, bool on) {
+    if (kind >= KIND_COUNT) {
+        return 0;
+    }
+    return applyPower(kindBits[kind], on);
+}
+
+size_t DeviceStateTable::setPowerAll(bool on) {
+    return applyPower(registeredBits, on);
+}
+
+size_t DeviceStateTable::setPower(const std::vector<Device*>& devices, bool on) {
+    std::vector<Word> mask(usedBits.size(), 0);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        int slot = devices[i]->getStateSlot();
+        mask[slot / WORD_BITS] |= (Word)1 << (slot % WORD_BITS);
+    }
+    return applyPower(mask, on);
+}
+
+size_t DeviceStateTable::setPower(const std::vector<Word>& mask, bool on) {
+    if (mask.size() > usedBits.size()) {
+        return 0;
+    }
+    return applyPower(mask, on);
+}
+
+size_t DeviceStateTable::diffPower(DeviceKind kind, bool on, std::vector<Word>& mask) const {
+    mask.assign(powerBits.size(), 0);
+    if (kind >= KIND_COUNT) {
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t w = 0; w < powerBits.size(); ++w) {
+        mask[w] = kindBits[kind][w] & (on ? ~powerBits[w] : powerBits[w]);
+        n += popcount(mask[w]);
+    }
+    return n;
+}
+
+size_t DeviceStateTable::diffSettings(DeviceKind kind, int level, int color, bool music,
+                                      std::vector<Word>& mask) const {
+    mask.assign(powerBits.size(), 0);
+    if (kind >= KIND_COUNT) {
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t w = 0; w < powerBits.size(); ++w) {
+        Word slots = kindBits[kind][w];
+        Word differ = music ? (slots & powerBits[w] & ~musicBits[w]) : 0;
+        if (level >= 0 || color >= 0) {
+            Word rest = slots & ~differ;
+            while (rest) {
+                int bit = lowestBit(rest);
+                rest &= rest - 1;
+                size_t slot = w * WORD_BITS + bit;
+                if ((level >= 0 && levels[slot] != level) || (color >= 0 && colors[slot] != color)) {
+                    differ |= (Word)1 << bit;
+                }
+            }
+        }
+        mask[w] = differ;
+        n += popcount(differ);
+    }
+    return n;
+}
+
+Device* DeviceStateTable::getOwner(int slot) const {
+    if (slot < 0 || slot >= (int)owners.size()) {
+        return NULL;
+    }
+    return owners[slot];
+}
+
+size_t DeviceStateTable::countRegistered() const {
+    return countBits(registeredBits);
+}
+
+size_t DeviceStateTable::countPowered() const {
+    size_t n = 0;
+    for (size_t w = 0; w < powerBits.size(); ++w) {
+        n += popcount(powerBits[w] & registeredBits[w]);
+    }
+    return n;
+}
+
+size_t DeviceStateTable::countPowered(DeviceKind kind) const {
+    if (kind >= KIND_COUNT) {
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t w = 0; w < powerBits.size(); ++w) {
+        n += popcount(powerBits[w] & kindBits[kind][w]);
+    }
+    return n;
+}
+
+size_t DeviceStateTable::countFailed() const {
+    size_t n = 0;
+    for (size_t w = 0; w < activeBits.size(); ++w) {
+        n += popcount(~activeBits[w] & registeredBits[w]);
+    }
+    return n;
+}
+
+size_t DeviceStateTable::getSlotCount() const {
+    return owners.size();
+}
@@ -0,0 +1,270 @@
+#include "EventLog.h"
+#include "BinaryCodec.h"
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+
+const char EventLog::MAGIC[8] = { 'M', 'S', 'H', 'E', 'V', 'T', '1', '\n' };
+
+// EventLog Implementation
+EventLog::EventLog() : lastTimestamp(0), isOpen(false) {}
+
+EventLog::~EventLog() {
+    close();
+}
+
+bool EventLog::open(const std::string& fname, long long timestamp) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isOpen) {
+        writeBuffer();
+        file.close();
+    }
+
+    file.open(fname.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+    if (!file.is_open()) {
+        isOpen = false;
+        return false;
+    }
+    isOpen = true;
+    stringIds.clear();
+    buffer.clear();
+
+    // New (empty) file gets the magic header
+    file.seekp(0, std::ios::end);
+    if (file.tellp() == std::streampos(0)) {
+        buffer.append(MAGIC, sizeof(MAGIC));
+    }
+
+    // Session start carries the absolute time base for the deltas that follow
+    std::string body;
+    lastTimestamp = 0;
+    beginRecord(EVENT_SESSION_START, timestamp, body);
+    endRecord(body);
+    return true;
+}
+
+void EventLog::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isOpen) {
+        writeBuffer();
+        file.close();
+        isOpen = false;
+    }
+}
+
+bool EventLog::isFileOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return isOpen;
+}
+
+void EventLog::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isOpen) {
+        writeBuffer();
+    }
+}
+
+void EventLog::writeBuffer() {
+    if (!buffer.empty()) {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    file.flush();
+}
+
+unsigned EventLog::intern(const std::string& text) {
+    std::unordered_map<std::string, unsigned>::const_iterator it = stringIds.find(text);
+    if (it != stringIds.end()) {
+        return it->second;
+    }
+
+    unsigned id = (unsigned)stringIds.size();
+    stringIds[text] = id;
+
+    std::string body;
+    beginRecord(EVENT_DEFINE_STRING, lastTimestamp, body);
+    BinaryCodec::putVarint(body, id);
+    body += text;
+    endRecord(body);
+    return id;
+}
+
+void EventLog::beginRecord(EventType type, long long timestamp, std::string& body) {
+    body.clear();
+    body += (char)type;
+    BinaryCodec::putSignedVarint(body, timestamp - lastTimestamp);
+    lastTimestamp = timestamp;
+}
+
+void EventLog::endRecord(const std::string& body) {
+    BinaryCodec::putVarint(buffer, body.size());
+    buffer += body;
+    if (buffer.size() >= FLUSH_THRESHOLD) {
+        writeBuffer();
+    }
+}
+
+void EventLog::recordMenuSelection(long long timestamp, int option) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isOpen) return;
+
+    std::string body;
+    beginRecord(EVENT_MENU_SELECTION, timestamp, body);
+    BinaryCodec::putSignedVarint(body, option);
+    endRecord(body);
+}
+
+void EventLog::recordDeviceOperation(long long timestamp, const std::string& deviceName,
+                                     const std::string& operation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isOpen) return;
+
+    // Intern first - definitions must precede the record that uses them
+    unsigned deviceId = intern(deviceName);
+    unsigned operationId = intern(operation);
+
+    std::string body;
+    beginRecord(EVENT_DEVICE_OPERATION, timestamp, body);
+    BinaryCodec::putVarint(body, deviceId);
+    BinaryCodec::putVarint(body, operationId);
+    endRecord(body);
+}
+
+void EventLog::recordModeChange(long long timestamp, const std::string& fromMode, const std::string& toMode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isOpen) return;
+
+    unsigned fromId = intern(fromMode);
+    unsigned toId = intern(toMode);
+
+    std::string body;
+    beginRecord(EVENT_MODE_CHANGE, timestamp, body);
+    BinaryCodec::putVarint(body, fromId);
+    BinaryCodec::putVarint(body, toId);
+    endRecord(body);
+}
+
+void EventLog::recordStateChange(long long timestamp, const std::string& fromState, const std::string& toState) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isOpen) return;
+
+    unsigned fromId = intern(fromState);
+    unsigned toId = intern(toState);
+
+    std::string body;
+    beginRecord(EVENT_STATE_CHANGE, timestamp, body);
+    BinaryCodec::putVarint(body, fromId);
+    BinaryCodec::putVarint(body, toId);
+    endRecord(body);
+}
+
+// DecodedEvent Implementation
+std::string DecodedEvent::toText() const {
+    char buffer[16];
+    switch (type) {
+        case EventLog::EVENT_MENU_SELECTION:
+            snprintf(buffer, sizeof(buffer), "%d", number);
+            return "[INFO] Menu option selected: " + std::string(buffer);
+        case EventLog::EVENT_DEVICE_OPERATION:
+            return "[INFO] Device '" + first + "': " + second;
+        case EventLog::EVENT_MODE_CHANGE:
+            return "[INFO] Mode changed: " + first + " -> " + second;
+        case EventLog::EVENT_STATE_CHANGE:
+            return "[INFO] State changed: " + first + " -> " + second;
+        default:
+            return "";
+    }
+}
+
+// EventLogReader Implementation
+EventLogReader::EventLogReader() : position(0), lastTimestamp(0) {}
+
+bool EventLogReader::open(const std::string& fname) {
+    std::ifstream in(fname.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        error = "cannot open " + fname;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(EventLog::MAGIC) ||
+        memcmp(&data[0], EventLog::MAGIC, sizeof(EventLog::MAGIC)) != 0) {
+        error = "not an msh event log: " + fname;
+        return false;
+    }
+    position = sizeof(EventLog::MAGIC);
+    return true;
+}
+
+bool EventLogReader::next(DecodedEvent& event) {
+    const char* bytes = data.empty() ? NULL : &data[0];
+    size_t size = data.size();
+
+    while (position < size) {
+        unsigned long long length;
+        if (!BinaryCodec::getVarint(bytes, size, position, length) || length == 0 || position + length > size) {
+            error = "truncated record";
+            return false;
+        }
+        size_t end = position + (size_t)length;
+        EventLog::EventType type = (EventLog::EventType)(unsigned char)bytes[position++];
+
+        unsigned long long raw;
+        if (!BinaryCodec::getVarint(bytes, end, position, raw)) {
+            error = "corrupt timestamp";
+            return false;
+        }
+        long long timestamp = (type == EventLog::EVENT_SESSION_START ? 0 : lastTimestamp) + BinaryCodec::unzigzag(raw);
+        lastTimestamp = timestamp;
+
+        unsigned long long a = 0, b = 0;
+        switch (type) {
+            case EventLog::EVENT_SESSION_START:
+                strings.clear();
+                position = end;
+                continue;
+            case EventLog::EVENT_DEFINE_STRING:
+                if (!BinaryCodec::getVarint(bytes, end, position, a)) break;
+                if (strings.size() <= a) strings.resize((size_t)a + 1);
+                strings[(size_t)a].assign(bytes + position, end - position);
+                position = end;
+                continue;
+            case EventLog::EVENT_MENU_SELECTION:
+                if (!BinaryCodec::getVarint(bytes, end, position, a)) break;
+                event.type = type;
+                event.timestamp = timestamp;
+                event.number = (int)BinaryCodec::unzigzag(a);
+                event.first.clear();
+                event.second.clear();
+                position = end;
+                return true;
+            case EventLog::EVENT_DEVICE_OPERATION:
+            case EventLog::EVENT_MODE_CHANGE:
+            case EventLog::EVENT_STATE_CHANGE:
+                if (!BinaryCodec::getVarint(bytes, end, position, a) || !BinaryCodec::getVarint(bytes, end, position, b)) break;
+                if (a >= strings.size() || b >= strings.size()) break;
+                event.type = type;
+                event.timestamp = timestamp;
+                event.number = 0;
+                event.first = strings[(size_t)a];
+                event.second = strings[(size_t)b];
+                position = end;
+                return true;
+            default:
+                // Unknown type from a newer writer - skip it
+                position = end;
+                continue;
+        }
+        error = "corrupt record body";
+        return false;
+    }
+    return false;
+}
+
+std::string EventLogReader::getError() const {
+    return error;
+}
+
+size_t EventLogReader::getFileSize() const {
+    return data.size();
+}
@@ -25,18 +25,29 @@ std::string GasDetector::getDeviceType() const {
 
 std::string GasDetector::getStatus() const {
     std::ostringstream oss;
-    oss << Detector::getStatus() << " | Gas Level: " << gasLevel << "% (" << gasType << ")";
+    oss << Detector::getStatus() << " | Gas Level: " << getGasLevel() << "% (" << gasType << ")";
     return oss.str();
 }
 
 void GasDetector::detect() {
-    if (!powerState || !operationMode) return;
-    
-    if (gasLevel > (10 - sensitivityLevel) * 10) {
-        detected = true;
-        std::cout << "[ALERT] " << name << " detected GAS! Level: " << gasLevel 
-                  << "% (" << gasType << ")" << std::endl;
-    }
+    checkDetection(getGasLevel());
+}
+
+int GasDetector::getReading() const {
+    return getGasLevel();
+}
+
+void GasDetector::recordLevel(int level) {
+    gasLevel = level;
+}
+
+void GasDetector::printAlert(int level) const {
+    std::cout << "[ALERT] " << name << " detected GAS! Level: " << level 
+              << "% (" << gasType << ")" << std::endl;
+}
+
+const char* GasDetector::detectionMessage() const {
+    return "Gas detected";
 }
 
 void GasDetector::trigger() {
@@ -44,14 +55,15 @@ void GasDetector::trigger() {
 }
 
 int GasDetector::getGasLevel() const {
-    return gasLevel;
+    return currentLevel(gasLevel);
 }
 
 void GasDetector::setGasLevel(int level) {
     if (level < 0) level = 0;
     if (level > 100) level = 100;
     gasLevel = level;
-    detect();  // Auto-check after level change
+    levelChanged(level);
+    evaluateReading(level);  // Auto-check after level change
 }
 
 std::string GasDetector::getGasType() const {
@@ -73,6 +85,8 @@ Device* NestGasDetector::clone() const {
     return newDet;
 }
 
+MSH_DEFINE_POOLED_DEVICE(NestGasDetector)
+
 // Kidde Gas Detector
 KiddeGasDetector::KiddeGasDetector()
     : GasDetector("Kidde", "Nighthawk") {
@@ -87,3 +101,5 @@ Device* KiddeGasDetector::clone() const {
     newDet->copyConfigurationFrom(this);
     return newDet;
 }
+
+MSH_DEFINE_POOLED_DEVICE(KiddeGasDetector)
@@ -21,56 +21,75 @@
 #include "Storage.h"
 #include "ModeManager.h"
 #include "StateManager.h"
+#include "SnapshotStore.h"
 #include "SecuritySystem.h"
 #include "NotificationSystem.h"
+#include "DeviceEventBus.h"
+#include "SensorPipeline.h"
+#include "LevelHistory.h"
 #include "DeviceFactory.h"
+#include "DevicePool.h"
+#include "DeviceStateTable.h"
+#include "OutputSink.h"
 #include <iostream>
+#include <chrono>
 #include <sstream>
 
 HomeController::HomeController() : isRunning(false) {
+    registry = new DeviceRegistry();
+    
     // Initialize singletons
     alarm = Alarm::getInstance();
     storage = Storage::getInstance();
+    stateTable = DeviceStateTable::getInstance();
     
     // Initialize managers
     menu = new Menu();
     modeManager = new ModeManager();
     stateManager = new StateManager();
     
-    // Initialize notification system
+    // Initialize notification system; it hears every warning or worse
+    eventBus = new DeviceEventBus();
     notificationSystem = new NotificationSystem();
+    eventBus->subscribe(notificationSystem, DeviceEventFilter("", "", SEVERITY_WARNING));
     
-    // Set alarm observer
-    alarm->setObserver(notificationSystem);
+    // The alarm singleton reports through the bus too
+    eventBus->attach(alarm);
+    sensorPipeline = new SensorPipeline();
+    levelHistory = new LevelHistory();
     
-    // Initialize default devices
+    // Initialize default devices (also fills lightPtrs)
     initializeDefaultDevices();
     
-    // Update light pointers for systems
-    updateLightPtrs();
-    
-    // Initialize security and detection systems
-    securitySystem = new SecuritySystem(alarm, &lightPtrs);
+    // Initialize security and detection systems; detector alerts reach the
+    // security rules through the bus
+    securitySystem = new SecuritySystem(alarm, &lightPtrs, registry, notificationSystem);
+    eventBus->subscribe(securitySystem, DeviceEventFilter("", "", SEVERITY_CRITICAL));
 }
 
 HomeController::~HomeController() {
-    // Clean up devices
+    // Clean up devices - unregister first, the registry still touches them
+    std::vector<Device*> allDevices(registry->getDevices());
+    registry->clear();
+    lightPtrs.clear();
     for (size_t i = 0; i < allDevices.size(); ++i) {
         delete allDevices[i];
     }
-    allDevices.clear();
-    lights.clear();
-    cameras.clear();
-    televisions.clear();
-    smokeDetectors.clear();
-    gasDetectors.clear();
-    soundSystems.clear();
+    
+    // Every pooled device is gone now - hand the slabs back in one go
+    DevicePool::trimAll();
+    delete registry;
     
     // Clean up managers and systems
     delete menu;
     delete modeManager;
     delete stateManager;
+    eventBus->unsubscribeAll(securitySystem);
     delete securitySystem;
+    delete sensorPipeline;
+    delete levelHistory;
+    eventBus->detach(alarm);   // The singleton outlives the bus
+    delete eventBus;
     delete notificationSystem;
     
     // Note: Alarm and Storage are singletons, not deleted here
@@ -85,34 +104,61 @@ void HomeController::initializeDefaultDevices() {
     addSoundSystem(1);   // Sonos
 }
 
-void HomeController::registerDevice(Device* device) {
+void HomeController::registerDevice(Device* device, DeviceKind kind) {
     if (device) {
-        device->setObserver(notificationSystem);
-        allDevices.push_back(device);
+        registry->add(device, kind);
+        eventBus->attach(device);
+        if (kind == KIND_SMOKE_DETECTOR || kind == KIND_GAS_DETECTOR) {
+            levelHistory->attach(static_cast<Detector*>(device));
+            sensorPipeline->attach(static_cast<Detector*>(device));
+        }
+        
+        // lightPtrs mirrors the registry's light view element for element;
+        // only Light objects are ever registered as KIND_LIGHT
+        if (kind == KIND_LIGHT) {
+            lightPtrs.push_back(static_cast<Light*>(device));
+        }
     }
 }
 
 void HomeController::unregisterDevice(Device* device) {
-    for (std::vector<Device*>::iterator it = allDevices.begin(); it != allDevices.end(); ++it) {
-        if (*it == device) {
-            allDevices.erase(it);
-            break;
-        }
+    if (!device) {
+        return;
+    }
+    
+    DeviceKind kind = KIND_COUNT;
+    size_t index = 0;
+    bool isLight = registry->getKind(device->getDeviceId(), kind) && kind == KIND_LIGHT &&
+                   registry->getKindIndex(device->getDeviceId(), index);
+    
+    eventBus->detach(device);
+    if (kind == KIND_SMOKE_DETECTOR || kind == KIND_GAS_DETECTOR) {
+        sensorPipeline->detach(static_cast<Detector*>(device));
+        levelHistory->detach(static_cast<Detector*>(device));
+    }
+    if (registry->remove(device) && isLight) {
+        // Same swap-remove the registry just did on its light view
+        lightPtrs[index] = lightPtrs.back();
+        lightPtrs.pop_back();
     }
 }
 
-void HomeController::updateLightPtrs() {
-    lightPtrs.clear();
-    for (size_t i = 0; i < lights.size(); ++i) {
-        Light* light = dynamic_cast<Light*>(lights[i]);
-        if (light) {
-            lightPtrs.push_back(light);
-        }
+bool HomeController::kindFromChar(char deviceType, DeviceKind& kind) {
+    switch (deviceType) {
+        case 'L': case 'l': kind = KIND_LIGHT; return true;
+        case 'C': case 'c': kind = KIND_CAMERA; return true;
+        case 'T': case 't': kind = KIND_TELEVISION; return true;
+        case 'D': case 'd': kind = KIND_SMOKE_DETECTOR; return true;
+        case 'S': case 's': kind = KIND_SOUND_SYSTEM; return true;
+        default: return false;
     }
 }
 
 void HomeController::start() {
-    // Open log file
+    // Open log file (writes are batched on a background thread,
+    // segments roll over at 16 MB and the newest 8 are kept)
+    storage->enableAsync();
+    storage->setRotationPolicy(16 * 1024 * 1024, 0, 8);
     storage->openFile("msh_log.txt");
     storage->logSystemStart();
     
@@ -124,20 +170,46 @@ void HomeController::start() {
     std::cout << "============================================" << std::endl;
     std::cout << std::endl;
     
-    // Apply default mode (Normal)
-    std::cout << "[INIT] Applying default mode (Normal)..." << std::endl;
-    modeManager->applyMode(lights, televisions, soundSystems);
+    OutputSink* sink = OutputSink::getInstance();
+    if (sink->getMode() != OutputSink::OUTPUT_VERBOSE) {
+        std::cout << "[INIT] Device output: " << OutputSink::modeName(sink->getMode())
+                  << " (set MSH_OUTPUT=verbose for every line)" << std::endl;
+    }
+    
+    // Resume the last persisted snapshot, or fall back to the defaults
+    StoredSnapshot resumed;
+    bool found = false;
+    stateManager->openStore(SnapshotStore::DEFAULT_PATH, resumed, found);
+    if (found) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        std::cout << "[INIT] Resuming last snapshot (" << resumed.stateName << " state, "
+                  << resumed.modeName << " mode)..." << std::endl;
+        modeManager->setModeByName(resumed.modeName);
+        stateManager->setStateByName(resumed.stateName);
+        size_t changed = applySnapshot(resumed.power, "[INIT] Resume");
+        std::cout << "[INIT] " << changed << " device(s) changed in " << millisSince(begin) << " ms." << std::endl;
+    } else {
+        // Apply default mode (Normal)
+        std::cout << "[INIT] Applying default mode (Normal)..." << std::endl;
+        modeManager->applyMode(*registry);
+        
+        // Apply default state (Normal)
+        std::cout << "[INIT] Applying default state (Normal)..." << std::endl;
+        stateManager->applyState();
+    }
     
-    // Apply default state (Normal)
-    std::cout << "[INIT] Applying default state (Normal)..." << std::endl;
-    stateManager->applyState();
+    // Detector level history from the last run
+    size_t restored = 0;
+    if (levelHistory->load(LevelHistory::DEFAULT_PATH, restored) && restored > 0) {
+        std::cout << "[INIT] Restored level history of " << restored << " detector(s)." << std::endl;
+    }
     
     // Activate security system
     std::cout << "[INIT] Activating security system..." << std::endl;
     securitySystem->activate();
     
     // Save initial state
-    stateManager->saveState(modeManager->getCurrentModeName(), allDevices);
+    stateManager->saveState(modeManager->getCurrentModeName(), registry->getDevices());
     
     std::cout << std::endl;
     std::cout << "[INIT] System initialization complete!" << std::endl;
@@ -200,12 +272,20 @@ void HomeController::shutdown() {
     std::cout << "      MY SWEET HOME SYSTEM SHUTTING DOWN   " << std::endl;
     std::cout << "============================================" << std::endl;
     
+    // Remember the running device state for the next start
+    stateManager->persistState(modeManager->getCurrentModeName(), registry->getDevices());
+    stateManager->syncStore();
+    if (!levelHistory->save(LevelHistory::DEFAULT_PATH)) {
+        std::cout << "[WARNING] Could not save detector level history to " << LevelHistory::DEFAULT_PATH << std::endl;
+    }
+    
     // Deactivate systems
     securitySystem->deactivate();
     
     // Power off all non-critical devices
-    for (size_t i = 0; i < allDevices.size(); ++i) {
-        allDevices[i]->powerOff();
+    {
+        OutputBatch batch("[INFO] Shutdown");
+        stateTable->setPowerAll(false);
     }
     
     storage->logSystemShutdown();
@@ -283,28 +363,28 @@ void HomeController::handleRemoveDevice() {
         return;
     }
     
-    std::vector<Device*>* targetList = NULL;
+    const std::vector<Device*>* targetList = NULL;
     std::string typeName;
     
     switch (choice) {
         case 'L': case 'l':
-            targetList = &lights;
+            targetList = &registry->getDevices(KIND_LIGHT);
             typeName = "Light";
             break;
         case 'C': case 'c':
-            targetList = &cameras;
+            targetList = &registry->getDevices(KIND_CAMERA);
             typeName = "Camera";
             break;
         case 'T': case 't':
-            targetList = &televisions;
+            targetList = &registry->getDevices(KIND_TELEVISION);
             typeName = "TV";
             break;
         case 'D': case 'd':
-            targetList = &smokeDetectors;
+            targetList = &registry->getDevices(KIND_SMOKE_DETECTOR);
             typeName = "Detector";
             break;
         case 'S': case 's':
-            targetList = &soundSystems;
+            targetList = &registry->getDevices(KIND_SOUND_SYSTEM);
             typeName = "Sound System";
             break;
         default:
@@ -349,9 +429,11 @@ void HomeController::handlePowerOff() {
 }
 
 void HomeController::handleChangeMode() {
+    // Pick up edits to the mode file without a restart
+    modeManager->reloadIfChanged();
     std::string oldMode = modeManager->getCurrentModeName();
     
-    menu->displayModeSubmenu();
+    menu->displayModeSubmenu(modeManager->getModes());
     char choice = menu->getCharChoice();
     
     if (choice == 'Q' || choice == 'q') {
@@ -359,10 +441,10 @@ void HomeController::handleChangeMode() {
     }
     
     modeManager->setMode(choice);
-    modeManager->applyMode(lights, televisions, soundSystems);
+    modeManager->applyMode(*registry);
     
     // Save state after mode change
-    stateManager->saveState(modeManager->getCurrentModeName(), allDevices);
+    stateManager->saveState(modeManager->getCurrentModeName(), registry->getDevices());
     
     storage->logModeChange(oldMode, modeManager->getCurrentModeName());
 }
@@ -377,16 +459,68 @@ void HomeController::handleChangeState() {
         return;
     }
     
-    stateManager->setState(choice);
-    
-    // Save state after state change (except for 'previous' which restores)
-    if (choice != 'P' && choice != 'p') {
-        stateManager->saveState(modeManager->getCurrentModeName(), allDevices);
+    // Save state after state change ('previous' restores instead)
+    if (choice == 'P' || choice == 'p') {
+        restoreHistory(true);
+    } else {
+        stateManager->setState(choice);
+        stateManager->saveState(modeManager->getCurrentModeName(), registry->getDevices());
     }
     
     storage->logStateChange(oldState, stateManager->getCurrentStateName());
 }
 
+bool HomeController::restoreHistory(bool previous) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool moved = previous ? stateManager->restorePreviousState() : stateManager->restoreNextState();
+    if (!moved) {
+        return false;
+    }
+
+    int index = stateManager->getCurrentHistoryIndex();
+    const HomeMemento* memento = stateManager->getMemento(index);
+    PowerSnapshot snapshot;
+    stateManager->getSnapshot(index, snapshot);
+    modeManager->setModeByName(memento->getModeName());
+    size_t changed = applySnapshot(snapshot, "[INFO] State restore");
+
+    // The restored state is what a restart should resume
+    stateManager->persistState(memento->getModeName(), registry->getDevices());
+
+    std::cout << "[INFO] Restored " << memento->getStateName() << " state, " << memento->getModeName()
+              << " mode: " << changed << " device(s) changed in " << millisSince(start) << " ms." << std::endl;
+    return true;
+}
+
+size_t HomeController::applySnapshot(const PowerSnapshot& snapshot, const std::string& label) {
+    // Only devices whose power differs from the snapshot are touched; devices
+    // the snapshot does not know keep their state
+    std::vector<Device*> toPowerOn;
+    std::vector<Device*> toPowerOff;
+    const std::vector<Device*>& devices = registry->getDevices();
+    for (size_t i = 0; i < devices.size(); ++i) {
+        int id = devices[i]->getDeviceId();
+        if (!snapshot.contains(id) || snapshot.isPowered(id) == devices[i]->isPoweredOn()) {
+            continue;
+        }
+        if (snapshot.isPowered(id)) {
+            toPowerOn.push_back(devices[i]);
+        } else {
+            toPowerOff.push_back(devices[i]);
+        }
+    }
+
+    OutputBatch batch(label);
+    size_t changed = stateTable->setPower(toPowerOff, false);
+    changed += stateTable->setPower(toPowerOn, true);
+    return changed;
+}
+
+double HomeController::millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count() / 1000.0;
+}
+
 void HomeController::handleManual() {
     menu->displayManual();
     storage->logInfo("Manual displayed");
@@ -409,28 +543,32 @@ void HomeController::handleShutdown() {
 
 void HomeController::addDevices(char deviceType, int count, int brandChoice) {
     Device* prototype = NULL;
-    std::vector<Device*>* targetList = NULL;
+    const std::vector<Device*>* targetList = NULL;
+    DeviceKind kind = KIND_LIGHT;
+    kindFromChar(deviceType, kind);
     
     // Get prototype and target list
     switch (deviceType) {
         case 'L': case 'l':
             prototype = SimpleDeviceFactory::createDeviceByInput('L', brandChoice);
-            targetList = &lights;
+            targetList = &registry->getDevices(KIND_LIGHT);
             break;
         case 'C': case 'c':
             prototype = SimpleDeviceFactory::createDeviceByInput('C', brandChoice);
-            targetList = &cameras;
+            targetList = &registry->getDevices(KIND_CAMERA);
             break;
         case 'T': case 't':
             prototype = SimpleDeviceFactory::createDeviceByInput('T', brandChoice);
-            targetList = &televisions;
+            targetList = &registry->getDevices(KIND_TELEVISION);
             break;
         case 'S': case 's':
             prototype = SimpleDeviceFactory::createDeviceByInput('S', brandChoice);
-            targetList = &soundSystems;
+            targetList = &registry->getDevices(KIND_SOUND_SYSTEM);
             break;
         case 'D': case 'd':
             // Detectors come as pairs
+            registry->reserve(KIND_SMOKE_DETECTOR, count);
+            registry->reserve(KIND_GAS_DETECTOR, count);
             for (int i = 0; i < count; ++i) {
                 addDetectorPair(brandChoice);
             }
@@ -448,51 +586,58 @@ void HomeController::addDevices(char deviceType, int count, int brandChoice) {
     
     // Copy configuration from existing device if available
     Device* configSource = targetList->empty() ? NULL : targetList->back();
-    
-    // Add the first device
     if (configSource) {
         prototype->copyConfigurationFrom(configSource);
     }
-    targetList->push_back(prototype);
-    registerDevice(prototype);
-    
-    // Clone for remaining devices (Prototype pattern)
-    for (int i = 1; i < count; ++i) {
-        Device* clone = prototype->clone();
-        targetList->push_back(clone);
-        registerDevice(clone);
-    }
     
-    // Update light pointers if needed
-    if (deviceType == 'L' || deviceType == 'l') {
-        updateLightPtrs();
-    }
+    // The prototype becomes the first device, the rest are its clones
+    provisionDevices(prototype, kind, count);
     
     std::ostringstream oss;
     oss << "Added " << count << " device(s) of type " << deviceType;
     menu->displaySuccess(oss.str());
 }
 
+int HomeController::provisionDevices(Device* prototype, DeviceKind kind, int count) {
+    if (!prototype || count <= 0) {
+        return 0;
+    }
+    
+    // Size the registry, the type's slab and the light index once up front
+    registry->reserve(kind, count);
+    prototype->reserveClones(count - 1);
+    if (kind == KIND_LIGHT) {
+        lightPtrs.reserve(lightPtrs.size() + count);
+    }
+    
+    registerDevice(prototype, kind);
+    for (int i = 1; i < count; ++i) {
+        registerDevice(prototype->clone(), kind);
+    }
+    
+    return count;
+}
+
 void HomeController::removeDevice(char deviceType, int index) {
-    std::vector<Device*>* targetList = NULL;
-    std::vector<Device*>* pairedList = NULL;  // For detectors
+    const std::vector<Device*>* targetList = NULL;
+    const std::vector<Device*>* pairedList = NULL;  // For detectors
     
     switch (deviceType) {
         case 'L': case 'l':
-            targetList = &lights;
+            targetList = &registry->getDevices(KIND_LIGHT);
             break;
         case 'C': case 'c':
-            targetList = &cameras;
+            targetList = &registry->getDevices(KIND_CAMERA);
             break;
         case 'T': case 't':
-            targetList = &televisions;
+            targetList = &registry->getDevices(KIND_TELEVISION);
             break;
         case 'D': case 'd':
-            targetList = &smokeDetectors;
-            pairedList = &gasDetectors;
+            targetList = &registry->getDevices(KIND_SMOKE_DETECTOR);
+            pairedList = &registry->getDevices(KIND_GAS_DETECTOR);
             break;
         case 'S': case 's':
-            targetList = &soundSystems;
+            targetList = &registry->getDevices(KIND_SOUND_SYSTEM);
             break;
         default:
             return;
@@ -503,107 +648,84 @@ void HomeController::removeDevice(char deviceType, int index) {
         return;
     }
     
+    // Look the pair up before removing anything - removal reorders the views
     Device* device = (*targetList)[index - 1];
+    Device* paired = NULL;
+    if (pairedList && index <= (int)pairedList->size()) {
+        paired = (*pairedList)[index - 1];
+    }
+    
     unregisterDevice(device);
-    targetList->erase(targetList->begin() + (index - 1));
     delete device;
     
     // Remove paired gas detector if removing smoke detector
-    if (pairedList && index <= (int)pairedList->size()) {
-        Device* paired = (*pairedList)[index - 1];
+    if (paired) {
         unregisterDevice(paired);
-        pairedList->erase(pairedList->begin() + (index - 1));
         delete paired;
     }
     
-    // Update light pointers if needed
-    if (deviceType == 'L' || deviceType == 'l') {
-        updateLightPtrs();
-    }
-    
     menu->displaySuccess("Device removed.");
 }
 
 void HomeController::powerOnDevices(char deviceType) {
-    std::vector<Device*>* targetList = NULL;
+    DeviceKind kind;
     
     switch (deviceType) {
-        case 'L': case 'l':
-            targetList = &lights;
-            break;
-        case 'C': case 'c':
-            targetList = &cameras;
-            break;
-        case 'T': case 't':
-            targetList = &televisions;
-            break;
         case 'D': case 'd':
             std::cout << "[INFO] Detectors are always on." << std::endl;
             return;
-        case 'S': case 's':
-            targetList = &soundSystems;
-            break;
         case 'A': case 'a':
             // Power on all
-            for (size_t i = 0; i < allDevices.size(); ++i) {
-                allDevices[i]->powerOn();
+            {
+                OutputBatch batch("[INFO] Power on all devices");
+                stateTable->setPowerAll(true);
             }
             menu->displaySuccess("All devices powered on.");
             return;
         default:
-            menu->displayError("Invalid device type.");
-            return;
+            if (!kindFromChar(deviceType, kind)) {
+                menu->displayError("Invalid device type.");
+                return;
+            }
     }
     
-    for (size_t i = 0; i < targetList->size(); ++i) {
-        (*targetList)[i]->powerOn();
+    // Only devices that were off get their doPowerOn hook
+    {
+        OutputBatch batch("[INFO] Power on");
+        stateTable->setPower(kind, true);
     }
     
     menu->displaySuccess("Devices powered on.");
 }
 
 void HomeController::powerOffDevices(char deviceType) {
-    std::vector<Device*>* targetList = NULL;
+    DeviceKind kind;
     
     switch (deviceType) {
-        case 'L': case 'l':
-            targetList = &lights;
-            break;
-        case 'C': case 'c':
-            targetList = &cameras;
-            break;
-        case 'T': case 't':
-            targetList = &televisions;
-            break;
         case 'D': case 'd':
             std::cout << "[WARNING] Detectors cannot be powered off (critical devices)." << std::endl;
             return;
-        case 'S': case 's':
-            targetList = &soundSystems;
-            break;
         case 'A': case 'a':
             // Power off all (except critical)
-            for (size_t i = 0; i < lights.size(); ++i) {
-                lights[i]->powerOff();
-            }
-            for (size_t i = 0; i < cameras.size(); ++i) {
-                cameras[i]->powerOff();
-            }
-            for (size_t i = 0; i < televisions.size(); ++i) {
-                televisions[i]->powerOff();
-            }
-            for (size_t i = 0; i < soundSystems.size(); ++i) {
-                soundSystems[i]->powerOff();
+            {
+                OutputBatch batch("[INFO] Power off all non-critical devices");
+                stateTable->setPower(KIND_LIGHT, false);
+                stateTable->setPower(KIND_CAMERA, false);
+                stateTable->setPower(KIND_TELEVISION, false);
+                stateTable->setPower(KIND_SOUND_SYSTEM, false);
             }
             menu->displaySuccess("All non-critical devices powered off.");
             return;
         default:
-            menu->displayError("Invalid device type.");
-            return;
+            if (!kindFromChar(deviceType, kind)) {
+                menu->displayError("Invalid device type.");
+                return;
+            }
     }
     
-    for (size_t i = 0; i < targetList->size(); ++i) {
-        (*targetList)[i]->powerOff();
+    {
+        OutputBatch batch("[INFO] Power off");
+        stateTable->setPower(kind, false);
     }
     
     menu->displaySuccess("Devices powered off.");
@@ -622,19 +744,22 @@ void HomeController::displayDeviceList(const std::vector<Device*>& devices, cons
 
 void HomeController::displayAllDevices() const {
     std::cout << "--- CONNECTED DEVICES ---" << std::endl;
+    std::cout << "  Total: " << stateTable->countRegistered()
+              << ", Powered on: " << stateTable->countPowered()
+              << ", Failed: " << stateTable->countFailed() << std::endl;
     std::cout << std::endl;
     
-    displayDeviceList(lights, "Lights");
+    displayDeviceList(registry->getDevices(KIND_LIGHT), "Lights");
     std::cout << std::endl;
-    displayDeviceList(cameras, "Cameras");
+    displayDeviceList(registry->getDevices(KIND_CAMERA), "Cameras");
     std::cout << std::endl;
-    displayDeviceList(televisions, "TVs");
+    displayDeviceList(registry->getDevices(KIND_TELEVISION), "TVs");
     std::cout << std::endl;
-    displayDeviceList(smokeDetectors, "Smoke Detectors");
+    displayDeviceList(registry->getDevices(KIND_SMOKE_DETECTOR), "Smoke Detectors");
     std::cout << std::endl;
-    displayDeviceList(gasDetectors, "Gas Detectors");
+    displayDeviceList(registry->getDevices(KIND_GAS_DETECTOR), "Gas Detectors");
     std::cout << std::endl;
-    displayDeviceList(soundSystems, "Sound Systems");
+    displayDeviceList(registry->getDevices(KIND_SOUND_SYSTEM), "Sound Systems");
 }
 
 void HomeController::addLight(int brandChoice) {
@@ -644,9 +769,7 @@ void HomeController::addLight(int brandChoice) {
     } else {
         light = new IKEATradfriLight();
     }
-    lights.push_back(light);
-    registerDevice(light);
-    updateLightPtrs();
+    registerDevice(light, KIND_LIGHT);
 }
 
 void HomeController::addCamera(int brandChoice) {
@@ -656,8 +779,7 @@ void HomeController::addCamera(int brandChoice) {
     } else {
         camera = new XiaomiCamera();
     }
-    cameras.push_back(camera);
-    registerDevice(camera);
+    registerDevice(camera, KIND_CAMERA);
 }
 
 void HomeController::addTV(int brandChoice) {
@@ -667,8 +789,7 @@ void HomeController::addTV(int brandChoice) {
     } else {
         tv = new LGTV();
     }
-    televisions.push_back(tv);
-    registerDevice(tv);
+    registerDevice(tv, KIND_TELEVISION);
 }
 
 void HomeController::addDetectorPair(int brandChoice) {
@@ -685,10 +806,8 @@ void HomeController::addDetectorPair(int brandChoice) {
         gas = factory.createGasDetector();
     }
     
-    smokeDetectors.push_back(smoke);
-    gasDetectors.push_back(gas);
-    registerDevice(smoke);
-    registerDevice(gas);
+    registerDevice(smoke, KIND_SMOKE_DETECTOR);
+    registerDevice(gas, KIND_GAS_DETECTOR);
 }
 
 void HomeController::addSoundSystem(int brandChoice) {
@@ -698,8 +817,7 @@ void HomeController::addSoundSystem(int brandChoice) {
     } else {
         ss = new BoseSoundSystem();
     }
-    soundSystems.push_back(ss);
-    registerDevice(ss);
+    registerDevice(ss, KIND_SOUND_SYSTEM);
 }
 
 void HomeController::displayStatus() const {
@@ -718,19 +836,45 @@ void HomeController::simulateMotionDetection() {
     std::cout << std::endl;
     std::cout << "=== SIMULATION: Motion Detection ===" << std::endl;
     
+    const std::vector<Device*>& cameras = registry->getDevices(KIND_CAMERA);
     if (!cameras.empty()) {
         Camera* cam = dynamic_cast<Camera*>(cameras[0]);
         if (cam) {
             cam->detectMotion();
-            securitySystem->handleMotionDetection();
+            securitySystem->post(SecurityEvent(SECURITY_MOTION, cam->getName(), cam->getDeviceId()));
         }
     }
 }
 
 void HomeController::simulateDeviceFailure(int deviceIndex) {
+    const std::vector<Device*>& allDevices = registry->getDevices();
     if (deviceIndex >= 0 && deviceIndex < (int)allDevices.size()) {
         std::cout << std::endl;
         std::cout << "=== SIMULATION: Device Failure ===" << std::endl;
         allDevices[deviceIndex]->setOperationMode(false);
     }
 }
+
+const DeviceRegistry& HomeController::getDeviceRegistry() const {
+    return *registry;
+}
+
+DeviceEventBus& HomeController::getEventBus() {
+    return *eventBus;
+}
+
+SensorPipeline& HomeController::getSensorPipeline() {
+    return *sensorPipeline;
+}
+
+LevelHistory& HomeController::getLevelHistory() {
+    return *levelHistory;
+}
+
+Device* HomeController::findDevice(int deviceId) const {
+    return registry->find(deviceId);
+}
+
+Device* HomeController::findDeviceByName(const std::string& name) const {
+    return registry->findByName(name);
+}
@@ -0,0 +1,638 @@
+#include "LevelHistory.h"
+#include "Detector.h"
+#include "SensorPipeline.h"
+#include "BinaryCodec.h"
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const size_t LevelSeries::BLOCK_BYTES;
+const size_t LevelSeries::MAX_BLOCKS;
+const size_t LevelSeries::MAX_SAMPLE_BITS;
+const size_t LevelSeries::SLOTS_1S;
+const size_t LevelSeries::SLOTS_1M;
+const size_t LevelSeries::SLOTS_1H;
+
+const char LevelHistory::MAGIC[8] = { 'M', 'S', 'H', 'L', 'V', 'L', '1', '\n' };
+const char* LevelHistory::DEFAULT_PATH = "msh_levels.bin";
+
+namespace {
+
+const size_t HEADER_SIZE = 8;   // u32 length + u32 CRC
+const size_t MAX_RECORD = 1 << 20;
+
+bool getByte(const char* data, size_t size, size_t& pos, unsigned char& value) {
+    if (pos >= size) {
+        return false;
+    }
+    value = (unsigned char)data[pos++];
+    return true;
+}
+
+// Bit streams are filled LSB first; the block is zeroed when it is started.
+// Writes go through one 8 byte little-endian word (count <= 57), which the
+// compiler turns into a single load and store; blocks have 8 bytes of slack.
+void writeBits(unsigned char* bits, unsigned& pos, unsigned long long value, unsigned count) {
+    unsigned char* at = bits + (pos >> 3);
+    unsigned long long word = 0;
+    for (int i = 0; i < 8; ++i) {
+        word |= (unsigned long long)at[i] << (8 * i);
+    }
+    word |= value << (pos & 7);
+    for (int i = 0; i < 8; ++i) {
+        at[i] = (unsigned char)(word >> (8 * i));
+    }
+    pos += count;
+}
+
+// Bits past the end of the block read as 0 (only a damaged file gets there)
+unsigned long long readBits(const unsigned char* bits, unsigned& pos, unsigned count) {
+    unsigned long long value = 0;
+    unsigned done = 0;
+    while (done < count && (pos >> 3) < LevelSeries::BLOCK_BYTES) {
+        unsigned offset = pos & 7;
+        unsigned take = 8 - offset < count - done ? 8 - offset : count - done;
+        value |= (unsigned long long)((bits[pos >> 3] >> offset) & ((1u << take) - 1)) << done;
+        pos += take;
+        done += take;
+    }
+    return value;
+}
+
+long long signExtend(unsigned long long raw, unsigned width) {
+    if (width >= 64) {
+        return (long long)raw;
+    }
+    unsigned long long sign = 1ULL << (width - 1);
+    return (long long)((raw ^ sign) - sign);
+}
+
+// Delta-of-delta buckets: prefix bits (LSB first) and payload width
+const unsigned DOD_PREFIX[4] = { 0x1, 0x3, 0x7, 0xF };
+const unsigned DOD_PREFIX_BITS[4] = { 2, 3, 4, 4 };
+const unsigned DOD_WIDTH[4] = { 8, 16, 32, 64 };
+
+long long floorStart(long long timestamp, long long period) {
+    long long rest = timestamp % period;
+    return timestamp - (rest < 0 ? rest + period : rest);
+}
+
+}
+
+LevelSeries::LevelSeries(const std::string& seriesName)
+    : name(seriesName), oldest(0), totalCount(0) {
+    for (int r = 0; r < ROLLUP_COUNT; ++r) {
+        heads[r] = 0;
+        used[r] = 0;
+    }
+}
+
+LevelSeries::Block& LevelSeries::newestBlock() {
+    return blocks[oldest == 0 ? blocks.size() - 1 : oldest - 1];
+}
+
+const LevelSeries::Block& LevelSeries::blockAt(size_t age) const {
+    return blocks[(oldest + age) % blocks.size()];
+}
+
+LevelSeries::Block& LevelSeries::startBlock(long long timestamp, int level) {
+    Block* block;
+    if (blocks.size() < MAX_BLOCKS) {
+        blocks.push_back(Block());
+        block = &blocks.back();
+    } else {
+        block = &blocks[oldest];   // Evict the oldest block
+        oldest = oldest + 1 == blocks.size() ? 0 : oldest + 1;
+    }
+    block->firstTime = timestamp;
+    block->lastTime = timestamp;
+    block->lastDelta = 0;
+    block->bitCount = 0;
+    block->count = 1;
+    block->firstLevel = (unsigned char)level;
+    block->lastLevel = (unsigned char)level;
+    std::memset(block->bits, 0, sizeof(block->bits));
+    return *block;
+}
+
+void LevelSeries::append(long long timestamp, int level) {
+    level = level < 0 ? 0 : (level > 100 ? 100 : level);
+    ++totalCount;
+    if (blocks.empty()) {
+        addToRollups(timestamp, level);
+        startBlock(timestamp, level);
+        return;
+    }
+
+    Block& block = newestBlock();
+    if (timestamp < block.lastTime) {
+        timestamp = block.lastTime;
+    }
+    addToRollups(timestamp, level);
+    if (block.bitCount + MAX_SAMPLE_BITS > BLOCK_BYTES * 8) {
+        startBlock(timestamp, level);
+        return;
+    }
+
+    // One code per sample: delta-of-delta bucket, then the level
+    long long delta = timestamp - block.lastTime;
+    long long dod = delta - block.lastDelta;
+    unsigned long long code = 0;
+    unsigned bits = 1;
+    if (dod != 0) {
+        int bucket = 3;
+        if (dod >= -128 && dod <= 127) {
+            bucket = 0;
+        } else if (dod >= -32768 && dod <= 32767) {
+            bucket = 1;
+        } else if (dod >= -2147483647LL - 1 && dod <= 2147483647LL) {
+            bucket = 2;
+        }
+        unsigned long long payload = (unsigned long long)dod;
+        if (bucket == 3) {
+            writeBits(block.bits, block.bitCount, DOD_PREFIX[3] | (payload & 0xFFFFFFFFULL) << 4, 36);
+            payload >>= 32;
+            code = payload;
+            bits = 32;
+        } else {
+            payload &= (1ULL << DOD_WIDTH[bucket]) - 1;
+            code = DOD_PREFIX[bucket] | payload << DOD_PREFIX_BITS[bucket];
+            bits = DOD_PREFIX_BITS[bucket] + DOD_WIDTH[bucket];
+        }
+    }
+    if (level == block.lastLevel) {
+        bits += 1;
+    } else {
+        code |= (1ULL | (unsigned long long)level << 1) << bits;
+        bits += 8;
+    }
+    writeBits(block.bits, block.bitCount, code, bits);
+
+    block.lastTime = timestamp;
+    block.lastDelta = delta;
+    block.lastLevel = (unsigned char)level;
+    ++block.count;
+}
+
+void LevelSeries::addToRing(Bucket* buckets, size_t slots, long long period, size_t& head, size_t& count,
+                            long long timestamp, int level) {
+    Bucket* bucket = &buckets[head];
+    // Usually the newest bucket or the one right after it: no division needed
+    if (count == 0 || timestamp - bucket->start >= period) {
+        long long start = count != 0 && timestamp - bucket->start < 2 * period
+                          ? bucket->start + period : floorStart(timestamp, period);
+        head = count == 0 || head + 1 == slots ? 0 : head + 1;
+        if (count < slots) {
+            ++count;
+        }
+        bucket = &buckets[head];
+        bucket->start = start;
+        bucket->sum = 0;
+        bucket->count = 0;
+        bucket->min = (unsigned char)level;
+        bucket->max = (unsigned char)level;
+    }
+    bucket->sum += (unsigned long long)level;
+    ++bucket->count;
+    bucket->min = level < bucket->min ? (unsigned char)level : bucket->min;
+    bucket->max = level > bucket->max ? (unsigned char)level : bucket->max;
+}
+
+void LevelSeries::addToRollups(long long timestamp, int level) {
+    addToRing(bucketsSecond, SLOTS_1S, 1000000LL, heads[ROLLUP_1S], used[ROLLUP_1S], timestamp, level);
+    addToRing(bucketsMinute, SLOTS_1M, 60LL * 1000000, heads[ROLLUP_1M], used[ROLLUP_1M], timestamp, level);
+    addToRing(bucketsHour, SLOTS_1H, 3600LL * 1000000, heads[ROLLUP_1H], used[ROLLUP_1H], timestamp, level);
+}
+
+LevelSeries::Bucket* LevelSeries::ring(Resolution resolution, size_t& slots) {
+    const LevelSeries* self = this;
+    return const_cast<Bucket*>(self->ring(resolution, slots));
+}
+
+const LevelSeries::Bucket* LevelSeries::ring(Resolution resolution, size_t& slots) const {
+    switch (resolution) {
+        case ROLLUP_1M:
+            slots = SLOTS_1M;
+            return bucketsMinute;
+        case ROLLUP_1H:
+            slots = SLOTS_1H;
+            return bucketsHour;
+        default:
+            slots = SLOTS_1S;
+            return bucketsSecond;
+    }
+}
+
+void LevelSeries::clear() {
+    blocks.clear();
+    oldest = 0;
+    totalCount = 0;
+    for (int r = 0; r < ROLLUP_COUNT; ++r) {
+        heads[r] = 0;
+        used[r] = 0;
+    }
+}
+
+void LevelSeries::decodeBlock(const Block& block, long long from, long long to,
+                              std::vector<LevelSample>& out) const {
+    LevelSample sample;
+    sample.timestamp = block.firstTime;
+    sample.level = block.firstLevel;
+    long long delta = 0;
+    unsigned pos = 0;
+    for (unsigned i = 0; i < block.count; ++i) {
+        if (i > 0) {
+            if (pos >= block.bitCount) {
+                return;
+            }
+            int ones = 0;
+            while (ones < 4 && readBits(block.bits, pos, 1) == 1) {
+                ++ones;
+            }
+            if (ones > 0) {
+                unsigned width = DOD_WIDTH[ones - 1];
+                delta += signExtend(readBits(block.bits, pos, width), width);
+            }
+            sample.timestamp += delta;
+            if (readBits(block.bits, pos, 1) == 1) {
+                sample.level = (int)readBits(block.bits, pos, 7);
+            }
+        }
+        if (sample.timestamp > to) {
+            return;
+        }
+        if (sample.timestamp >= from) {
+            out.push_back(sample);
+        }
+    }
+}
+
+size_t LevelSeries::getSamples(long long from, long long to, std::vector<LevelSample>& out) const {
+    size_t before = out.size();
+    for (size_t age = 0; age < blocks.size(); ++age) {
+        const Block& block = blockAt(age);
+        if (block.lastTime < from) {
+            continue;
+        }
+        if (block.firstTime > to) {
+            break;
+        }
+        decodeBlock(block, from, to, out);
+    }
+    return out.size() - before;
+}
+
+size_t LevelSeries::getRollups(Resolution resolution, long long from, long long to,
+                               std::vector<LevelRollup>& out) const {
+    size_t slots;
+    const Bucket* buckets = ring(resolution, slots);
+    size_t before = out.size();
+    for (size_t age = 0; age < used[resolution]; ++age) {
+        const Bucket& bucket = buckets[(heads[resolution] + slots + 1 - used[resolution] + age) % slots];
+        if (bucket.start < from || bucket.start > to) {
+            continue;
+        }
+        LevelRollup rollup;
+        rollup.start = bucket.start;
+        rollup.min = bucket.min;
+        rollup.max = bucket.max;
+        rollup.avg = (double)bucket.sum / bucket.count;
+        rollup.count = bucket.count;
+        out.push_back(rollup);
+    }
+    return out.size() - before;
+}
+
+bool LevelSeries::summarize(Resolution resolution, long long from, long long to, LevelRollup& out) const {
+    size_t slots;
+    const Bucket* buckets = ring(resolution, slots);
+    unsigned long long sum = 0;
+    out.count = 0;
+    for (size_t age = 0; age < used[resolution]; ++age) {
+        const Bucket& bucket = buckets[(heads[resolution] + slots + 1 - used[resolution] + age) % slots];
+        if (bucket.start < from || bucket.start > to) {
+            continue;
+        }
+        if (out.count == 0) {
+            out.start = bucket.start;
+            out.min = bucket.min;
+            out.max = bucket.max;
+        }
+        out.min = bucket.min < out.min ? bucket.min : out.min;
+        out.max = bucket.max > out.max ? bucket.max : out.max;
+        sum += bucket.sum;
+        out.count += bucket.count;
+    }
+    if (out.count == 0) {
+        return false;
+    }
+    out.avg = (double)sum / out.count;
+    return true;
+}
+
+const std::string& LevelSeries::getName() const {
+    return name;
+}
+
+bool LevelSeries::isEmpty() const {
+    return blocks.empty();
+}
+
+long long LevelSeries::getFirstTime() const {
+    return blocks.empty() ? 0 : blockAt(0).firstTime;
+}
+
+long long LevelSeries::getLastTime() const {
+    return blocks.empty() ? 0 : blockAt(blocks.size() - 1).lastTime;
+}
+
+int LevelSeries::getLastLevel() const {
+    return blocks.empty() ? 0 : blockAt(blocks.size() - 1).lastLevel;
+}
+
+size_t LevelSeries::getSampleCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        count += blocks[i].count;
+    }
+    return count;
+}
+
+unsigned long long LevelSeries::getTotalCount() const {
+    return totalCount;
+}
+
+// First sample (8 byte time + level) plus the packed bits
+size_t LevelSeries::getEncodedBytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        bytes += 9 + (blocks[i].bitCount + 7) / 8;
+    }
+    return bytes;
+}
+
+size_t LevelSeries::getMemoryBytes() const {
+    return sizeof(LevelSeries) + blocks.capacity() * sizeof(Block) + name.capacity();
+}
+
+void LevelSeries::serialize(std::string& out) const {
+    BinaryCodec::putVarint(out, totalCount);
+    BinaryCodec::putVarint(out, blocks.size());
+    for (size_t age = 0; age < blocks.size(); ++age) {
+        const Block& block = blockAt(age);
+        BinaryCodec::putSignedVarint(out, block.firstTime);
+        BinaryCodec::putSignedVarint(out, block.lastTime - block.firstTime);
+        BinaryCodec::putSignedVarint(out, block.lastDelta);
+        BinaryCodec::putVarint(out, block.count);
+        out += (char)block.firstLevel;
+        out += (char)block.lastLevel;
+        BinaryCodec::putVarint(out, block.bitCount);
+        out.append(reinterpret_cast<const char*>(block.bits), (block.bitCount + 7) / 8);
+    }
+    for (int r = 0; r < ROLLUP_COUNT; ++r) {
+        size_t slots;
+        const Bucket* buckets = ring((Resolution)r, slots);
+        BinaryCodec::putVarint(out, used[r]);
+        for (size_t age = 0; age < used[r]; ++age) {
+            const Bucket& bucket = buckets[(heads[r] + slots + 1 - used[r] + age) % slots];
+            BinaryCodec::putSignedVarint(out, bucket.start);
+            BinaryCodec::putVarint(out, bucket.sum);
+            BinaryCodec::putVarint(out, bucket.count);
+            out += (char)bucket.min;
+            out += (char)bucket.max;
+        }
+    }
+}
+
+bool LevelSeries::deserialize(const char* data, size_t size) {
+    LevelSeries loaded(name);
+    size_t pos = 0;
+    unsigned long long blockCount;
+    if (!BinaryCodec::getVarint(data, size, pos, loaded.totalCount) ||
+        !BinaryCodec::getVarint(data, size, pos, blockCount) || blockCount > MAX_BLOCKS) {
+        return false;
+    }
+    loaded.blocks.resize((size_t)blockCount);
+    for (size_t i = 0; i < loaded.blocks.size(); ++i) {
+        Block& block = loaded.blocks[i];
+        long long span;
+        unsigned long long count;
+        unsigned long long bitCount;
+        if (!BinaryCodec::getSignedVarint(data, size, pos, block.firstTime) || !BinaryCodec::getSignedVarint(data, size, pos, span) ||
+            !BinaryCodec::getSignedVarint(data, size, pos, block.lastDelta) || !BinaryCodec::getVarint(data, size, pos, count) ||
+            !getByte(data, size, pos, block.firstLevel) || !getByte(data, size, pos, block.lastLevel) ||
+            !BinaryCodec::getVarint(data, size, pos, bitCount)) {
+            return false;
+        }
+        size_t bytes = (size_t)((bitCount + 7) / 8);
+        if (count == 0 || count > BLOCK_BYTES * 8 || bitCount > BLOCK_BYTES * 8 ||
+            span < 0 || block.firstLevel > 100 || block.lastLevel > 100 || bytes > size - pos) {
+            return false;
+        }
+        block.lastTime = block.firstTime + span;
+        block.count = (unsigned)count;
+        block.bitCount = (unsigned)bitCount;
+        std::memset(block.bits, 0, sizeof(block.bits));
+        std::memcpy(block.bits, data + pos, bytes);
+        pos += bytes;
+    }
+    for (int r = 0; r < ROLLUP_COUNT; ++r) {
+        size_t slots;
+        Bucket* buckets = loaded.ring((Resolution)r, slots);
+        unsigned long long count;
+        if (!BinaryCodec::getVarint(data, size, pos, count) || count > slots) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Bucket& bucket = buckets[i];
+            unsigned long long sum;
+            unsigned long long samples;
+            if (!BinaryCodec::getSignedVarint(data, size, pos, bucket.start) || !BinaryCodec::getVarint(data, size, pos, sum) ||
+                !BinaryCodec::getVarint(data, size, pos, samples) || !getByte(data, size, pos, bucket.min) ||
+                !getByte(data, size, pos, bucket.max) || samples == 0) {
+                return false;
+            }
+            bucket.sum = sum;
+            bucket.count = (unsigned)samples;
+        }
+        loaded.used[r] = (size_t)count;
+        loaded.heads[r] = count > 0 ? (size_t)count - 1 : 0;
+    }
+    if (pos != size) {
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
+
+long long LevelSeries::periodOf(Resolution resolution) {
+    switch (resolution) {
+        case ROLLUP_1M: return 60LL * 1000000;
+        case ROLLUP_1H: return 3600LL * 1000000;
+        default:        return 1000000;
+    }
+}
+
+const char* LevelSeries::resolutionName(Resolution resolution) {
+    switch (resolution) {
+        case ROLLUP_1S: return "1s";
+        case ROLLUP_1M: return "1m";
+        case ROLLUP_1H: return "1h";
+        default:        return "unknown";
+    }
+}
+
+LevelHistory::LevelHistory() : seriesCount(0) {
+}
+
+LevelHistory::~LevelHistory() {
+    for (size_t i = 0; i < byId.size(); ++i) {
+        delete byId[i];
+    }
+}
+
+void LevelHistory::attach(Detector* detector) {
+    if (!detector || detector->history || detector->getDeviceId() < 0) {
+        return;
+    }
+    size_t id = (size_t)detector->getDeviceId();
+    if (id >= byId.size()) {
+        byId.resize(id + 1, NULL);
+    }
+    if (!byId[id]) {
+        ++seriesCount;
+    }
+    delete byId[id];
+    byId[id] = new LevelSeries(detector->getName());
+    detector->history = byId[id];
+    if (detector->pipeline) {
+        detector->pipeline->refresh(detector->pipelineSlot);
+    }
+}
+
+void LevelHistory::detach(Detector* detector) {
+    if (!detector || !detector->history) {
+        return;
+    }
+    size_t id = (size_t)detector->getDeviceId();
+    if (id < byId.size() && byId[id] == detector->history) {
+        delete byId[id];
+        byId[id] = NULL;
+        --seriesCount;
+    }
+    detector->history = NULL;
+    if (detector->pipeline) {
+        detector->pipeline->refresh(detector->pipelineSlot);
+    }
+}
+
+LevelSeries* LevelHistory::find(int deviceId) const {
+    if (deviceId < 0 || (size_t)deviceId >= byId.size()) {
+        return NULL;
+    }
+    return byId[deviceId];
+}
+
+bool LevelHistory::save(const std::string& fname) const {
+    std::string tmpName = fname + ".tmp";
+    FILE* out = std::fopen(tmpName.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    bool ok = std::fwrite(MAGIC, 1, sizeof(MAGIC), out) == sizeof(MAGIC);
+    std::string record;
+    for (size_t id = 0; ok && id < byId.size(); ++id) {
+        const LevelSeries* series = byId[id];
+        if (!series || series->isEmpty()) {
+            continue;
+        }
+        record.assign(HEADER_SIZE, '\0');
+        BinaryCodec::putVarint(record, id);
+        BinaryCodec::putVarint(record, series->getName().size());
+        record += series->getName();
+        series->serialize(record);
+        size_t payload = record.size() - HEADER_SIZE;
+        BinaryCodec::putU32(&record[0], (unsigned)payload);
+        BinaryCodec::putU32(&record[4], BinaryCodec::crc32(record.data() + HEADER_SIZE, payload));
+        ok = std::fwrite(record.data(), 1, record.size(), out) == record.size();
+    }
+    ok = std::fflush(out) == 0 && ok;
+#ifdef _WIN32
+    ok = _commit(_fileno(out)) == 0 && ok;
+#else
+    ok = fsync(fileno(out)) == 0 && ok;
+#endif
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    std::remove(fname.c_str());
+#endif
+    return std::rename(tmpName.c_str(), fname.c_str()) == 0;
+}
+
+bool LevelHistory::load(const std::string& fname, size_t& restored) {
+    restored = 0;
+    FILE* in = std::fopen(fname.c_str(), "rb");
+    if (!in) {
+        return false;
+    }
+    char magic[sizeof(MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        std::fclose(in);
+        return false;
+    }
+
+    char header[HEADER_SIZE];
+    std::vector<char> payload;
+    while (std::fread(header, 1, HEADER_SIZE, in) == HEADER_SIZE) {
+        size_t length = BinaryCodec::getU32(header);
+        if (length == 0 || length > MAX_RECORD) {
+            break;   // Damaged length: nothing after it can be trusted
+        }
+        payload.resize(length);
+        if (std::fread(&payload[0], 1, length, in) != length) {
+            break;
+        }
+        if (BinaryCodec::crc32(&payload[0], length) != BinaryCodec::getU32(header + 4)) {
+            continue;
+        }
+        const char* data = &payload[0];
+        size_t pos = 0;
+        unsigned long long id;
+        unsigned long long nameLength;
+        if (!BinaryCodec::getVarint(data, length, pos, id) || !BinaryCodec::getVarint(data, length, pos, nameLength) ||
+            nameLength > length - pos) {
+            continue;
+        }
+        std::string name(data + pos, (size_t)nameLength);
+        pos += (size_t)nameLength;
+        LevelSeries* series = find(id < byId.size() ? (int)id : -1);
+        if (series && series->getName() == name && series->deserialize(data + pos, length - pos)) {
+            ++restored;
+        }
+    }
+    std::fclose(in);
+    return true;
+}
+
+size_t LevelHistory::size() const {
+    return seriesCount;
+}
+
+size_t LevelHistory::getMemoryBytes() const {
+    size_t bytes = sizeof(LevelHistory) + byId.capacity() * sizeof(LevelSeries*);
+    for (size_t i = 0; i < byId.size(); ++i) {
+        if (byId[i]) {
+            bytes += byId[i]->getMemoryBytes();
+        }
+    }
+    return bytes;
+}
@@ -1,20 +1,24 @@
 #include "Light.h"
+#include "DeviceStateTable.h"
+#include "OutputSink.h"
 #include <sstream>
 
 // Base Light implementation
 Light::Light(const std::string& brand, const std::string& model)
-    : Device(brand, model), color("white"), brightness(100) {
+    : Device(brand, model) {
+    DeviceStateTable::getInstance()->setColor(stateSlot, "white");
+    setLevel(100);  // Full brightness
 }
 
 Light::~Light() {}
 
 void Light::doPowerOn() {
-    std::cout << "  -> Light " << name << " illuminating with color: " << color 
-              << ", brightness: " << brightness << "%" << std::endl;
+    OutputSink::out() << "  -> Light " << name << " illuminating with color: " << getColor()
+              << ", brightness: " << getLevel() << "%" << std::endl;
 }
 
 void Light::doPowerOff() {
-    std::cout << "  -> Light " << name << " turning off illumination." << std::endl;
+    OutputSink::out() << "  -> Light " << name << " turning off illumination." << std::endl;
 }
 
 std::string Light::getDeviceType() const {
@@ -23,7 +27,7 @@ std::string Light::getDeviceType() const {
 
 std::string Light::getStatus() const {
     std::ostringstream oss;
-    oss << Device::getStatus() << " | Color: " << color << ", Brightness: " << brightness << "%";
+    oss << Device::getStatus() << " | Color: " << getColor() << ", Brightness: " << getLevel() << "%";
     return oss.str();
 }
 
@@ -31,33 +35,31 @@ void Light::copyConfigurationFrom(const Device* other) {
     Device::copyConfigurationFrom(other);
     const Light* otherLight = dynamic_cast<const Light*>(other);
     if (otherLight) {
-        this->color = otherLight->color;
-        this->brightness = otherLight->brightness;
+        DeviceStateTable::getInstance()->setColor(stateSlot, otherLight->getColor());
+        setLevel(otherLight->getLevel());
     }
 }
 
 void Light::setColor(const std::string& c) {
-    color = c;
-    std::cout << "[INFO] " << name << " color set to: " << color << std::endl;
+    DeviceStateTable::getInstance()->setColor(stateSlot, c);
+    OutputSink::out() << "[INFO] " << name << " color set to: " << c << std::endl;
 }
 
 void Light::setBrightness(int level) {
-    if (level < 0) level = 0;
-    if (level > 100) level = 100;
-    brightness = level;
-    std::cout << "[INFO] " << name << " brightness set to: " << brightness << "%" << std::endl;
+    setLevel(level);  // Clamped to 0-100
+    OutputSink::out() << "[INFO] " << name << " brightness set to: " << getLevel() << "%" << std::endl;
 }
 
 std::string Light::getColor() const {
-    return color;
+    return DeviceStateTable::getInstance()->getColor(stateSlot);
 }
 
 int Light::getBrightness() const {
-    return brightness;
+    return getLevel();
 }
 
 void Light::blinkLight() {
-    std::cout << "[ALERT] " << name << " BLINKING ON/OFF!" << std::endl;
+    OutputSink::out() << "[ALERT] " << name << " BLINKING ON/OFF!" << std::endl;
 }
 
 // Philips Hue Light
@@ -73,6 +75,8 @@ Device* PhilipsHueLight::clone() const {
     return newLight;
 }
 
+MSH_DEFINE_POOLED_DEVICE(PhilipsHueLight)
+
 // IKEA Tradfri Light
 IKEATradfriLight::IKEATradfriLight()
     : Light("IKEA", "Tradfri E27") {
@@ -85,3 +89,5 @@ Device* IKEATradfriLight::clone() const {
     newLight->copyConfigurationFrom(this);
     return newLight;
 }
+
+MSH_DEFINE_POOLED_DEVICE(IKEATradfriLight)
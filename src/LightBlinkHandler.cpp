@@ -0,0 +1,22 @@
+/**
+ * @file LightBlinkHandler.cpp
+ * @brief Implementation of Light Blink Handler
+ *
+ * @patterns Chain of Responsibility
+ */
+
+#include "LightBlinkHandler.h"
+#include "OutputSink.h"
+
+LightBlinkHandler::LightBlinkHandler(const std::vector<Light*>* lights)
+    : SecurityHandler("Light blink"), lights(lights) {}
+
+void LightBlinkHandler::handle(const SecurityEvent&) {
+    if (!lights || lights->empty()) {
+        return;
+    }
+    OutputSink::out() << "[SECURITY] Blinking " << lights->size() << " light(s)..." << std::endl;
+    for (size_t i = 0; i < lights->size(); ++i) {
+        (*lights)[i]->blinkLight();
+    }
+}
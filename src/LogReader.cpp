@@ -0,0 +1,386 @@
+#include "LogReader.h"
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MSH_HAVE_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef MSH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+static inline int lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// MappedFile Implementation
+MappedFile::MappedFile()
+    : data(NULL), size(0), mapped(false)
+#ifndef _WIN32
+    , fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef MSH_HAVE_ZLIB
+    // Rotated segments are gzip-compressed - inflate them into memory
+    if (path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0) {
+        gzFile in = gzopen(path.c_str(), "rb");
+        if (!in) {
+            return false;
+        }
+        std::vector<char> inflated;
+        char chunk[64 * 1024];
+        int got;
+        while ((got = gzread(in, chunk, sizeof(chunk))) > 0) {
+            inflated.insert(inflated.end(), chunk, chunk + got);
+        }
+        gzclose(in);
+        if (got < 0) {
+            return false;
+        }
+        char* buffer = new char[inflated.empty() ? 1 : inflated.size()];
+        if (!inflated.empty()) {
+            memcpy(buffer, &inflated[0], inflated.size());
+        }
+        data = buffer;
+        size = inflated.size();
+        mapped = false;
+        return true;
+    }
+#endif
+#ifndef _WIN32
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    size = (size_t)info.st_size;
+    if (size == 0) {
+        return true;
+    }
+    void* address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data = (const char*)address;
+    mapped = true;
+    return true;
+#else
+    // No mmap - read the whole file instead
+    std::ifstream in(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    size = (size_t)in.tellg();
+    in.seekg(0);
+    char* buffer = new char[size > 0 ? size : 1];
+    in.read(buffer, size);
+    data = buffer;
+    mapped = false;
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped && data) {
+        munmap((void*)data, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    if (!mapped) {
+        delete[] data;
+    }
+    data = NULL;
+    size = 0;
+    mapped = false;
+}
+
+const char* MappedFile::getData() const {
+    return data;
+}
+
+size_t MappedFile::getSize() const {
+    return size;
+}
+
+// LogQuery Implementation
+LogQuery::LogQuery() : fromTime(LogReader::NO_TIME), toTime(LogReader::NO_TIME) {}
+
+// LogReader Implementation
+const long long LogReader::NO_TIME = -1;
+
+bool LogReader::open(const std::string& path) {
+    timeIndex.clear();
+    return file.open(path);
+}
+
+size_t LogReader::getSize() const {
+    return file.getSize();
+}
+
+size_t LogReader::getIndexedLines() const {
+    return timeIndex.size();
+}
+
+size_t LogReader::lineStartAtOrAfter(size_t offset) const {
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    if (offset == 0 || offset >= size) {
+        return offset < size ? offset : size;
+    }
+    if (data[offset - 1] == '\n') {
+        return offset;
+    }
+    const char* newline = (const char*)memchr(data + offset, '\n', size - offset);
+    return newline ? (size_t)(newline - data) + 1 : size;
+}
+
+size_t LogReader::lineEnd(size_t offset) const {
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    const char* newline = (const char*)memchr(data + offset, '\n', size - offset);
+    return newline ? (size_t)(newline - data) : size;
+}
+
+bool LogReader::lineTime(size_t offset, long long& time) {
+    std::map<size_t, long long>::const_iterator cached = timeIndex.find(offset);
+    if (cached != timeIndex.end()) {
+        time = cached->second;
+        return time != NO_TIME;
+    }
+
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    time = NO_TIME;
+    if (offset < size && data[offset] == '[') {
+        size_t limit = size - offset - 1;
+        if (limit > 40) limit = 40;
+        const char* close = (const char*)memchr(data + offset + 1, ']', limit);
+        if (close) {
+            time = parseTime(data + offset + 1, (size_t)(close - data - offset - 1));
+        }
+    }
+    timeIndex[offset] = time;
+    return time != NO_TIME;
+}
+
+size_t LogReader::lowerBound(long long time) {
+    size_t size = file.getSize();
+    size_t lo = 0;
+    size_t hi = size;
+
+    // Bisect on byte offsets, resynchronising to line starts
+    while (hi - lo > 4096) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t line = lineStartAtOrAfter(mid);
+        long long lineT;
+        while (line < hi && !lineTime(line, lineT)) {
+            line = lineEnd(line) + 1;
+        }
+        if (line >= hi) {
+            break;
+        }
+        if (lineT < time) {
+            lo = line;
+        } else {
+            hi = line;
+        }
+    }
+
+    // Finish with a short linear scan
+    for (size_t line = lo; line < size; line = lineEnd(line) + 1) {
+        long long lineT;
+        if (lineTime(line, lineT) && lineT >= time) {
+            return line;
+        }
+    }
+    return size;
+}
+
+size_t LogReader::query(const LogQuery& q, LogLineSink* sink) {
+    const char* data = file.getData();
+    size_t start = q.fromTime == NO_TIME ? 0 : lowerBound(q.fromTime);
+    size_t end = q.toTime == NO_TIME ? file.getSize() : lowerBound(q.toTime + 1);
+
+    std::vector<std::string> needles;
+    if (!q.device.empty()) needles.push_back("Device '" + q.device + "'");
+    if (!q.text.empty()) needles.push_back(q.text);
+    if (!q.level.empty()) needles.push_back("] [" + q.level + "] ");
+
+    size_t matches = 0;
+    size_t pos = start;
+    while (pos < end) {
+        size_t lineBegin;
+        size_t lineFinish;
+
+        if (needles.empty()) {
+            lineBegin = pos;
+            lineFinish = lineEnd(pos);
+        } else {
+            // Scan the whole range for the most selective pattern, then check the line
+            const char* hit = findSubstring(data + pos, end - pos, needles[0].data(), needles[0].size());
+            if (!hit) {
+                break;
+            }
+            lineBegin = (size_t)(hit - data);
+            while (lineBegin > pos && data[lineBegin - 1] != '\n') {
+                --lineBegin;
+            }
+            lineFinish = lineEnd((size_t)(hit - data));
+        }
+
+        bool match = true;
+        for (size_t i = 1; i < needles.size() && match; ++i) {
+            match = findSubstring(data + lineBegin, lineFinish - lineBegin,
+                                  needles[i].data(), needles[i].size()) != NULL;
+        }
+        if (match && lineFinish > lineBegin) {
+            ++matches;
+            if (sink) {
+                sink->onLine(data + lineBegin, lineFinish - lineBegin);
+            }
+        }
+        pos = lineFinish + 1;
+    }
+    return matches;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static long long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    long long yearOfEra = year - era * 400;
+    long long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+static bool parseDigits(const char* text, int count, int& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (text[i] == ' ' && value == 0) continue;  // ctime pads the day with a space
+        if (text[i] < '0' || text[i] > '9') return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+long long LogReader::parseTime(const char* text, size_t length) {
+    int year, month, day, hour, minute, second, micros = 0;
+
+    if (length >= 19 && text[4] == '-' && text[7] == '-') {
+        // 2025-11-25T21:33:31[.123456] or 2025-11-25 21:33:31
+        if (!parseDigits(text, 4, year) || !parseDigits(text + 5, 2, month) ||
+            !parseDigits(text + 8, 2, day) || !parseDigits(text + 11, 2, hour) ||
+            !parseDigits(text + 14, 2, minute) || !parseDigits(text + 17, 2, second)) {
+            return NO_TIME;
+        }
+        if (length >= 26 && text[19] == '.' && !parseDigits(text + 20, 6, micros)) {
+            return NO_TIME;
+        }
+    } else if (length >= 24 && text[3] == ' ' && text[7] == ' ') {
+        // Tue Nov 25 21:33:31 2025
+        static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        month = 0;
+        for (int i = 0; i < 12; ++i) {
+            if (memcmp(text + 4, months + i * 3, 3) == 0) {
+                month = i + 1;
+                break;
+            }
+        }
+        if (month == 0 || !parseDigits(text + 8, 2, day) || !parseDigits(text + 11, 2, hour) ||
+            !parseDigits(text + 14, 2, minute) || !parseDigits(text + 17, 2, second) ||
+            !parseDigits(text + 20, 4, year)) {
+            return NO_TIME;
+        }
+    } else {
+        return NO_TIME;
+    }
+
+    long long seconds = daysFromCivil(year, month, day) * 86400LL + hour * 3600 + minute * 60 + second;
+    return seconds * 1000000LL + micros;
+}
+
+const char* LogReader::findSubstring(const char* haystack, size_t haystackLength,
+                                     const char* needle, size_t needleLength) {
+    if (needleLength == 0) {
+        return haystack;
+    }
+    if (haystackLength < needleLength) {
+        return NULL;
+    }
+    if (needleLength == 1) {
+        return (const char*)memchr(haystack, needle[0], haystackLength);
+    }
+
+    size_t i = 0;
+#ifdef MSH_HAVE_SSE2
+    // Compare the first and last needle byte against 16 positions at once and
+    // only run memcmp where both match
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+    for (; i + needleLength - 1 + 16 <= haystackLength; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128((const __m128i*)(haystack + i));
+        __m128i blockLast = _mm_loadu_si128((const __m128i*)(haystack + i + needleLength - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+        while (mask != 0) {
+            int bit = lowestBit(mask);
+            if (memcmp(haystack + i + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return haystack + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Scalar path (and SSE2 tail)
+    while (i + needleLength <= haystackLength) {
+        const char* candidate = (const char*)memchr(haystack + i, needle[0], haystackLength - needleLength + 1 - i);
+        if (!candidate) {
+            return NULL;
+        }
+        if (memcmp(candidate + 1, needle + 1, needleLength - 1) == 0) {
+            return candidate;
+        }
+        i = (size_t)(candidate - haystack) + 1;
+    }
+    return NULL;
+}
@@ -0,0 +1,77 @@
+#include "LogRingBuffer.h"
+
+LogRingBuffer::LogRingBuffer(size_t requestedCapacity)
+    : slots(NULL), capacity(2), mask(1), enqueuePos(0), dequeuePos(0) {
+    // Round up to a power of two so positions can be masked instead of divided
+    while (capacity < requestedCapacity) {
+        capacity <<= 1;
+    }
+    mask = capacity - 1;
+
+    slots = new Slot[capacity];
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+LogRingBuffer::~LogRingBuffer() {
+    delete[] slots;
+}
+
+bool LogRingBuffer::tryPush(long long timestamp, const std::string& message) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &slots[pos & mask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        long diff = (long)seq - (long)pos;
+
+        if (diff == 0) {
+            // Slot is free for this position - try to claim it
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // Full
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record.timestamp = timestamp;
+    slot->record.message.assign(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRingBuffer::tryPop(LogRecord& out) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &slots[pos & mask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        long diff = (long)seq - (long)(pos + 1);
+
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // Empty
+        } else {
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    out.timestamp = slot->record.timestamp;
+    // Swap instead of copy so both strings keep their capacity
+    out.message.swap(slot->record.message);
+    slot->sequence.store(pos + capacity, std::memory_order_release);
+    return true;
+}
+
+size_t LogRingBuffer::getCapacity() const {
+    return capacity;
+}
@@ -0,0 +1,235 @@
+#include "LogRotator.h"
+#include "LogReader.h"
+#include "TimestampFormatter.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef MSH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// LogManifest Implementation
+std::string LogManifest::manifestPath(const std::string& logFilename) {
+    // "msh_log.txt" -> "msh_log.manifest"
+    std::string::size_type dot = logFilename.find_last_of('.');
+    std::string::size_type slash = logFilename.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        return logFilename.substr(0, dot) + ".manifest";
+    }
+    return logFilename + ".manifest";
+}
+
+bool LogManifest::load(const std::string& path, std::vector<LogSegment>& segments) {
+    segments.clear();
+    std::ifstream in(path.c_str());
+    if (!in.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        LogSegment segment;
+        std::string sequence;
+        if (std::getline(fields, sequence, '\t') && std::getline(fields, segment.firstTime, '\t') &&
+            std::getline(fields, segment.lastTime, '\t') && std::getline(fields, segment.path)) {
+            segment.sequence = (unsigned)std::strtoul(sequence.c_str(), NULL, 10);
+            segments.push_back(segment);
+        }
+    }
+    return true;
+}
+
+bool LogManifest::save(const std::string& path, const std::vector<LogSegment>& segments) {
+    // Write a temporary file and rename it so readers never see a partial manifest
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp.c_str(), std::ios::out | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        for (size_t i = 0; i < segments.size(); ++i) {
+            out << segments[i].sequence << '\t' << segments[i].firstTime << '\t'
+                << segments[i].lastTime << '\t' << segments[i].path << '\n';
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+std::vector<LogSegment> LogManifest::findSegments(const std::vector<LogSegment>& segments,
+                                                  long long fromTime, long long toTime) {
+    std::vector<LogSegment> result;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        long long first = LogReader::parseTime(segments[i].firstTime.c_str(), segments[i].firstTime.size());
+        long long last = LogReader::parseTime(segments[i].lastTime.c_str(), segments[i].lastTime.size());
+        if (toTime != LogReader::NO_TIME && first != LogReader::NO_TIME && first > toTime) continue;
+        if (fromTime != LogReader::NO_TIME && last != LogReader::NO_TIME && last < fromTime) continue;
+        result.push_back(segments[i]);
+    }
+    return result;
+}
+
+// LogRotator Implementation
+LogRotator::LogRotator()
+    : maxBytes(0), maxAgeSeconds(0), maxSegments(10), compress(true),
+      nextSequence(1), running(false), stopRequested(false) {
+}
+
+LogRotator::~LogRotator() {
+    stop();
+}
+
+void LogRotator::setPolicy(size_t bytes, int ageSeconds, int segmentsKept, bool compressSegments) {
+    maxBytes = bytes;
+    maxAgeSeconds = ageSeconds > 0 ? ageSeconds : 0;
+    maxSegments = segmentsKept > 0 ? segmentsKept : 1;
+    compress = compressSegments;
+}
+
+bool LogRotator::isEnabled() const {
+    return maxBytes > 0 || maxAgeSeconds > 0;
+}
+
+bool LogRotator::isCompressionAvailable() {
+#ifdef MSH_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LogRotator::start(const std::string& filename) {
+    stop();
+    logFilename = filename;
+    manifestFile = LogManifest::manifestPath(filename);
+
+    // Continue numbering after the newest segment from a previous run
+    LogManifest::load(manifestFile, segments);
+    nextSequence = 1;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (segments[i].sequence >= nextSequence) {
+            nextSequence = segments[i].sequence + 1;
+        }
+    }
+
+    stopRequested = false;
+    running = true;
+    worker = std::thread(&LogRotator::workerLoop, this);
+}
+
+void LogRotator::stop() {
+    if (!running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopRequested = true;
+    }
+    jobReady.notify_one();
+    worker.join();
+    running = false;
+}
+
+bool LogRotator::shouldRotate(size_t segmentBytes, long long segmentOpenedAt, long long now) const {
+    if (maxBytes > 0 && segmentBytes >= maxBytes) {
+        return true;
+    }
+    return maxAgeSeconds > 0 && segmentBytes > 0 &&
+           now - segmentOpenedAt >= (long long)maxAgeSeconds * 1000000LL;
+}
+
+std::string LogRotator::nextSegmentPath() {
+    char sequence[16];
+    snprintf(sequence, sizeof(sequence), ".%06u", nextSequence++);
+
+    // "msh_log.txt" -> "msh_log.000001.txt"
+    std::string::size_type dot = logFilename.find_last_of('.');
+    std::string::size_type slash = logFilename.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        return logFilename.substr(0, dot) + sequence + logFilename.substr(dot);
+    }
+    return logFilename + sequence;
+}
+
+void LogRotator::segmentClosed(const std::string& path, long long firstTime, long long lastTime) {
+    TimestampFormatter formatter(TimestampFormatter::FORMAT_ISO8601_MICROS);
+    char stamp[TimestampFormatter::BUFFER_SIZE];
+
+    LogSegment segment;
+    segment.sequence = nextSequence - 1;
+    formatter.format(firstTime, stamp);
+    segment.firstTime = stamp;
+    formatter.format(lastTime, stamp);
+    segment.lastTime = stamp;
+    segment.path = path;
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(segment);
+    }
+    jobReady.notify_one();
+}
+
+void LogRotator::workerLoop() {
+    for (;;) {
+        LogSegment segment;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            while (jobs.empty() && !stopRequested) {
+                jobReady.wait(lock);
+            }
+            if (jobs.empty()) {
+                return;   // Stop requested and nothing left to do
+            }
+            segment = jobs.front();
+            jobs.pop_front();
+        }
+        processSegment(segment);
+    }
+}
+
+void LogRotator::processSegment(LogSegment segment) {
+#ifdef MSH_HAVE_ZLIB
+    if (compress) {
+        std::string gzPath = segment.path + ".gz";
+        std::ifstream in(segment.path.c_str(), std::ios::in | std::ios::binary);
+        gzFile out = gzopen(gzPath.c_str(), "wb6");
+        if (in.is_open() && out) {
+            char chunk[64 * 1024];
+            bool ok = true;
+            while (ok && in) {
+                in.read(chunk, sizeof(chunk));
+                std::streamsize got = in.gcount();
+                if (got > 0 && gzwrite(out, chunk, (unsigned)got) != (int)got) {
+                    ok = false;
+                }
+            }
+            ok = (gzclose(out) == Z_OK) && ok;
+            out = NULL;
+            in.close();
+            if (ok) {
+                std::remove(segment.path.c_str());
+                segment.path = gzPath;
+            } else {
+                std::remove(gzPath.c_str());
+            }
+        }
+        if (out) {
+            gzclose(out);
+        }
+    }
+#endif
+
+    segments.push_back(segment);
+
+    // Drop the oldest segments beyond the retention limit
+    while ((int)segments.size() > maxSegments) {
+        std::remove(segments.front().path.c_str());
+        segments.erase(segments.begin());
+    }
+
+    LogManifest::save(manifestFile, segments);
+}
@@ -11,6 +11,7 @@
  */
 
 #include "Menu.h"
+#include "ModeManager.h"
 #include <iostream>
 #include <iomanip>
 #include <cstdio>
@@ -250,16 +251,16 @@ void Menu::displayPowerOffSubmenu() const {
     std::cout << "  Enter choice: ";
 }
 
-void Menu::displayModeSubmenu() const {
+void Menu::displayModeSubmenu(const std::vector<ModeState*>& modes) const {
     std::cout << std::endl;
     printLine('-');
     std::cout << "  CHANGE MODE SUBMENU" << std::endl;
     printLine('-');
     std::cout << "  Select mode:" << std::endl;
-    std::cout << "  (N) Normal Mode - Light ON, TV OFF, Music OFF" << std::endl;
-    std::cout << "  (E) Evening Mode - Light OFF, TV OFF, Music OFF" << std::endl;
-    std::cout << "  (P) Party Mode - Light ON, TV OFF, Music ON" << std::endl;
-    std::cout << "  (C) Cinema Mode - Light OFF, TV ON, Music OFF" << std::endl;
+    for (size_t i = 0; i < modes.size(); ++i) {
+        std::cout << "  (" << modes[i]->getKey() << ") " << modes[i]->getName() << " Mode - "
+                  << modes[i]->getDescription() << std::endl;
+    }
     std::cout << "  (Q) Cancel" << std::endl;
     std::cout << std::endl;
     std::cout << "  Enter choice: ";
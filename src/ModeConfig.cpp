@@ -0,0 +1,195 @@
+#include "ModeConfig.h"
+#include "ModeManager.h"
+#include <nlohmann/json.hpp>
+#include <sys/stat.h>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+
+using nlohmann::json;
+
+const char* ModeConfig::DEFAULT_PATH = "msh_modes.json";
+
+namespace {
+
+bool readLevel(const json& object, const char* field, int& level, std::string& error) {
+    if (!object.contains(field)) {
+        return true;
+    }
+    // Range-checked at full width; get<int>() would wrap 4294967346 to 50
+    const json& value = object[field];
+    bool valid = false;
+    if (value.is_number_unsigned()) {
+        valid = value.get<unsigned long long>() <= 100;
+    } else if (value.is_number_integer()) {
+        long long number = value.get<long long>();
+        valid = number >= 0 && number <= 100;
+    }
+    if (!valid) {
+        error = std::string("'") + field + "' must be a whole number from 0 to 100";
+        return false;
+    }
+    level = (int)value.get<long long>();
+    return true;
+}
+
+// Fills target from a group or device object; levelField is "brightness" or
+// "volume", NULL when either is accepted (device overrides)
+bool readTarget(const json& object, const char* levelField, bool allowColor, bool allowMusic,
+                ModeTarget& target, std::string& error) {
+    if (!object.is_object()) {
+        error = "expected an object";
+        return false;
+    }
+    if (object.contains("power")) {
+        if (!object["power"].is_boolean()) {
+            error = "'power' must be true or false";
+            return false;
+        }
+        target.managed = true;
+        target.power = object["power"].get<bool>();
+    }
+    if (levelField) {
+        if (!readLevel(object, levelField, target.level, error)) {
+            return false;
+        }
+    } else if (!readLevel(object, "brightness", target.level, error) ||
+               !readLevel(object, "volume", target.level, error)) {
+        return false;
+    }
+    if (allowColor && object.contains("color")) {
+        if (!object["color"].is_string() || object["color"].get<std::string>().empty()) {
+            error = "'color' must be a non-empty string";
+            return false;
+        }
+        target.color = object["color"].get<std::string>();
+    }
+    if (allowMusic && object.contains("music")) {
+        if (!object["music"].is_boolean()) {
+            error = "'music' must be true or false";
+            return false;
+        }
+        target.playMusic = object["music"].get<bool>();
+    }
+    return true;
+}
+
+bool readMode(const json& entry, std::set<char>& keys, ModeState*& mode, std::string& error) {
+    if (!entry.is_object() || !entry.contains("name") || !entry["name"].is_string() ||
+        entry["name"].get<std::string>().empty()) {
+        error = "every mode needs a non-empty 'name'";
+        return false;
+    }
+    std::string name = entry["name"].get<std::string>();
+
+    if (!entry.contains("key") || !entry["key"].is_string() || entry["key"].get<std::string>().size() != 1) {
+        error = "mode '" + name + "': 'key' must be a single character";
+        return false;
+    }
+    char key = (char)std::toupper((unsigned char)entry["key"].get<std::string>()[0]);
+    if (!std::isalnum((unsigned char)key) || key == 'Q') {
+        error = "mode '" + name + "': key must be a letter or digit other than Q";
+        return false;
+    }
+    if (!keys.insert(key).second) {
+        error = "mode '" + name + "': key '" + std::string(1, key) + "' is used twice";
+        return false;
+    }
+
+    std::string description;
+    if (entry.contains("description")) {
+        if (!entry["description"].is_string()) {
+            error = "mode '" + name + "': 'description' must be a string";
+            return false;
+        }
+        description = entry["description"].get<std::string>();
+    }
+
+    static const char* groupFields[ModePlan::GROUP_COUNT] = { "lights", "tvs", "soundSystems" };
+    static const char* levelFields[ModePlan::GROUP_COUNT] = { "brightness", "volume", "volume" };
+    ModePlan plan;
+    for (int g = 0; g < ModePlan::GROUP_COUNT; ++g) {
+        if (entry.contains(groupFields[g]) &&
+            !readTarget(entry[groupFields[g]], levelFields[g], g == ModePlan::GROUP_LIGHT,
+                        g == ModePlan::GROUP_SOUND, plan.targets[g], error)) {
+            error = "mode '" + name + "', " + groupFields[g] + ": " + error;
+            return false;
+        }
+    }
+
+    if (entry.contains("devices")) {
+        const json& devices = entry["devices"];
+        if (!devices.is_array()) {
+            error = "mode '" + name + "': 'devices' must be an array";
+            return false;
+        }
+        for (size_t i = 0; i < devices.size(); ++i) {
+            ModeOverride item;
+            if (!devices[i].is_object() || !devices[i].contains("name") || !devices[i]["name"].is_string()) {
+                error = "mode '" + name + "': every device override needs a 'name'";
+                return false;
+            }
+            item.deviceName = devices[i]["name"].get<std::string>();
+            if (!readTarget(devices[i], NULL, true, true, item.target, error)) {
+                error = "mode '" + name + "', device '" + item.deviceName + "': " + error;
+                return false;
+            }
+            plan.overrides.push_back(item);
+        }
+    }
+
+    mode = new ConfiguredMode(name, key, description, plan);
+    return true;
+}
+
+}
+
+std::string ModeConfig::configuredPath() {
+    const char* env = std::getenv("MSH_MODES");
+    return (env && *env) ? std::string(env) : std::string(DEFAULT_PATH);
+}
+
+bool ModeConfig::load(const std::string& path, std::vector<ModeState*>& modes, std::string& error) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    json root = json::parse(file, NULL, false);
+    if (root.is_discarded()) {
+        error = path + " is not valid JSON";
+        return false;
+    }
+    if (!root.is_object() || !root.contains("modes") || !root["modes"].is_array() || root["modes"].empty()) {
+        error = path + " has no 'modes' array";
+        return false;
+    }
+
+    std::vector<ModeState*> parsed;
+    std::set<char> keys;
+    const json& entries = root["modes"];
+    for (size_t i = 0; i < entries.size(); ++i) {
+        ModeState* mode = NULL;
+        if (!readMode(entries[i], keys, mode, error)) {
+            for (size_t j = 0; j < parsed.size(); ++j) {
+                delete parsed[j];
+            }
+            return false;
+        }
+        parsed.push_back(mode);
+    }
+
+    modes.swap(parsed);
+    return true;
+}
+
+long long ModeConfig::fileStamp(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return -1;
+    }
+    // Size is mixed in so two saves within the same second are still noticed
+    return (long long)info.st_mtime * 1000003LL + (long long)info.st_size;
+}
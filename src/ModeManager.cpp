@@ -11,11 +11,72 @@
 #include "Light.h"
 #include "Television.h"
 #include "SoundSystem.h"
+#include "DeviceStateTable.h"
+#include "OutputSink.h"
+#include "ModeConfig.h"
 #include <iostream>
+#include <sstream>
+#include <cctype>
+
+ModeTarget::ModeTarget() : managed(false), power(false), level(-1), playMusic(false) {}
+
+DeviceKind ModePlan::kindOf(Group group) {
+    switch (group) {
+        case GROUP_LIGHT: return KIND_LIGHT;
+        case GROUP_TV: return KIND_TELEVISION;
+        case GROUP_SOUND: return KIND_SOUND_SYSTEM;
+        default: return KIND_COUNT;
+    }
+}
+
+namespace {
+
+// "ON", "OFF" or "unchanged", followed by any settings
+std::string describeTarget(const ModeTarget& target, bool details) {
+    std::ostringstream oss;
+    oss << (target.managed ? (target.power ? "ON" : "OFF") : "unchanged");
+    if (details) {
+        if (!target.color.empty()) {
+            oss << ", " << target.color;
+        }
+        if (target.level >= 0) {
+            oss << ", " << target.level << "%";
+        }
+        if (target.playMusic) {
+            oss << ", playing";
+        }
+    }
+    return oss.str();
+}
+
+inline int lowestBit(DeviceStateTable::Word w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    while (!(w & 1)) {
+        w >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+}
 
 // ModeState Implementation
-ModeState::ModeState(const std::string& name, bool light, bool tv, bool music)
-    : modeName(name), lightOn(light), tvOn(tv), musicOn(music) {
+ModeState::ModeState(const std::string& name, char key, bool light, bool tv, bool music)
+    : modeName(name), key(key) {
+    plan.targets[ModePlan::GROUP_LIGHT].power = light;
+    plan.targets[ModePlan::GROUP_TV].power = tv;
+    plan.targets[ModePlan::GROUP_SOUND].power = music;
+    for (int g = 0; g < ModePlan::GROUP_COUNT; ++g) {
+        plan.targets[g].managed = true;
+    }
+}
+
+ModeState::ModeState(const std::string& name, char key, const std::string& description, const ModePlan& plan)
+    : modeName(name), key(key), description(description), plan(plan) {
 }
 
 ModeState::~ModeState() {}
@@ -24,168 +85,323 @@ std::string ModeState::getName() const {
     return modeName;
 }
 
+char ModeState::getKey() const {
+    return key;
+}
+
+std::string ModeState::getDescription() const {
+    if (!description.empty()) {
+        return description;
+    }
+    return "Light " + describeTarget(plan.targets[ModePlan::GROUP_LIGHT], false) +
+           ", TV " + describeTarget(plan.targets[ModePlan::GROUP_TV], false) +
+           ", Music " + describeTarget(plan.targets[ModePlan::GROUP_SOUND], false);
+}
+
+const ModePlan& ModeState::getPlan() const {
+    return plan;
+}
+
 bool ModeState::isLightOn() const {
-    return lightOn;
+    return plan.targets[ModePlan::GROUP_LIGHT].managed && plan.targets[ModePlan::GROUP_LIGHT].power;
 }
 
 bool ModeState::isTVOn() const {
-    return tvOn;
+    return plan.targets[ModePlan::GROUP_TV].managed && plan.targets[ModePlan::GROUP_TV].power;
 }
 
 bool ModeState::isMusicOn() const {
-    return musicOn;
+    return plan.targets[ModePlan::GROUP_SOUND].managed && plan.targets[ModePlan::GROUP_SOUND].power;
 }
 
 void ModeState::display() const {
     std::cout << "=== Mode: " << modeName << " ===" << std::endl;
-    std::cout << "  Light: " << (lightOn ? "ON" : "OFF") << std::endl;
-    std::cout << "  TV: " << (tvOn ? "ON" : "OFF") << std::endl;
-    std::cout << "  Music: " << (musicOn ? "ON" : "OFF") << std::endl;
+    std::cout << "  Light: " << describeTarget(plan.targets[ModePlan::GROUP_LIGHT], true) << std::endl;
+    std::cout << "  TV: " << describeTarget(plan.targets[ModePlan::GROUP_TV], true) << std::endl;
+    std::cout << "  Music: " << describeTarget(plan.targets[ModePlan::GROUP_SOUND], true) << std::endl;
+    if (!plan.overrides.empty()) {
+        std::cout << "  Device overrides: " << plan.overrides.size() << std::endl;
+    }
 }
 
 // Normal Mode: light on, TV off, music off
-NormalMode::NormalMode() : ModeState("Normal", true, false, false) {}
+NormalMode::NormalMode() : ModeState("Normal", 'N', true, false, false) {}
 
-void NormalMode::apply(std::vector<Device*>& lights, 
-                       std::vector<Device*>& tvs,
-                       std::vector<Device*>& soundSystems) {
-    std::cout << "[MODE] Applying Normal Mode..." << std::endl;
-    
-    for (size_t i = 0; i < lights.size(); ++i) {
-        lights[i]->powerOn();
-    }
-    for (size_t i = 0; i < tvs.size(); ++i) {
-        tvs[i]->powerOff();
+// Evening Mode: light off, TV off, music off
+EveningMode::EveningMode() : ModeState("Evening", 'E', false, false, false) {}
+
+// Party Mode: multicolor light on, TV off, music playing
+PartyMode::PartyMode() : ModeState("Party", 'P', true, false, true) {
+    plan.targets[ModePlan::GROUP_LIGHT].color = "multicolor";
+    plan.targets[ModePlan::GROUP_SOUND].playMusic = true;
+}
+
+// Cinema Mode: light off, TV on, music off
+CinemaMode::CinemaMode() : ModeState("Cinema", 'C', false, true, false) {}
+
+ConfiguredMode::ConfiguredMode(const std::string& name, char key, const std::string& description,
+                               const ModePlan& plan)
+    : ModeState(name, key, description, plan) {
+}
+
+// ModeManager Implementation
+ModeManager::ModeManager() : currentMode(NULL), configStamp(-1) {
+    stateTable = DeviceStateTable::getInstance();
+    for (int i = 0; i < KEY_SLOTS; ++i) {
+        modesByKey[i] = NULL;
     }
-    for (size_t i = 0; i < soundSystems.size(); ++i) {
-        soundSystems[i]->powerOff();
+
+    std::vector<ModeState*> builtIn;
+    builtIn.push_back(new NormalMode());
+    builtIn.push_back(new EveningMode());
+    builtIn.push_back(new PartyMode());
+    builtIn.push_back(new CinemaMode());
+    installModes(builtIn);
+
+    // A mode file, if present, replaces the built-in modes
+    configPath = ModeConfig::configuredPath();
+    if (ModeConfig::fileStamp(configPath) >= 0) {
+        loadModes(configPath);
     }
-    
-    display();
 }
 
-// Evening Mode: light off, TV off, music off
-EveningMode::EveningMode() : ModeState("Evening", false, false, false) {}
+ModeManager::~ModeManager() {
+    deleteModes();
+}
+
+void ModeManager::installModes(const std::vector<ModeState*>& newModes) {
+    // Keep the current mode across a reload if it still exists; else use the first one
+    std::string currentName = currentMode ? currentMode->getName() : "";
+    ModeState* newCurrent = newModes.empty() ? NULL : newModes[0];
+    for (size_t i = 0; i < newModes.size(); ++i) {
+        if (newModes[i]->getName() == currentName) {
+            newCurrent = newModes[i];
+        }
+    }
+
+    deleteModes();
+    modes = newModes;
+    for (size_t i = 0; i < modes.size(); ++i) {
+        unsigned char index = (unsigned char)std::toupper((unsigned char)modes[i]->getKey());
+        if (index < KEY_SLOTS) {
+            modesByKey[index] = modes[i];
+        }
+    }
+    currentMode = newCurrent;
+}
 
-void EveningMode::apply(std::vector<Device*>& lights, 
-                        std::vector<Device*>& tvs,
-                        std::vector<Device*>& soundSystems) {
-    std::cout << "[MODE] Applying Evening Mode..." << std::endl;
-    
-    for (size_t i = 0; i < lights.size(); ++i) {
-        lights[i]->powerOff();
+void ModeManager::deleteModes() {
+    for (int i = 0; i < KEY_SLOTS; ++i) {
+        modesByKey[i] = NULL;
     }
-    for (size_t i = 0; i < tvs.size(); ++i) {
-        tvs[i]->powerOff();
+    for (size_t i = 0; i < modes.size(); ++i) {
+        delete modes[i];
     }
-    for (size_t i = 0; i < soundSystems.size(); ++i) {
-        soundSystems[i]->powerOff();
+    modes.clear();
+    currentMode = NULL;
+}
+
+bool ModeManager::loadModes(const std::string& path) {
+    std::vector<ModeState*> loaded;
+    std::string error;
+    configPath = path;
+    // Remembered even on failure, so a broken file is not re-parsed until it changes
+    configStamp = ModeConfig::fileStamp(path);
+
+    if (!ModeConfig::load(path, loaded, error)) {
+        std::cout << "[WARNING] Mode file not loaded, keeping current modes: " << error << std::endl;
+        return false;
     }
-    
-    display();
+    installModes(loaded);
+    OutputSink::out() << "[INFO] Loaded " << modes.size() << " mode(s) from " << path << "." << std::endl;
+    return true;
 }
 
-// Party Mode: light on, TV off, music on
-PartyMode::PartyMode() : ModeState("Party", true, false, true) {}
+bool ModeManager::reloadIfChanged() {
+    long long stamp = ModeConfig::fileStamp(configPath);
+    if (stamp < 0 || stamp == configStamp) {
+        return false;
+    }
+    return loadModes(configPath);
+}
 
-void PartyMode::apply(std::vector<Device*>& lights, 
-                      std::vector<Device*>& tvs,
-                      std::vector<Device*>& soundSystems) {
-    std::cout << "[MODE] Applying Party Mode..." << std::endl;
-    
-    for (size_t i = 0; i < lights.size(); ++i) {
-        lights[i]->powerOn();
-        Light* light = dynamic_cast<Light*>(lights[i]);
-        if (light) {
-            light->setColor("multicolor");
-        }
+void ModeManager::setMode(char modeChar) {
+    unsigned char index = (unsigned char)std::toupper((unsigned char)modeChar);
+    ModeState* mode = index < KEY_SLOTS ? modesByKey[index] : NULL;
+    if (!mode) {
+        std::cout << "[ERROR] Invalid mode selection." << std::endl;
+        return;
     }
-    for (size_t i = 0; i < tvs.size(); ++i) {
-        tvs[i]->powerOff();
+    currentMode = mode;
+    OutputSink::out() << "[INFO] Mode changed to " << mode->getName() << "." << std::endl;
+}
+
+bool ModeManager::setModeByName(const std::string& name) {
+    for (size_t i = 0; i < modes.size(); ++i) {
+        if (modes[i]->getName() == name) {
+            currentMode = modes[i];
+            OutputSink::out() << "[INFO] Mode changed to " << name << "." << std::endl;
+            return true;
+        }
     }
-    for (size_t i = 0; i < soundSystems.size(); ++i) {
-        soundSystems[i]->powerOn();
-        SoundSystem* ss = dynamic_cast<SoundSystem*>(soundSystems[i]);
-        if (ss) {
+    return false;
+}
+
+const std::vector<ModeState*>& ModeManager::getModes() const {
+    return modes;
+}
+
+size_t ModeManager::applySettings(Device* device, DeviceKind kind, const ModeTarget& target) {
+    size_t changed = 0;
+
+    // Callers only pass devices whose kind matches their class
+    if (kind == KIND_LIGHT) {
+        Light* light = static_cast<Light*>(device);
+        if (!target.color.empty() && light->getColor() != target.color) {
+            light->setColor(target.color);
+            ++changed;
+        }
+        if (target.level >= 0 && light->getBrightness() != target.level) {
+            light->setBrightness(target.level);
+            ++changed;
+        }
+    } else if (kind == KIND_TELEVISION) {
+        Television* tv = static_cast<Television*>(device);
+        if (target.level >= 0 && tv->getVolume() != target.level) {
+            tv->setVolume(target.level);
+            ++changed;
+        }
+    } else if (kind == KIND_SOUND_SYSTEM) {
+        SoundSystem* ss = static_cast<SoundSystem*>(device);
+        if (target.level >= 0 && ss->getVolume() != target.level) {
+            ss->setVolume(target.level);
+            ++changed;
+        }
+        if (target.playMusic && ss->isPoweredOn() && !ss->isPlayingMusic()) {
             ss->playMusic();
+            ++changed;
         }
     }
-    
-    display();
+    return changed;
 }
 
-// Cinema Mode: light off, TV on, music off
-CinemaMode::CinemaMode() : ModeState("Cinema", false, true, false) {}
+size_t ModeManager::applyTarget(const ModeTarget& target, DeviceKind kind) {
+    size_t changed = 0;
+    if (target.managed && stateTable->diffPower(kind, target.power, diffMask) > 0) {
+        // Devices with an override are handled one by one afterwards
+        for (size_t w = 0; w < overrideMask.size() && w < diffMask.size(); ++w) {
+            diffMask[w] &= ~overrideMask[w];
+        }
+        changed += stateTable->setPower(diffMask, target.power);
+    }
 
-void CinemaMode::apply(std::vector<Device*>& lights, 
-                       std::vector<Device*>& tvs,
-                       std::vector<Device*>& soundSystems) {
-    std::cout << "[MODE] Applying Cinema Mode..." << std::endl;
-    
-    for (size_t i = 0; i < lights.size(); ++i) {
-        lights[i]->powerOff();
+    // Only the settings applySettings() acts on for this kind
+    bool hasLevel = kind == KIND_LIGHT || kind == KIND_TELEVISION || kind == KIND_SOUND_SYSTEM;
+    int level = hasLevel ? target.level : -1;
+    int color = (kind == KIND_LIGHT && !target.color.empty()) ? stateTable->internColor(target.color) : -1;
+    bool music = kind == KIND_SOUND_SYSTEM && target.playMusic;
+    if (level < 0 && color < 0 && !music) {
+        return changed;
     }
-    for (size_t i = 0; i < tvs.size(); ++i) {
-        tvs[i]->powerOn();
+    if (stateTable->diffSettings(kind, level, color, music, diffMask) == 0) {
+        return changed;
     }
-    for (size_t i = 0; i < soundSystems.size(); ++i) {
-        soundSystems[i]->powerOff();
+    for (size_t w = 0; w < diffMask.size(); ++w) {
+        DeviceStateTable::Word bits = diffMask[w];
+        if (w < overrideMask.size()) {
+            bits &= ~overrideMask[w];
+        }
+        while (bits) {
+            int slot = (int)(w * DeviceStateTable::WORD_BITS) + lowestBit(bits);
+            bits &= bits - 1;
+            changed += applySettings(stateTable->getOwner(slot), kind, target);
+        }
     }
-    
-    display();
+    return changed;
 }
 
-// ModeManager Implementation
-ModeManager::ModeManager() {
-    normalMode = new NormalMode();
-    eveningMode = new EveningMode();
-    partyMode = new PartyMode();
-    cinemaMode = new CinemaMode();
-    
-    // Default mode is Normal
-    currentMode = normalMode;
-}
+size_t ModeManager::applyMode(const DeviceRegistry& registry) {
+    if (!currentMode) {
+        return 0;
+    }
 
-ModeManager::~ModeManager() {
-    delete normalMode;
-    delete eveningMode;
-    delete partyMode;
-    delete cinemaMode;
-}
+    OutputSink* sink = OutputSink::getInstance();
+    std::string name = currentMode->getName();
+    sink->stream() << "[MODE] Applying " << name << " Mode..." << std::endl;
+    sink->beginBatch("[MODE] " + name + " Mode applied");
 
-void ModeManager::setMode(char modeChar) {
-    switch (modeChar) {
-        case 'N':
-        case 'n':
-            currentMode = normalMode;
-            std::cout << "[INFO] Mode changed to Normal." << std::endl;
-            break;
-        case 'E':
-        case 'e':
-            currentMode = eveningMode;
-            std::cout << "[INFO] Mode changed to Evening." << std::endl;
-            break;
-        case 'P':
-        case 'p':
-            currentMode = partyMode;
-            std::cout << "[INFO] Mode changed to Party." << std::endl;
-            break;
-        case 'C':
-        case 'c':
-            currentMode = cinemaMode;
-            std::cout << "[INFO] Mode changed to Cinema." << std::endl;
-            break;
-        default:
-            std::cout << "[ERROR] Invalid mode selection." << std::endl;
-    }
-}
-
-void ModeManager::applyMode(std::vector<Device*>& lights, 
-                            std::vector<Device*>& tvs,
-                            std::vector<Device*>& soundSystems) {
-    if (currentMode) {
-        currentMode->apply(lights, tvs, soundSystems);
+    // Resolve per-device overrides first: each matched device gets its group
+    // target with the override layered on top, and is left out of the group pass
+    const ModePlan& plan = currentMode->getPlan();
+    resolved.clear();
+    overrideMask.clear();
+    if (!plan.overrides.empty()) {
+        overrideMask.assign((stateTable->getSlotCount() + DeviceStateTable::WORD_BITS - 1) /
+                            DeviceStateTable::WORD_BITS, 0);
     }
+    for (size_t i = 0; i < plan.overrides.size(); ++i) {
+        const ModeTarget& extra = plan.overrides[i].target;
+        std::vector<Device*> matches = registry.findAllByName(plan.overrides[i].deviceName);
+        for (size_t j = 0; j < matches.size(); ++j) {
+            DeviceKind kind = KIND_COUNT;
+            registry.getKind(matches[j]->getDeviceId(), kind);
+            ModeTarget merged;
+            for (int g = 0; g < ModePlan::GROUP_COUNT; ++g) {
+                if (ModePlan::kindOf((ModePlan::Group)g) == kind) {
+                    merged = plan.targets[g];
+                }
+            }
+            if (extra.managed) {
+                merged.managed = true;
+                merged.power = extra.power;
+            }
+            if (extra.level >= 0) {
+                merged.level = extra.level;
+            }
+            if (!extra.color.empty()) {
+                merged.color = extra.color;
+            }
+            merged.playMusic = merged.playMusic || extra.playMusic;
+
+            int slot = matches[j]->getStateSlot();
+            overrideMask[slot / DeviceStateTable::WORD_BITS] |=
+                (DeviceStateTable::Word)1 << (slot % DeviceStateTable::WORD_BITS);
+            ResolvedOverride item;
+            item.device = matches[j];
+            item.kind = kind;
+            item.target = merged;
+            resolved.push_back(item);
+        }
+    }
+
+    // Per device type, only the devices that differ from the plan are touched
+    size_t changed = 0;
+    for (int g = 0; g < ModePlan::GROUP_COUNT; ++g) {
+        ModePlan::Group group = (ModePlan::Group)g;
+        changed += applyTarget(plan.targets[group], ModePlan::kindOf(group));
+    }
+
+    for (size_t i = 0; i < resolved.size(); ++i) {
+        Device* device = resolved[i].device;
+        const ModeTarget& target = resolved[i].target;
+        if (target.managed && device->isPoweredOn() != target.power) {
+            if (target.power) {
+                device->powerOn();
+            } else {
+                device->powerOff();
+            }
+            if (device->isPoweredOn() == target.power) {
+                ++changed;
+            }
+        }
+        changed += applySettings(device, resolved[i].kind, target);
+    }
+    sink->endBatch();
+
+    if (sink->isEnabled()) {
+        currentMode->display();
+    }
+    return changed;
 }
 
 ModeState* ModeManager::getCurrentMode() const {
@@ -200,4 +416,4 @@ void ModeManager::displayCurrentMode() const {
     if (currentMode) {
         currentMode->display();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,33 @@
+/**
+ * @file NotificationHandler.cpp
+ * @brief Implementation of Notification Handler
+ *
+ * @patterns Chain of Responsibility
+ */
+
+#include "NotificationHandler.h"
+#include "NotificationSystem.h"
+#include <cstdio>
+
+NotificationHandler::NotificationHandler(NotificationSystem* notifications)
+    : SecurityHandler("Notification"), notifications(notifications) {}
+
+void NotificationHandler::handle(const SecurityEvent& event) {
+    if (!notifications) {
+        return;
+    }
+    label.assign(event.source);
+    if (event.deviceId >= 0) {
+        char id[16];
+        snprintf(id, sizeof(id), " #%d", event.deviceId);
+        label += id;
+    }
+    if (event.type == SECURITY_MOTION) {
+        message.assign("Security: motion detected");
+    } else {
+        char text[48];
+        snprintf(text, sizeof(text), "Security: detection at level %d%%", event.value);
+        message.assign(text);
+    }
+    notifications->onDeviceFailure(label, message);
+}
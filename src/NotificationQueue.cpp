@@ -0,0 +1,178 @@
+#include "NotificationQueue.h"
+#include "NotificationSystem.h"
+#include <sstream>
+
+// TokenBucket Implementation
+TokenBucket::TokenBucket() : rate(0), burst(0), tokens(0), lastRefill(std::chrono::steady_clock::now()) {
+}
+
+void TokenBucket::configure(double ratePerSecond, double burstSize) {
+    rate = ratePerSecond > 0 ? ratePerSecond : 0;
+    burst = burstSize >= 1 ? burstSize : 1;
+    tokens = burst;
+    lastRefill = std::chrono::steady_clock::now();
+}
+
+bool TokenBucket::tryTake(std::chrono::steady_clock::time_point now) {
+    if (rate == 0) {
+        return true;
+    }
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    lastRefill = now;
+    tokens += elapsed * rate;
+    if (tokens > burst) {
+        tokens = burst;
+    }
+    if (tokens < 1) {
+        return false;
+    }
+    tokens -= 1;
+    return true;
+}
+
+bool TokenBucket::isLimited() const {
+    return rate > 0;
+}
+
+double TokenBucket::getRate() const {
+    return rate;
+}
+
+double TokenBucket::getBurst() const {
+    return burst;
+}
+
+// NotificationQueue Implementation
+NotificationQueue::NotificationQueue(NotificationStrategy* strat, size_t cap, OverflowPolicy overflow,
+                                     int timeoutMs)
+    : strategy(strat), capacity(cap > 0 ? cap : 1), policy(overflow), blockTimeoutMs(timeoutMs),
+      delivering(false), stopRequested(false),
+      accepted(0), delivered(0), dropped(0), blocked(0), rateLimited(0) {
+    worker = std::thread(&NotificationQueue::workerLoop, this);
+}
+
+NotificationQueue::~NotificationQueue() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopRequested = true;
+    }
+    itemReady.notify_one();
+    worker.join();
+}
+
+bool NotificationQueue::post(const std::string& deviceName, const std::string& message, bool bypassLimit) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (!bypassLimit && !bucket.tryTake(std::chrono::steady_clock::now())) {
+        ++rateLimited;
+        return false;
+    }
+    if (pending.size() >= capacity) {
+        if (policy == DROP_OLDEST) {
+            pending.pop_front();
+            ++dropped;
+        } else if (policy == BLOCK) {
+            ++blocked;
+            if (!spaceFree.wait_for(lock, std::chrono::milliseconds(blockTimeoutMs), [this]() {
+                    return pending.size() < capacity;
+                })) {
+                ++dropped;
+                return false;
+            }
+        } else {
+            ++dropped;
+            return false;
+        }
+    }
+
+    pending.push_back(PendingNotification());
+    pending.back().deviceName = deviceName;
+    pending.back().message = message;
+    ++accepted;
+    lock.unlock();
+    itemReady.notify_one();
+    return true;
+}
+
+void NotificationQueue::setRateLimit(double ratePerSecond, double burst) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    bucket.configure(ratePerSecond, burst);
+}
+
+void NotificationQueue::flush() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    idle.wait(lock, [this]() {
+        return pending.empty() && !delivering;
+    });
+}
+
+void NotificationQueue::workerLoop() {
+    PendingNotification item;
+    std::unique_lock<std::mutex> lock(queueMutex);
+    for (;;) {
+        itemReady.wait(lock, [this]() {
+            return stopRequested || !pending.empty();
+        });
+        if (pending.empty()) {
+            break;   // Stop requested and nothing left to deliver
+        }
+
+        item.deviceName.swap(pending.front().deviceName);
+        item.message.swap(pending.front().message);
+        pending.pop_front();
+        delivering = true;
+        lock.unlock();
+        spaceFree.notify_one();
+
+        // The slow part runs without the lock so producers are never held up by it
+        strategy->notify(item.deviceName, item.message);
+
+        lock.lock();
+        delivering = false;
+        ++delivered;
+        if (pending.empty()) {
+            idle.notify_all();
+        }
+    }
+    idle.notify_all();
+}
+
+NotificationQueueStats NotificationQueue::getStats() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    NotificationQueueStats stats;
+    stats.capacity = capacity;
+    stats.depth = pending.size();
+    stats.accepted = accepted;
+    stats.delivered = delivered;
+    stats.dropped = dropped;
+    stats.blocked = blocked;
+    stats.rateLimited = rateLimited;
+    return stats;
+}
+
+NotificationQueue::OverflowPolicy NotificationQueue::getPolicy() const {
+    return policy;
+}
+
+std::string NotificationQueue::describeLimit() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (!bucket.isLimited()) {
+        return "no rate limit";
+    }
+    std::ostringstream oss;
+    if (bucket.getRate() >= 1) {
+        oss << bucket.getRate() << "/s";
+    } else {
+        oss << bucket.getRate() * 60 << "/min";
+    }
+    oss << ", burst " << bucket.getBurst();
+    return oss.str();
+}
+
+const char* NotificationQueue::policyName(OverflowPolicy p) {
+    switch (p) {
+        case DROP_NEWEST: return "drop newest";
+        case DROP_OLDEST: return "drop oldest";
+        case BLOCK:       return "block";
+    }
+    return "unknown";
+}
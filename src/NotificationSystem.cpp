@@ -1,5 +1,11 @@
 #include "NotificationSystem.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
 
 // NotificationStrategy Implementation
 NotificationStrategy::NotificationStrategy(const std::string& name)
@@ -13,12 +19,16 @@ std::string NotificationStrategy::getName() const {
 }
 
 // LogNotification Implementation
+// Strategies run on worker threads, so each one writes its lines with a
+// single stream insertion to keep them from interleaving with other output.
 LogNotification::LogNotification()
     : NotificationStrategy("Log Notification") {
 }
 
 void LogNotification::notify(const std::string& deviceName, const std::string& message) {
-    std::cout << "[LOG NOTIFICATION] Device: " << deviceName << " - " << message << std::endl;
+    std::ostringstream line;
+    line << "[LOG NOTIFICATION] Device: " << deviceName << " - " << message << "\n";
+    std::cout << line.str() << std::flush;
 }
 
 // AlarmNotification Implementation
@@ -27,110 +37,315 @@ AlarmNotification::AlarmNotification()
 }
 
 void AlarmNotification::notify(const std::string& deviceName, const std::string& message) {
-    std::cout << "[ALARM NOTIFICATION] !!! ALARM !!! Device: " << deviceName 
-              << " - " << message << std::endl;
+    std::ostringstream line;
+    line << "[ALARM NOTIFICATION] !!! ALARM !!! Device: " << deviceName 
+         << " - " << message << "\n";
+    std::cout << line.str() << std::flush;
+}
+
+// SmsGateway / StubSmsGateway Implementation
+SmsGateway::~SmsGateway() {}
+
+StubSmsGateway::StubSmsGateway() : latencyMs(0), sentCount(0) {
+    const char* env = std::getenv("MSH_SMS_LATENCY_MS");
+    if (env && *env) {
+        setLatency(std::atoi(env));
+    }
+}
+
+bool StubSmsGateway::send(const std::string& phone, const std::string& text) {
+    int delay = latencyMs.load();
+    if (delay > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    }
+    std::ostringstream lines;
+    lines << "[SMS NOTIFICATION] Sending SMS to " << phone << "\n"
+          << "  Message: " << text << "\n"
+          << "  (A SMS is sent)\n";
+    std::cout << lines.str() << std::flush;
+    sentCount.fetch_add(1);
+    return true;
+}
+
+void StubSmsGateway::setLatency(int ms) {
+    latencyMs.store(ms > 0 ? ms : 0);
+}
+
+int StubSmsGateway::getLatency() const {
+    return latencyMs.load();
+}
+
+unsigned long long StubSmsGateway::getSentCount() const {
+    return sentCount.load();
 }
 
 // SMSNotification Implementation
-SMSNotification::SMSNotification(const std::string& phone)
-    : NotificationStrategy("SMS Notification"), phoneNumber(phone) {
+SMSNotification::SMSNotification(SmsGateway* gw, const std::string& phone)
+    : NotificationStrategy("SMS Notification"), gateway(gw), phoneNumber(phone) {
 }
 
 void SMSNotification::notify(const std::string& deviceName, const std::string& message) {
-    std::cout << "[SMS NOTIFICATION] Sending SMS to " << phoneNumber << std::endl;
-    std::cout << "  Message: Device '" << deviceName << "' - " << message << std::endl;
-    std::cout << "  (A SMS is sent)" << std::endl;
+    std::string phone;
+    {
+        std::lock_guard<std::mutex> lock(phoneMutex);
+        phone = phoneNumber;
+    }
+    gateway->send(phone, "Device '" + deviceName + "' - " + message);
 }
 
 void SMSNotification::setPhoneNumber(const std::string& phone) {
-    phoneNumber = phone;
-    std::cout << "[INFO] SMS phone number updated to: " << phoneNumber << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(phoneMutex);
+        phoneNumber = phone;
+    }
+    std::cout << "[INFO] SMS phone number updated to: " << phone << std::endl;
 }
 
 // NotificationSystem Implementation
 NotificationSystem::NotificationSystem()
-    : logEnabled(true), alarmEnabled(false), smsEnabled(false) {
+    : logEnabled(true), alarmEnabled(false), smsEnabled(false),
+      stopRequested(false), windowMs(DEFAULT_WINDOW_MS), windowOpen(false), windowHeld(0) {
     
+    smsGateway = new StubSmsGateway();
     logStrategy = new LogNotification();
     alarmStrategy = new AlarmNotification();
-    smsStrategy = new SMSNotification();
+    smsStrategy = new SMSNotification(smsGateway);
+
+    // Log keeps the latest failures, alarms push back briefly before giving
+    // up, SMS keeps the first failures of a burst while the gateway catches up
+    logQueue = new NotificationQueue(logStrategy, QUEUE_CAPACITY, NotificationQueue::DROP_OLDEST);
+    alarmQueue = new NotificationQueue(alarmStrategy, QUEUE_CAPACITY, NotificationQueue::BLOCK, ALARM_BLOCK_MS);
+    smsQueue = new NotificationQueue(smsStrategy, QUEUE_CAPACITY, NotificationQueue::DROP_NEWEST);
+    setRateLimits(10, 1, 0.1);
+
+    const char* env = std::getenv("MSH_NOTIFY_WINDOW_MS");
+    if (env && *env) {
+        setCoalesceWindow(std::atoi(env));
+    }
     
     // Log is enabled by default
-    strategies.push_back(logStrategy);
+    strategies.push_back(logQueue);
+    summaryThread = std::thread(&NotificationSystem::summaryLoop, this);
 }
 
 NotificationSystem::~NotificationSystem() {
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        stopRequested = true;
+    }
+    windowWakeup.notify_one();
+    summaryThread.join();   // Posts the summary of an open window on its way out
+
+    // Queues go next: their destructors deliver what is left and join the workers
+    delete logQueue;
+    delete alarmQueue;
+    delete smsQueue;
     delete logStrategy;
     delete alarmStrategy;
     delete smsStrategy;
+    delete smsGateway;
+}
+
+// The channels are posted to after dispatchMutex is released, so a blocking
+// alarm queue only ever holds up the caller that hit it
+void NotificationSystem::postAll(NotificationQueue* const* targets, size_t count, const std::string& deviceName,
+                                 const std::string& message, bool bypassLimit) {
+    for (size_t i = 0; i < count; ++i) {
+        targets[i]->post(deviceName, message, bypassLimit);
+    }
 }
 
 void NotificationSystem::onDeviceFailure(const std::string& deviceName, const std::string& message) {
-    std::cout << std::endl;
-    std::cout << "*** DEVICE FAILURE NOTIFICATION ***" << std::endl;
-    
-    for (size_t i = 0; i < strategies.size(); ++i) {
-        strategies[i]->notify(deviceName, message);
+    NotificationQueue* targets[CHANNEL_COUNT];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        count = dispatchFailure(deviceName, message, targets);
     }
-    
-    std::cout << "***********************************" << std::endl;
-    std::cout << std::endl;
+    postAll(targets, count, deviceName, message, false);
 }
 
-void NotificationSystem::enableLog(bool enable) {
-    if (enable && !logEnabled) {
-        strategies.push_back(logStrategy);
-        logEnabled = true;
-        std::cout << "[INFO] Log notification ENABLED." << std::endl;
-    } else if (!enable && logEnabled) {
-        for (std::vector<NotificationStrategy*>::iterator it = strategies.begin(); 
-             it != strategies.end(); ++it) {
-            if (*it == logStrategy) {
-                strategies.erase(it);
-                break;
-            }
+void NotificationSystem::onDeviceEvent(const DeviceEvent& event) {
+    // Same text as the default "Name #ID", built in reused buffers so a
+    // coalesced repeat costs no allocation; only a forwarded one is copied out
+    NotificationQueue* targets[CHANNEL_COUNT];
+    size_t count;
+    std::string deviceName;
+    std::string message;
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        labelBuffer.assign(event.device.getName());
+        if (event.device.getDeviceId() >= 0) {
+            char id[16];
+            snprintf(id, sizeof(id), " #%d", event.device.getDeviceId());
+            labelBuffer += id;
+        }
+        messageBuffer.assign(event.message);
+        count = dispatchFailure(labelBuffer, messageBuffer, targets);
+        if (count > 0) {
+            deviceName = labelBuffer;
+            message = messageBuffer;
         }
-        logEnabled = false;
-        std::cout << "[INFO] Log notification DISABLED." << std::endl;
     }
+    postAll(targets, count, deviceName, message, false);
 }
 
-void NotificationSystem::enableAlarm(bool enable) {
-    if (enable && !alarmEnabled) {
-        strategies.push_back(alarmStrategy);
-        alarmEnabled = true;
-        std::cout << "[INFO] Alarm notification ENABLED." << std::endl;
-    } else if (!enable && alarmEnabled) {
-        for (std::vector<NotificationStrategy*>::iterator it = strategies.begin(); 
-             it != strategies.end(); ++it) {
-            if (*it == alarmStrategy) {
-                strategies.erase(it);
-                break;
-            }
+size_t NotificationSystem::dispatchFailure(const std::string& deviceName, const std::string& message,
+                                           NotificationQueue** targets) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    ++counters.received;
+
+    if (!windowOpen) {
+        windowOpen = true;
+        windowEnd = now + std::chrono::milliseconds(windowMs);
+        windowWakeup.notify_one();
+    }
+
+    keyBuffer.assign(deviceName);
+    keyBuffer += '\n';
+    keyBuffer += message;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>::iterator it = lastForwarded.find(keyBuffer);
+    if (it != lastForwarded.end() && now - it->second < std::chrono::milliseconds(windowMs)) {
+        ++counters.coalesced;
+        return 0;
+    }
+    if (it == lastForwarded.end()) {
+        lastForwarded.insert(std::make_pair(keyBuffer, now));
+    } else {
+        it->second = now;
+    }
+
+    windowDevices.insert(deviceName);
+    if (windowDevices.size() > SUMMARY_AFTER) {
+        ++windowHeld;
+        ++counters.summarized;
+        return 0;
+    }
+
+    ++counters.forwarded;
+    std::copy(strategies.begin(), strategies.end(), targets);
+    return strategies.size();
+}
+
+size_t NotificationSystem::closeWindow(std::chrono::steady_clock::time_point now, std::string& summaryText,
+                                       NotificationQueue** targets) {
+    size_t count = 0;
+    if (windowHeld > 0) {
+        std::ostringstream summary;
+        summary << windowDevices.size() << " devices failed in the last "
+                << (windowMs % 1000 == 0 ? windowMs / 1000 : windowMs) << (windowMs % 1000 == 0 ? "s" : "ms")
+                << " (" << windowHeld << " not reported individually)";
+        ++counters.summaries;
+        summaryText = summary.str();
+        std::copy(strategies.begin(), strategies.end(), targets);
+        count = strategies.size();
+    }
+    windowOpen = false;
+    windowHeld = 0;
+    windowDevices.clear();
+
+    // Forget keys whose window has passed so the map tracks only recent failures
+    for (std::unordered_map<std::string, std::chrono::steady_clock::time_point>::iterator it = lastForwarded.begin();
+         it != lastForwarded.end();) {
+        if (now - it->second >= std::chrono::milliseconds(windowMs)) {
+            it = lastForwarded.erase(it);
+        } else {
+            ++it;
         }
-        alarmEnabled = false;
-        std::cout << "[INFO] Alarm notification DISABLED." << std::endl;
     }
+    return count;
 }
 
-void NotificationSystem::enableSMS(bool enable) {
-    if (enable && !smsEnabled) {
-        strategies.push_back(smsStrategy);
-        smsEnabled = true;
-        std::cout << "[INFO] SMS notification ENABLED." << std::endl;
-    } else if (!enable && smsEnabled) {
-        for (std::vector<NotificationStrategy*>::iterator it = strategies.begin(); 
+void NotificationSystem::summaryLoop() {
+    NotificationQueue* targets[CHANNEL_COUNT];
+    std::string summary;
+    std::unique_lock<std::mutex> lock(dispatchMutex);
+    while (!stopRequested) {
+        if (!windowOpen) {
+            windowWakeup.wait(lock);
+            continue;
+        }
+        windowWakeup.wait_until(lock, windowEnd);
+        if (windowOpen && std::chrono::steady_clock::now() >= windowEnd) {
+            size_t count = closeWindow(std::chrono::steady_clock::now(), summary, targets);
+            lock.unlock();
+            postAll(targets, count, "Multiple devices", summary, true);
+            lock.lock();
+        }
+    }
+    size_t count = windowOpen ? closeWindow(std::chrono::steady_clock::now(), summary, targets) : 0;
+    lock.unlock();
+    postAll(targets, count, "Multiple devices", summary, true);
+}
+
+void NotificationSystem::flush() {
+    NotificationQueue* targets[CHANNEL_COUNT];
+    std::string summary;
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        if (windowOpen) {
+            count = closeWindow(std::chrono::steady_clock::now(), summary, targets);
+        }
+    }
+    postAll(targets, count, "Multiple devices", summary, true);
+    logQueue->flush();
+    alarmQueue->flush();
+    smsQueue->flush();
+}
+
+void NotificationSystem::setCoalesceWindow(int ms) {
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    windowMs = ms > 0 ? ms : 1;
+}
+
+int NotificationSystem::getCoalesceWindow() const {
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    return windowMs;
+}
+
+void NotificationSystem::setRateLimits(double logPerSecond, double alarmPerSecond, double smsPerSecond) {
+    logQueue->setRateLimit(logPerSecond, LOG_BURST);
+    alarmQueue->setRateLimit(alarmPerSecond, ALARM_BURST);
+    smsQueue->setRateLimit(smsPerSecond, SMS_BURST);
+}
+
+NotificationCounters NotificationSystem::getCounters() const {
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    return counters;
+}
+
+void NotificationSystem::enableChannel(NotificationQueue* queue, bool& enabled, bool enable, const char* label) {
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    if (enable && !enabled) {
+        strategies.push_back(queue);
+        enabled = true;
+        std::cout << "[INFO] " << label << " notification ENABLED." << std::endl;
+    } else if (!enable && enabled) {
+        for (std::vector<NotificationQueue*>::iterator it = strategies.begin(); 
              it != strategies.end(); ++it) {
-            if (*it == smsStrategy) {
+            if (*it == queue) {
                 strategies.erase(it);
                 break;
             }
         }
-        smsEnabled = false;
-        std::cout << "[INFO] SMS notification DISABLED." << std::endl;
+        enabled = false;
+        std::cout << "[INFO] " << label << " notification DISABLED." << std::endl;
     }
 }
 
+void NotificationSystem::enableLog(bool enable) {
+    enableChannel(logQueue, logEnabled, enable, "Log");
+}
+
+void NotificationSystem::enableAlarm(bool enable) {
+    enableChannel(alarmQueue, alarmEnabled, enable, "Alarm");
+}
+
+void NotificationSystem::enableSMS(bool enable) {
+    enableChannel(smsQueue, smsEnabled, enable, "SMS");
+}
+
 bool NotificationSystem::isLogEnabled() const {
     return logEnabled;
 }
@@ -147,9 +362,31 @@ void NotificationSystem::setPhoneNumber(const std::string& phone) {
     smsStrategy->setPhoneNumber(phone);
 }
 
+StubSmsGateway* NotificationSystem::getSmsGateway() const {
+    return smsGateway;
+}
+
+static void displayChannel(const char* label, bool enabled, const NotificationQueue* queue) {
+    NotificationQueueStats stats = queue->getStats();
+    std::cout << "  " << label << ": " << (enabled ? "ENABLED" : "DISABLED")
+              << " (queued " << stats.depth << "/" << stats.capacity
+              << ", delivered " << stats.delivered << ", rate limited " << stats.rateLimited
+              << ", dropped " << stats.dropped << ")" << std::endl;
+    std::cout << "    " << queue->describeLimit() << ", "
+              << NotificationQueue::policyName(queue->getPolicy()) << " when full" << std::endl;
+}
+
 void NotificationSystem::displayStatus() const {
     std::cout << "=== Notification System Status ===" << std::endl;
-    std::cout << "  Log Notification: " << (logEnabled ? "ENABLED" : "DISABLED") << std::endl;
-    std::cout << "  Alarm Notification: " << (alarmEnabled ? "ENABLED" : "DISABLED") << std::endl;
-    std::cout << "  SMS Notification: " << (smsEnabled ? "ENABLED" : "DISABLED") << std::endl;
+    displayChannel("Log Notification", logEnabled, logQueue);
+    displayChannel("Alarm Notification", alarmEnabled, alarmQueue);
+    displayChannel("SMS Notification", smsEnabled, smsQueue);
+
+    NotificationCounters c = getCounters();
+    std::cout << "  Failures received: " << c.received << " (reported " << c.forwarded
+              << ", repeats coalesced " << c.coalesced << ", summarized " << c.summarized
+              << " in " << c.summaries << " summaries)" << std::endl;
+    if (smsGateway->getLatency() > 0) {
+        std::cout << "  SMS gateway latency: " << smsGateway->getLatency() << " ms (stub)" << std::endl;
+    }
 }
@@ -0,0 +1,112 @@
+#include "OutputSink.h"
+#include <iostream>
+#include <cstdlib>
+
+OutputSink* OutputSink::instance = NULL;
+
+OutputSink::OutputSink()
+    : mode(OUTPUT_VERBOSE), nullStream(NULL), batchDepth(0), batchPoweredOn(0), batchPoweredOff(0) {
+    const char* env = std::getenv("MSH_OUTPUT");
+    if (env) {
+        Mode fromEnv;
+        if (parseMode(env, fromEnv)) {
+            mode = fromEnv;
+        } else {
+            std::cout << "[WARNING] Unknown MSH_OUTPUT value '" << env << "', using verbose output." << std::endl;
+        }
+    }
+}
+
+OutputSink* OutputSink::getInstance() {
+    if (instance == NULL) {
+        instance = new OutputSink();
+    }
+    return instance;
+}
+
+std::ostream& OutputSink::out() {
+    return getInstance()->stream();
+}
+
+void OutputSink::setMode(Mode newMode) {
+    mode = newMode;
+}
+
+OutputSink::Mode OutputSink::getMode() const {
+    return mode;
+}
+
+bool OutputSink::parseMode(const std::string& text, Mode& result) {
+    if (text == "silent" || text == "quiet") {
+        result = OUTPUT_SILENT;
+    } else if (text == "buffered" || text == "summary") {
+        result = OUTPUT_BUFFERED;
+    } else if (text == "verbose") {
+        result = OUTPUT_VERBOSE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* OutputSink::modeName(Mode m) {
+    switch (m) {
+        case OUTPUT_SILENT: return "silent";
+        case OUTPUT_BUFFERED: return "buffered";
+        default: return "verbose";
+    }
+}
+
+std::ostream& OutputSink::stream() {
+    return isEnabled() ? std::cout : nullStream;
+}
+
+bool OutputSink::isEnabled() const {
+    if (mode == OUTPUT_SILENT) {
+        return false;
+    }
+    return mode == OUTPUT_VERBOSE || batchDepth == 0;
+}
+
+void OutputSink::beginBatch(const std::string& label) {
+    if (batchDepth++ == 0) {
+        batchLabel = label;
+        batchPoweredOn = 0;
+        batchPoweredOff = 0;
+    }
+}
+
+void OutputSink::endBatch() {
+    if (batchDepth == 0 || --batchDepth > 0) {
+        return;
+    }
+    if (mode != OUTPUT_BUFFERED) {
+        return;
+    }
+
+    std::cout << batchLabel << ": ";
+    if (batchPoweredOn == 0 && batchPoweredOff == 0) {
+        std::cout << "no device changed state" << std::endl;
+    } else {
+        std::cout << batchPoweredOn << " device(s) powered ON, "
+                  << batchPoweredOff << " powered OFF" << std::endl;
+    }
+}
+
+void OutputSink::notePowerChange(bool on) {
+    if (batchDepth > 0) {
+        if (on) {
+            ++batchPoweredOn;
+        } else {
+            ++batchPoweredOff;
+        }
+    }
+}
+
+OutputBatch::OutputBatch(const std::string& label) {
+    OutputSink::getInstance()->beginBatch(label);
+}
+
+OutputBatch::~OutputBatch() {
+    OutputSink::getInstance()->endBatch();
+}
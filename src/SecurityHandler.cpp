@@ -11,21 +11,12 @@
  */
 
 #include "SecurityHandler.h"
-#include <cstddef> // for NULL
 
-SecurityHandler::SecurityHandler() : next(NULL) {}
+SecurityHandler::SecurityHandler(const std::string &name) : name(name) {}
 
 SecurityHandler::~SecurityHandler() {}
 
-void SecurityHandler::setNext(SecurityHandler *nextHandler)
+const std::string &SecurityHandler::getName() const
 {
-    next = nextHandler;
-}
-
-void SecurityHandler::handleRequest()
-{
-    if (next != NULL)
-    {
-        next->handleRequest();
-    }
+    return name;
 }
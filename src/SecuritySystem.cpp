@@ -7,47 +7,291 @@
  * @authors
  * - 220201047: Security System - Chain of Responsibility Manager
 
- * @patterns Chain of Responsibility, Facade (Subsystem)
+ * @patterns Chain of Responsibility, Facade (Subsystem), Observer
  */
 
 #include "SecuritySystem.h"
+#include "AlarmHandler.h"
+#include "LightBlinkHandler.h"
+#include "NotificationHandler.h"
+#include "CameraRecordHandler.h"
+#include "OutputSink.h"
+#include <chrono>
 #include <iostream>
 
-SecuritySystem::SecuritySystem(Alarm *alarm, std::vector<Light *> *lights)
-    : alarm(alarm), lights(lights), isActive(false)
+const size_t SecuritySystem::MAX_QUEUED;
+
+void SecuritySystem::Latency::add(long long nanos)
+{
+    ++calls;
+    totalNanos += nanos;
+    if (nanos > maxNanos)
+        maxNanos = nanos;
+}
+
+SecuritySystem::SecuritySystem(Alarm *alarm, const std::vector<Light *> *lights,
+                               const DeviceRegistry *registry, NotificationSystem *notifications)
+    : isActive(false), tableDirty(true), dispatching(false), processedCount(0), droppedCount(0)
 {
-    // Chain of Responsibility removed in V3.2
-    // Direct association used instead
+    SecurityHandler *alarmStage = addHandler(new AlarmHandler(alarm));
+    SecurityHandler *lightStage = addHandler(new LightBlinkHandler(lights));
+    SecurityHandler *notifyStage = addHandler(new NotificationHandler(notifications));
+    SecurityHandler *cameraStage = addHandler(new CameraRecordHandler(registry));
+
+    addRule(SECURITY_MOTION, alarmStage);
+    addRule(SECURITY_MOTION, lightStage);
+    addRule(SECURITY_MOTION, notifyStage);
+    addRule(SECURITY_MOTION, cameraStage);
+
+    addRule(SECURITY_DETECTION, alarmStage, false);
+    addRule(SECURITY_DETECTION, lightStage, false);
 }
 
 SecuritySystem::~SecuritySystem()
 {
+    for (size_t i = 0; i < handlers.size(); ++i)
+    {
+        delete handlers[i];
+    }
 }
 
 void SecuritySystem::activate()
 {
     isActive = true;
-    std::cout << "[SECURITY] Security system ACTIVATED." << std::endl;
+    OutputSink::out() << "[SECURITY] Security system ACTIVATED." << std::endl;
 }
 
 void SecuritySystem::deactivate()
 {
     isActive = false;
-    std::cout << "[SECURITY] Security system DEACTIVATED." << std::endl;
+    OutputSink::out() << "[SECURITY] Security system DEACTIVATED." << std::endl;
+}
+
+bool SecuritySystem::isArmed() const
+{
+    return isActive;
 }
 
-void SecuritySystem::handleMotionDetection()
+SecurityHandler *SecuritySystem::addHandler(SecurityHandler *handler)
 {
-    if (!isActive)
+    handlerIndex(handler);
+    return handler;
+}
+
+size_t SecuritySystem::handlerIndex(SecurityHandler *handler)
+{
+    for (size_t i = 0; i < handlers.size(); ++i)
+    {
+        if (handlers[i] == handler)
+            return i;
+    }
+    handlers.push_back(handler);
+    handlerStats.push_back(Latency());
+    return handlers.size() - 1;
+}
+
+void SecuritySystem::addRule(SecurityEventType type, SecurityHandler *handler, bool armedOnly, int minValue)
+{
+    if (!handler || type < 0 || type >= SECURITY_EVENT_COUNT)
         return;
+    handlerIndex(handler);
+    Rule rule;
+    rule.type = type;
+    rule.handler = handler;
+    rule.armedOnly = armedOnly;
+    rule.minValue = minValue;
+    rules.push_back(rule);
+    tableDirty = true;
+}
+
+void SecuritySystem::clearRules()
+{
+    rules.clear();
+    tableDirty = true;
+}
+
+const std::vector<SecuritySystem::Rule> &SecuritySystem::getRules() const
+{
+    return rules;
+}
+
+size_t SecuritySystem::getStageCount(SecurityEventType type) const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < rules.size(); ++i)
+    {
+        if (rules[i].type == type)
+            ++count;
+    }
+    return count;
+}
+
+// Only called between events, so a rule added by a handler takes effect
+// with the next processEvents() and never under a running stage list
+void SecuritySystem::compileRules()
+{
+    for (int t = 0; t < SECURITY_EVENT_COUNT; ++t)
+    {
+        table[t].clear();
+    }
+    for (size_t i = 0; i < rules.size(); ++i)
+    {
+        Stage stage;
+        stage.handler = rules[i].handler;
+        stage.metric = handlerIndex(rules[i].handler);
+        stage.armedOnly = rules[i].armedOnly;
+        stage.minValue = rules[i].minValue;
+        table[rules[i].type].push_back(stage);
+    }
+    tableDirty = false;
+}
+
+long long SecuritySystem::nowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool SecuritySystem::post(const SecurityEvent &event)
+{
+    if (event.type < 0 || event.type >= SECURITY_EVENT_COUNT)
+        return false;
+    if (queue.size() >= MAX_QUEUED)
+    {
+        ++droppedCount;
+        OutputSink::out() << "[WARNING] Security event queue full, dropped "
+                          << eventName(event.type) << " from " << event.source << std::endl;
+        return false;
+    }
+    long long now = nowNanos();
+    queue.push_back(event);
+    queue.back().queuedAt = now;
+    drain(now);
+    return true;
+}
+
+size_t SecuritySystem::processEvents()
+{
+    return drain(nowNanos());
+}
+
+// One clock read per stage: each stage ends where the next one (or the
+// next event) starts
+size_t SecuritySystem::drain(long long now)
+{
+    if (dispatching)
+        return 0;
+    if (tableDirty)
+        compileRules();
+
+    dispatching = true;
+    bool verbose = OutputSink::getInstance()->isEnabled();
+    size_t count = 0;
+    while (!queue.empty())
+    {
+        // push_back from a handler leaves this reference valid
+        const SecurityEvent &event = queue.front();
+        long long start = now;
+        queueWait.add(start - event.queuedAt);
+
+        const std::vector<Stage> &stages = table[event.type];
+        bool announced = !verbose;
+        long long stageStart = start;
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            const Stage &stage = stages[i];
+            if ((stage.armedOnly && !isActive) || event.value < stage.minValue)
+                continue;
+            if (!announced)
+            {
+                OutputSink::out() << "[SECURITY] " << eventName(event.type) << " from " << event.source
+                                  << "! Initiating security sequence..." << std::endl;
+                announced = true;
+            }
+            stage.handler->handle(event);
+            long long end = nowNanos();
+            handlerStats[stage.metric].add(end - stageStart);
+            stageStart = end;
+        }
+        eventStats[event.type].add(stageStart - start);
+        now = stageStart;
+
+        queue.pop_front();
+        ++processedCount;
+        ++count;
+    }
+    dispatching = false;
+    return count;
+}
+
+void SecuritySystem::onDeviceFailure(const std::string &, const std::string &)
+{
+    // Failures are for the NotificationSystem
+}
+
+void SecuritySystem::onDeviceEvent(const DeviceEvent &event)
+{
+    if (event.type == EVENT_DETECTION)
+    {
+        post(SecurityEvent(SECURITY_DETECTION, event.device.getName(), event.device.getDeviceId(), event.value));
+    }
+}
+
+void SecuritySystem::getMetrics(std::vector<SecurityStageMetrics> &out) const
+{
+    out.clear();
+    SecurityStageMetrics wait;
+    wait.stage = "Queue wait";
+    wait.calls = queueWait.calls;
+    wait.totalNanos = queueWait.totalNanos;
+    wait.maxNanos = queueWait.maxNanos;
+    out.push_back(wait);
+    for (size_t i = 0; i < handlers.size(); ++i)
+    {
+        SecurityStageMetrics stage;
+        stage.stage = handlers[i]->getName();
+        stage.calls = handlerStats[i].calls;
+        stage.totalNanos = handlerStats[i].totalNanos;
+        stage.maxNanos = handlerStats[i].maxNanos;
+        out.push_back(stage);
+    }
+}
 
-    std::cout << "[SECURITY] Motion detected! Initiating security sequence..." << std::endl;
+unsigned long long SecuritySystem::getProcessedCount() const
+{
+    return processedCount;
+}
+
+unsigned long long SecuritySystem::getDroppedCount() const
+{
+    return droppedCount;
+}
+
+void SecuritySystem::resetMetrics()
+{
+    for (size_t i = 0; i < handlerStats.size(); ++i)
+    {
+        handlerStats[i] = Latency();
+    }
+    queueWait = Latency();
+    for (int t = 0; t < SECURITY_EVENT_COUNT; ++t)
+    {
+        eventStats[t] = Latency();
+    }
+    processedCount = 0;
+    droppedCount = 0;
+}
 
-    // Direct action
-    if (alarm)
+const char *SecuritySystem::eventName(SecurityEventType type)
+{
+    switch (type)
     {
-        std::cout << "[SECURITY] Triggering Alarm directly..." << std::endl;
-        alarm->ring();
+    case SECURITY_MOTION:
+        return "Motion";
+    case SECURITY_DETECTION:
+        return "Detection";
+    default:
+        return "Unknown";
     }
 }
 
@@ -55,5 +299,36 @@ void SecuritySystem::displayStatus() const
 {
     std::cout << "--- SECURITY SYSTEM ---" << std::endl;
     std::cout << "  Status: " << (isActive ? "ARMED" : "DISARMED") << std::endl;
-    std::cout << "  Architecture: Direct Call (No Chain)" << std::endl;
-}
\ No newline at end of file
+    std::cout << "  Architecture: Event queue + dispatch table (" << rules.size() << " rules)" << std::endl;
+    for (int t = 0; t < SECURITY_EVENT_COUNT; ++t)
+    {
+        std::cout << "  " << eventName((SecurityEventType)t) << ":";
+        const char *separator = " ";
+        for (size_t i = 0; i < rules.size(); ++i)
+        {
+            if (rules[i].type != t)
+                continue;
+            std::cout << separator << rules[i].handler->getName();
+            if (!rules[i].armedOnly)
+                std::cout << " (always)";
+            separator = " -> ";
+        }
+        if (eventStats[t].calls > 0)
+        {
+            std::cout << " | " << eventStats[t].calls << " event(s), avg "
+                      << eventStats[t].totalNanos / 1000 / (long long)eventStats[t].calls << " us";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  Events: " << processedCount << " handled, " << droppedCount << " dropped" << std::endl;
+    std::vector<SecurityStageMetrics> metrics;
+    getMetrics(metrics);
+    for (size_t i = 0; i < metrics.size(); ++i)
+    {
+        if (metrics[i].calls == 0)
+            continue;
+        std::cout << "    " << metrics[i].stage << ": " << metrics[i].calls << " call(s), avg "
+                  << metrics[i].totalNanos / 1000 / (long long)metrics[i].calls << " us, max "
+                  << metrics[i].maxNanos / 1000 << " us" << std::endl;
+    }
+}
@@ -0,0 +1,232 @@
+#include "SensorPipeline.h"
+#include "Detector.h"
+#include "LevelHistory.h"
+
+const int SensorPipeline::LATCHED;
+
+namespace {
+
+inline int lowestBit(DetectorBank::Word w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    while (!(w & 1)) {
+        w >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+}
+
+SensorPipeline::SensorPipeline()
+    : readingCount(0), transitionCount(0), releaseCount(0), unknownCount(0) {
+}
+
+SensorPipeline::~SensorPipeline() {
+    for (size_t i = 0; i < detectors.size(); ++i) {
+        if (detectors[i]) {
+            detach(detectors[i]);
+        }
+    }
+}
+
+void SensorPipeline::attach(Detector* detector) {
+    if (!detector || detector->pipeline || detector->getDeviceId() < 0) {
+        return;
+    }
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = (int)detectors.size();
+        detectors.push_back(NULL);
+        bank.add(LATCHED, -1);
+        levels.push_back(0);
+        lastTimes.push_back(0);
+        filters.push_back(SignalFilter());
+        thresholds.push_back(0);
+        filtered.push_back(0);
+        histories.push_back(NULL);
+    }
+    detectors[slot] = detector;
+    levels[slot] = detector->getReading();
+    filters[slot] = detector->filter;
+    detector->pipeline = this;
+    detector->pipelineSlot = slot;
+
+    size_t id = (size_t)detector->getDeviceId();
+    if (id >= slotOfId.size()) {
+        slotOfId.resize(id + 1, -1);
+    }
+    slotOfId[id] = slot;
+    refresh(slot);
+}
+
+void SensorPipeline::detach(Detector* detector, bool keepLevel) {
+    if (!detector || detector->pipeline != this) {
+        return;
+    }
+    int slot = detector->pipelineSlot;
+    size_t id = (size_t)detector->getDeviceId();
+    if (id < slotOfId.size()) {
+        slotOfId[id] = -1;
+    }
+    detectors[slot] = NULL;
+    histories[slot] = NULL;
+    bank.setThreshold(slot, LATCHED);
+    freeSlots.push_back(slot);
+    detector->pipeline = NULL;
+    detector->pipelineSlot = -1;
+    if (keepLevel) {
+        detector->recordLevel(levels[slot]);   // The detector owns its level and filter again
+        detector->filter = filters[slot];
+    }
+}
+
+void SensorPipeline::refresh(int slot) {
+    if (slot < 0 || (size_t)slot >= detectors.size() || !detectors[slot]) {
+        return;
+    }
+    const Detector* detector = detectors[slot];
+    thresholds[slot] = detector->getThreshold();
+    filtered[slot] = filters[slot].isPassThrough() ? 0 : 1;
+    histories[slot] = detector->history;
+    bank.setThreshold(slot, detector->isDetected() ? LATCHED : thresholds[slot]);
+}
+
+void SensorPipeline::raise(int slot, int level) {
+    Detector* detector = detectors[slot];
+    if (!detector->isPoweredOn() || !detector->isActive()) {
+        return;
+    }
+    detector->raiseDetection(level);
+
+    SensorTransition transition;
+    transition.detectorId = detector->getDeviceId();
+    transition.level = level;
+    transition.timestamp = lastTimes[slot];
+    transitions.push_back(transition);
+}
+
+// Same decisions as Detector::evaluateReading, minus the repeated alert lines
+void SensorPipeline::stepFilter(int slot, int level) {
+    SignalFilter& filter = filters[slot];
+    SignalFilter::Signal signal = filter.step(level, thresholds[slot]);
+    if (signal == SignalFilter::SIGNAL_RAISED) {
+        Detector* detector = detectors[slot];
+        if (!detector->isPoweredOn() || !detector->isActive()) {
+            filter.setAlarmed(false);
+        } else if (!detector->isDetected()) {
+            raise(slot, filter.getValue());
+        }
+    } else if (signal == SignalFilter::SIGNAL_RELEASED && detectors[slot]->isDetected()) {
+        detectors[slot]->releaseDetection(filter.getValue());
+        ++releaseCount;
+    }
+}
+
+size_t SensorPipeline::ingest(const SensorReading* readings, size_t count) {
+    transitions.clear();
+    touched.clear();
+
+    // Scatter: one peak and one last reading per detector
+    int* peaks = bank.levelData();
+    size_t known = 0;
+    for (size_t r = 0; r < count; ++r) {
+        size_t id = (size_t)readings[r].detectorId;
+        if (id >= slotOfId.size() || slotOfId[id] < 0) {
+            continue;
+        }
+        int slot = slotOfId[id];
+        int level = readings[r].level;
+        level = level < 0 ? 0 : (level > 100 ? 100 : level);
+        if (peaks[slot] < 0) {
+            touched.push_back(slot);
+            peaks[slot] = 0;
+        }
+        levels[slot] = level;
+        lastTimes[slot] = readings[r].timestamp;
+        ++known;
+        if (histories[slot]) {
+            histories[slot]->append(readings[r].timestamp, level);
+        }
+        if (filtered[slot]) {
+            stepFilter(slot, level);   // Its peak stays 0 and never beats the limit
+        } else {
+            peaks[slot] = level > peaks[slot] ? level : peaks[slot];
+        }
+    }
+    readingCount += known;
+    unknownCount += count - known;
+
+    // Compare: a dense pass when most detectors reported, otherwise just the
+    // touched ones. Untouched slots have peak -1 and never set a bit.
+    const int* limit = bank.thresholdData();
+    if (touched.size() * 8 >= bank.size()) {
+        if (bank.evaluate(hitMask) > 0) {
+            for (size_t w = 0; w < hitMask.size(); ++w) {
+                for (DetectorBank::Word bits = hitMask[w]; bits; bits &= bits - 1) {
+                    int slot = (int)(w * DetectorBank::WORD_BITS) + lowestBit(bits);
+                    raise(slot, peaks[slot]);
+                }
+            }
+        }
+    } else {
+        for (size_t t = 0; t < touched.size(); ++t) {
+            int slot = touched[t];
+            if (peaks[slot] > limit[slot]) {
+                raise(slot, peaks[slot]);
+            }
+        }
+    }
+
+    for (size_t t = 0; t < touched.size(); ++t) {
+        peaks[touched[t]] = -1;
+    }
+    transitionCount += transitions.size();
+    return transitions.size();
+}
+
+int SensorPipeline::getLevel(int slot) const {
+    return levels[slot];
+}
+
+void SensorPipeline::setLevel(int slot, int level) {
+    levels[slot] = level;
+}
+
+SignalFilter& SensorPipeline::getFilter(int slot) {
+    return filters[slot];
+}
+
+const SignalFilter& SensorPipeline::getFilter(int slot) const {
+    return filters[slot];
+}
+
+const std::vector<SensorTransition>& SensorPipeline::getTransitions() const {
+    return transitions;
+}
+
+size_t SensorPipeline::size() const {
+    return detectors.size() - freeSlots.size();
+}
+
+unsigned long long SensorPipeline::getReadingCount() const {
+    return readingCount;
+}
+
+unsigned long long SensorPipeline::getTransitionCount() const {
+    return transitionCount;
+}
+
+unsigned long long SensorPipeline::getReleaseCount() const {
+    return releaseCount;
+}
+
+unsigned long long SensorPipeline::getUnknownCount() const {
+    return unknownCount;
+}
@@ -0,0 +1,163 @@
+#include "SignalFilter.h"
+
+const int SignalFilter::MAX_WINDOW;
+const int SignalFilter::MAX_DEBOUNCE;
+const int SignalFilter::MAX_HYSTERESIS;
+
+namespace {
+
+int clampInt(int value, int low, int high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+}
+
+SignalFilter::SignalFilter()
+    : mode(FILTER_NONE), window(1), debounce(1), hysteresis(0), alpha(256),
+      alarmed(false), run(0), head(0), filled(0), sum(0), smoothed(0), value(0) {
+    for (int i = 0; i < MAX_WINDOW; ++i) {
+        history[i] = 0;
+    }
+}
+
+void SignalFilter::setSmoothing(Mode newMode, int amount) {
+    mode = (unsigned char)newMode;
+    window = 1;
+    alpha = 256;
+    if (newMode == FILTER_MOVING_AVERAGE) {
+        window = (unsigned char)clampInt(amount, 1, MAX_WINDOW);
+    } else if (newMode == FILTER_EWMA) {
+        alpha = (unsigned short)((clampInt(amount, 1, 100) * 256 + 50) / 100);
+    }
+    reset();
+}
+
+void SignalFilter::setDebounce(int samples) {
+    debounce = (unsigned char)clampInt(samples, 1, MAX_DEBOUNCE);
+    run = 0;
+}
+
+void SignalFilter::setHysteresis(int band) {
+    hysteresis = (unsigned char)clampInt(band, 0, MAX_HYSTERESIS);
+    run = 0;
+}
+
+void SignalFilter::configureFrom(const SignalFilter& other) {
+    mode = other.mode;
+    window = other.window;
+    debounce = other.debounce;
+    hysteresis = other.hysteresis;
+    alpha = other.alpha;
+    reset();
+}
+
+void SignalFilter::reset() {
+    alarmed = false;
+    run = 0;
+    head = 0;
+    filled = 0;
+    sum = 0;
+    smoothed = 0;
+    value = 0;
+}
+
+void SignalFilter::setAlarmed(bool on) {
+    alarmed = on;
+    run = 0;
+}
+
+SignalFilter::Signal SignalFilter::step(int level, int threshold) {
+    switch (mode) {
+        case FILTER_MOVING_AVERAGE:
+            if (filled == window) {
+                sum -= history[head];
+            } else {
+                ++filled;
+            }
+            history[head] = (unsigned char)level;
+            sum += (unsigned short)level;
+            head = (unsigned char)(head + 1 == window ? 0 : head + 1);
+            value = (sum + filled / 2) / filled;
+            break;
+        case FILTER_EWMA:
+            // The first sample seeds the average so it does not ramp up from 0
+            if (filled == 0) {
+                smoothed = level << 8;
+                filled = 1;
+            } else {
+                smoothed += ((level << 8) - smoothed) * alpha / 256;
+            }
+            value = (smoothed + 128) >> 8;
+            break;
+        default:
+            value = level;
+            break;
+    }
+
+    if (!alarmed) {
+        run = value > threshold ? (unsigned char)(run + 1) : 0;
+        if (run >= debounce) {
+            alarmed = true;
+            run = 0;
+            return SIGNAL_RAISED;
+        }
+        return SIGNAL_QUIET;
+    }
+    if (value > threshold) {
+        run = 0;
+        return SIGNAL_ALERT;
+    }
+    if (hysteresis == 0) {
+        return SIGNAL_QUIET;
+    }
+    run = value <= threshold - hysteresis ? (unsigned char)(run + 1) : 0;
+    if (run >= debounce) {
+        alarmed = false;
+        run = 0;
+        return SIGNAL_RELEASED;
+    }
+    return SIGNAL_QUIET;
+}
+
+bool SignalFilter::isPassThrough() const {
+    return mode == FILTER_NONE && debounce == 1 && hysteresis == 0;
+}
+
+bool SignalFilter::isAlarmed() const {
+    return alarmed;
+}
+
+int SignalFilter::getValue() const {
+    return value;
+}
+
+SignalFilter::Mode SignalFilter::getMode() const {
+    return (Mode)mode;
+}
+
+int SignalFilter::getAmount() const {
+    if (mode == FILTER_MOVING_AVERAGE) {
+        return window;
+    }
+    if (mode == FILTER_EWMA) {
+        return (alpha * 100 + 128) / 256;
+    }
+    return 0;
+}
+
+int SignalFilter::getDebounce() const {
+    return debounce;
+}
+
+int SignalFilter::getHysteresis() const {
+    return hysteresis;
+}
+
+const char* SignalFilter::modeName(Mode mode) {
+    switch (mode) {
+        case FILTER_NONE:           return "none";
+        case FILTER_MOVING_AVERAGE: return "moving average";
+        case FILTER_EWMA:           return "EWMA";
+    }
+    return "unknown";
+}
@@ -25,17 +25,28 @@ std::string SmokeDetector::getDeviceType() const {
 
 std::string SmokeDetector::getStatus() const {
     std::ostringstream oss;
-    oss << Detector::getStatus() << " | Smoke Level: " << smokeLevel << "%";
+    oss << Detector::getStatus() << " | Smoke Level: " << getSmokeLevel() << "%";
     return oss.str();
 }
 
 void SmokeDetector::detect() {
-    if (!powerState || !operationMode) return;
-    
-    if (smokeLevel > (10 - sensitivityLevel) * 10) {  // Higher sensitivity = lower threshold
-        detected = true;
-        std::cout << "[ALERT] " << name << " detected SMOKE! Level: " << smokeLevel << "%" << std::endl;
-    }
+    checkDetection(getSmokeLevel());
+}
+
+int SmokeDetector::getReading() const {
+    return getSmokeLevel();
+}
+
+void SmokeDetector::recordLevel(int level) {
+    smokeLevel = level;
+}
+
+void SmokeDetector::printAlert(int level) const {
+    std::cout << "[ALERT] " << name << " detected SMOKE! Level: " << level << "%" << std::endl;
+}
+
+const char* SmokeDetector::detectionMessage() const {
+    return "Smoke detected";
 }
 
 void SmokeDetector::trigger() {
@@ -43,14 +54,15 @@ void SmokeDetector::trigger() {
 }
 
 int SmokeDetector::getSmokeLevel() const {
-    return smokeLevel;
+    return currentLevel(smokeLevel);
 }
 
 void SmokeDetector::setSmokeLevel(int level) {
     if (level < 0) level = 0;
     if (level > 100) level = 100;
     smokeLevel = level;
-    detect();  // Auto-check after level change
+    levelChanged(level);
+    evaluateReading(level);  // Auto-check after level change
 }
 
 // Nest Smoke Detector
@@ -67,6 +79,8 @@ Device* NestSmokeDetector::clone() const {
     return newDet;
 }
 
+MSH_DEFINE_POOLED_DEVICE(NestSmokeDetector)
+
 // First Alert Smoke Detector
 FirstAlertSmokeDetector::FirstAlertSmokeDetector()
     : SmokeDetector("First Alert", "Onelink Safe & Sound") {
@@ -80,3 +94,5 @@ Device* FirstAlertSmokeDetector::clone() const {
     newDet->copyConfigurationFrom(this);
     return newDet;
 }
+
+MSH_DEFINE_POOLED_DEVICE(FirstAlertSmokeDetector)
@@ -0,0 +1,339 @@
+#include "SnapshotStore.h"
+#include "TimestampFormatter.h"
+#include "BinaryCodec.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+const char SnapshotStore::MAGIC[8] = { 'M', 'S', 'H', 'S', 'N', 'P', '1', '\n' };
+const char* SnapshotStore::DEFAULT_PATH = "msh_snapshots.bin";
+
+namespace {
+
+const size_t HEADER_SIZE = 8;   // u32 length + u32 CRC
+
+// Applies one record payload on top of snapshot. The payload is fully
+// parsed before anything is changed, so a bad record leaves snapshot alone.
+bool decodePayload(const char* data, size_t size, StoredSnapshot& snapshot,
+                   std::vector<unsigned>& changes, bool& keyframe) {
+    if (size < 1) {
+        return false;
+    }
+    size_t pos = 1;
+    unsigned long long timestamp;
+    unsigned long long stateLength;
+    unsigned long long modeLength;
+    if (!BinaryCodec::getVarint(data, size, pos, timestamp) ||
+        !BinaryCodec::getVarint(data, size, pos, stateLength) || stateLength > size - pos) {
+        return false;
+    }
+    size_t statePos = pos;
+    pos += (size_t)stateLength;
+    if (!BinaryCodec::getVarint(data, size, pos, modeLength) || modeLength > size - pos) {
+        return false;
+    }
+    size_t modePos = pos;
+    pos += (size_t)modeLength;
+
+    unsigned long long count;
+    if (!BinaryCodec::getVarint(data, size, pos, count)) {
+        return false;
+    }
+    if (data[0] == SnapshotStore::RECORD_KEYFRAME) {
+        if (count != (size - pos) / 16 || (size - pos) % 16 != 0) {
+            return false;
+        }
+        keyframe = true;
+        snapshot.power.present.resize((size_t)count);
+        snapshot.power.power.resize((size_t)count);
+        for (size_t w = 0; w < count; ++w) {
+            snapshot.power.present[w] = BinaryCodec::getU64(data + pos);
+            snapshot.power.power[w] = BinaryCodec::getU64(data + pos + 8);
+            pos += 16;
+        }
+    } else if (data[0] == SnapshotStore::RECORD_DELTA) {
+        changes.clear();
+        unsigned id = 0;
+        for (unsigned long long i = 0; i < count; ++i) {
+            unsigned long long item;
+            if (!BinaryCodec::getVarint(data, size, pos, item)) {
+                return false;
+            }
+            id += (unsigned)(item >> 2);
+            changes.push_back((id << 2) | (unsigned)(item & 3));
+        }
+        if (pos != size) {
+            return false;
+        }
+        keyframe = false;
+        snapshot.power.apply(changes);
+    } else {
+        return false;
+    }
+
+    snapshot.timestamp = (long long)timestamp;
+    snapshot.stateName.assign(data + statePos, (size_t)stateLength);
+    snapshot.modeName.assign(data + modePos, (size_t)modeLength);
+    return true;
+}
+
+bool syncFile(FILE* file) {
+    bool ok = fflush(file) == 0;
+#ifdef _WIN32
+    ok = _commit(_fileno(file)) == 0 && ok;
+#else
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    return ok;
+}
+
+bool truncateFile(const std::string& path, long size) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_BINARY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = _chsize(fd, size) == 0;
+    _close(fd);
+    return ok;
+#else
+    return truncate(path.c_str(), (off_t)size) == 0;
+#endif
+}
+
+}
+
+SnapshotStore::SnapshotStore()
+    : file(NULL), fileSize(0), recordCount(0), sinceKeyframe(0), unsynced(0) {
+}
+
+SnapshotStore::~SnapshotStore() {
+    close();
+}
+
+bool SnapshotStore::open(const std::string& fname, StoredSnapshot& latest, bool& found) {
+    close();
+    path = fname;
+    found = false;
+    recordCount = 0;
+    sinceKeyframe = 0;
+    latest = StoredSnapshot();
+
+    std::vector<char> data;
+    {
+        std::ifstream in(fname.c_str(), std::ios::in | std::ios::binary);
+        if (in.is_open()) {
+            data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+    }
+
+    // Replay records until the end or the first one that is torn or corrupt
+    bool damaged = false;
+    size_t pos = sizeof(MAGIC);
+    if (!data.empty()) {
+        if (data.size() < sizeof(MAGIC) || std::memcmp(&data[0], MAGIC, sizeof(MAGIC)) != 0) {
+            std::cout << "[WARNING] " << fname << " is not a snapshot store, starting a new one." << std::endl;
+            damaged = true;
+            pos = data.size();
+        }
+        while (pos < data.size()) {
+            if (data.size() - pos < HEADER_SIZE) {
+                damaged = true;
+                break;
+            }
+            size_t length = BinaryCodec::getU32(&data[pos]);
+            unsigned crc = BinaryCodec::getU32(&data[pos + 4]);
+            if (length == 0 || length > data.size() - pos - HEADER_SIZE ||
+                BinaryCodec::crc32(&data[pos + HEADER_SIZE], length) != crc) {
+                damaged = true;
+                break;
+            }
+            // The first record must be a keyframe
+            bool keyframe = false;
+            if ((!found && data[pos + HEADER_SIZE] != RECORD_KEYFRAME) ||
+                !decodePayload(&data[pos + HEADER_SIZE], length, latest, changes, keyframe)) {
+                damaged = true;
+                break;
+            }
+            found = true;
+            ++recordCount;
+            sinceKeyframe = keyframe ? 0 : sinceKeyframe + 1;
+            pos += HEADER_SIZE + length;
+        }
+        if (damaged && pos < data.size()) {
+            std::cout << "[WARNING] Dropped " << (data.size() - pos) << " damaged byte(s) at the end of "
+                      << fname << "." << std::endl;
+        }
+    }
+
+    lastWritten = latest.power;
+    if (damaged || recordCount > COMPACT_RECORDS) {
+        if (!rewrite(latest)) {
+            return false;
+        }
+    }
+
+    file = fopen(fname.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (fileSize = ftell(file)) < 0) {
+        close();
+        return false;
+    }
+    if (fileSize == 0) {
+        record.assign(MAGIC, sizeof(MAGIC));
+        if (!writeRecord()) {
+            return false;
+        }
+        sync();
+    }
+    return true;
+}
+
+void SnapshotStore::close() {
+    if (file) {
+        syncFile(file);
+        fclose(file);
+        file = NULL;
+    }
+    unsynced = 0;
+}
+
+bool SnapshotStore::isOpen() const {
+    return file != NULL;
+}
+
+void SnapshotStore::encode(const std::string& state, const std::string& mode, long long timestamp,
+                           const PowerSnapshot& snapshot, bool keyframe) {
+    record.assign(HEADER_SIZE, '\0');
+    record += (char)(keyframe ? RECORD_KEYFRAME : RECORD_DELTA);
+    BinaryCodec::putVarint(record, (unsigned long long)timestamp);
+    BinaryCodec::putVarint(record, state.size());
+    record += state;
+    BinaryCodec::putVarint(record, mode.size());
+    record += mode;
+
+    if (keyframe) {
+        BinaryCodec::putVarint(record, snapshot.present.size());
+        for (size_t w = 0; w < snapshot.present.size(); ++w) {
+            BinaryCodec::putU64(record, snapshot.present[w]);
+            BinaryCodec::putU64(record, snapshot.power[w]);
+        }
+    } else {
+        BinaryCodec::putVarint(record, changes.size());
+        unsigned previous = 0;
+        for (size_t i = 0; i < changes.size(); ++i) {
+            unsigned id = changes[i] >> 2;
+            BinaryCodec::putVarint(record, ((unsigned long long)(id - previous) << 2) | (changes[i] & 3));
+            previous = id;
+        }
+    }
+
+    size_t length = record.size() - HEADER_SIZE;
+    BinaryCodec::putU32(&record[0], (unsigned)length);
+    BinaryCodec::putU32(&record[4], BinaryCodec::crc32(record.data() + HEADER_SIZE, length));
+}
+
+bool SnapshotStore::writeRecord() {
+    bool ok = fwrite(record.data(), 1, record.size(), file) == record.size();
+    ok = fflush(file) == 0 && ok;
+    if (!ok) {
+        // Cut the torn record off again; replay would stop at it and drop
+        // every record appended after it. If that fails, stop appending.
+        fclose(file);
+        file = NULL;
+        unsynced = 0;
+        if (truncateFile(path, fileSize)) {
+            file = fopen(path.c_str(), "ab");
+        }
+        if (!file) {
+            std::cout << "[WARNING] Could not write " << path << ", snapshots are no longer persisted." << std::endl;
+        }
+        return false;
+    }
+    fileSize += (long)record.size();
+    // Handed to the OS now; forced to disk once per batch
+    if (++unsynced >= SYNC_BATCH) {
+        sync();
+    }
+    return true;
+}
+
+bool SnapshotStore::append(const std::string& state, const std::string& mode, const PowerSnapshot& snapshot) {
+    if (!file) {
+        return false;
+    }
+
+    // A delta while it stays smaller than the bitsets it replaces
+    PowerSnapshot::diff(lastWritten, snapshot, changes);
+    size_t words = snapshot.present.size();
+    bool keyframe = recordCount == 0 || sinceKeyframe >= KEYFRAME_INTERVAL ||
+                    changes.size() * sizeof(unsigned) >= words * 2 * sizeof(PowerSnapshot::Word);
+
+    encode(state, mode, TimestampFormatter::wallClockMicros(), snapshot, keyframe);
+    if (!writeRecord()) {
+        return false;
+    }
+    lastWritten = snapshot;
+    ++recordCount;
+    sinceKeyframe = keyframe ? 0 : sinceKeyframe + 1;
+    return true;
+}
+
+void SnapshotStore::sync() {
+    if (file) {
+        syncFile(file);
+        unsynced = 0;
+    }
+}
+
+bool SnapshotStore::rewrite(const StoredSnapshot& latest) {
+    // Write the compacted store next to the old one, then swap it in
+    std::string temporary = path + ".tmp";
+    FILE* out = fopen(temporary.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    bool ok = fwrite(MAGIC, 1, sizeof(MAGIC), out) == sizeof(MAGIC);
+    size_t records = 0;
+    if (ok && !latest.stateName.empty()) {
+        encode(latest.stateName, latest.modeName, latest.timestamp, latest.power, true);
+        ok = fwrite(record.data(), 1, record.size(), out) == record.size();
+        records = 1;
+    }
+    ok = syncFile(out) && ok;
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        // The old store stays as it is; its damaged tail is dropped again next time
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    // rename() replaces the old store in one step; Windows needs it gone first
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    recordCount = records;
+    sinceKeyframe = 0;
+    return true;
+}
+
+size_t SnapshotStore::getRecordCount() const {
+    return recordCount;
+}
+
+std::string SnapshotStore::getPath() const {
+    return path;
+}
@@ -1,19 +1,23 @@
 #include "SoundSystem.h"
+#include "DeviceStateTable.h"
+#include "OutputSink.h"
 #include <sstream>
 
 SoundSystem::SoundSystem(const std::string& brand, const std::string& model)
-    : Device(brand, model), volume(50), isMuted(false), currentSource("Bluetooth") {
+    : Device(brand, model), isMuted(false), currentSource("Bluetooth") {
+    setLevel(50);
 }
 
 SoundSystem::~SoundSystem() {}
 
 void SoundSystem::doPowerOn() {
-    std::cout << "  -> Sound System " << name << " ready. Source: " << currentSource 
-              << ", Volume: " << volume << "%" << std::endl;
+    OutputSink::out() << "  -> Sound System " << name << " ready. Source: " << currentSource 
+              << ", Volume: " << getLevel() << "%" << std::endl;
 }
 
 void SoundSystem::doPowerOff() {
-    std::cout << "  -> Sound System " << name << " turned off." << std::endl;
+    DeviceStateTable::getInstance()->setPlayingMusic(stateSlot, false);
+    OutputSink::out() << "  -> Sound System " << name << " turned off." << std::endl;
 }
 
 std::string SoundSystem::getDeviceType() const {
@@ -22,7 +26,7 @@ std::string SoundSystem::getDeviceType() const {
 
 std::string SoundSystem::getStatus() const {
     std::ostringstream oss;
-    oss << Device::getStatus() << " | Volume: " << volume << "%";
+    oss << Device::getStatus() << " | Volume: " << getLevel() << "%";
     oss << ", Muted: " << (isMuted ? "Yes" : "No");
     oss << ", Source: " << currentSource;
     return oss.str();
@@ -32,35 +36,33 @@ void SoundSystem::copyConfigurationFrom(const Device* other) {
     Device::copyConfigurationFrom(other);
     const SoundSystem* otherSS = dynamic_cast<const SoundSystem*>(other);
     if (otherSS) {
-        this->volume = otherSS->volume;
+        setLevel(otherSS->getLevel());
         this->currentSource = otherSS->currentSource;
     }
 }
 
 void SoundSystem::setVolume(int vol) {
-    if (vol < 0) vol = 0;
-    if (vol > 100) vol = 100;
-    volume = vol;
-    std::cout << "[INFO] " << name << " volume set to: " << volume << "%" << std::endl;
+    setLevel(vol);  // Clamped to 0-100
+    OutputSink::out() << "[INFO] " << name << " volume set to: " << getLevel() << "%" << std::endl;
 }
 
 void SoundSystem::mute() {
     isMuted = true;
-    std::cout << "[INFO] " << name << " muted." << std::endl;
+    OutputSink::out() << "[INFO] " << name << " muted." << std::endl;
 }
 
 void SoundSystem::unmute() {
     isMuted = false;
-    std::cout << "[INFO] " << name << " unmuted." << std::endl;
+    OutputSink::out() << "[INFO] " << name << " unmuted." << std::endl;
 }
 
 void SoundSystem::setSource(const std::string& source) {
     currentSource = source;
-    std::cout << "[INFO] " << name << " source changed to: " << currentSource << std::endl;
+    OutputSink::out() << "[INFO] " << name << " source changed to: " << currentSource << std::endl;
 }
 
 int SoundSystem::getVolume() const {
-    return volume;
+    return getLevel();
 }
 
 bool SoundSystem::getIsMuted() const {
@@ -72,19 +74,25 @@ std::string SoundSystem::getCurrentSource() const {
 }
 
 void SoundSystem::playMusic() {
-    if (powerState) {
-        std::cout << "[INFO] " << name << " playing music from " << currentSource << "..." << std::endl;
+    if (isPoweredOn()) {
+        DeviceStateTable::getInstance()->setPlayingMusic(stateSlot, true);
+        OutputSink::out() << "[INFO] " << name << " playing music from " << currentSource << "..." << std::endl;
     }
 }
 
 void SoundSystem::stopMusic() {
-    std::cout << "[INFO] " << name << " music stopped." << std::endl;
+    DeviceStateTable::getInstance()->setPlayingMusic(stateSlot, false);
+    OutputSink::out() << "[INFO] " << name << " music stopped." << std::endl;
+}
+
+bool SoundSystem::isPlayingMusic() const {
+    return DeviceStateTable::getInstance()->isPlayingMusic(stateSlot);
 }
 
 // Sonos Sound System
 SonosSoundSystem::SonosSoundSystem()
     : SoundSystem("Sonos", "Arc Soundbar") {
-    volume = 40;
+    setLevel(40);
 }
 
 SonosSoundSystem::~SonosSoundSystem() {}
@@ -95,10 +103,12 @@ Device* SonosSoundSystem::clone() const {
     return newSS;
 }
 
+MSH_DEFINE_POOLED_DEVICE(SonosSoundSystem)
+
 // Bose Sound System
 BoseSoundSystem::BoseSoundSystem()
     : SoundSystem("Bose", "Smart Soundbar 900") {
-    volume = 35;
+    setLevel(35);
 }
 
 BoseSoundSystem::~BoseSoundSystem() {}
@@ -108,3 +118,5 @@ Device* BoseSoundSystem::clone() const {
     newSS->copyConfigurationFrom(this);
     return newSS;
 }
+
+MSH_DEFINE_POOLED_DEVICE(BoseSoundSystem)
@@ -1,24 +1,154 @@
 #include "StateManager.h"
 #include "Device.h"
+#include "OutputSink.h"
+#include "SnapshotStore.h"
 #include <iostream>
-#include <ctime>
 #include <sstream>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+inline int lowestBit(PowerSnapshot::Word w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    while (!(w & 1)) {
+        w >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
 
-// HomeMemento Implementation
-HomeMemento::HomeMemento(const std::string& state, const std::string& mode)
-    : stateName(state), modeName(mode) {
-    // Generate timestamp
-    time_t now = time(0);
-    char* dt = ctime(&now);
-    timestamp = std::string(dt);
-    // Remove newline
-    if (!timestamp.empty() && timestamp[timestamp.length()-1] == '\n') {
-        timestamp.erase(timestamp.length()-1);
+inline PowerSnapshot::Word wordAt(const std::vector<PowerSnapshot::Word>& bits, size_t w) {
+    return w < bits.size() ? bits[w] : 0;
+}
+
+}
+
+// PowerSnapshot Implementation
+void PowerSnapshot::clear() {
+    present.clear();
+    power.clear();
+}
+
+void PowerSnapshot::set(int id, bool on) {
+    size_t w = id / WORD_BITS;
+    if (w >= present.size()) {
+        present.resize(w + 1, 0);
+        power.resize(w + 1, 0);
+    }
+    Word bit = (Word)1 << (id % WORD_BITS);
+    present[w] |= bit;
+    if (on) {
+        power[w] |= bit;
+    } else {
+        power[w] &= ~bit;
+    }
+}
+
+bool PowerSnapshot::contains(int id) const {
+    return id >= 0 && ((wordAt(present, id / WORD_BITS) >> (id % WORD_BITS)) & 1);
+}
+
+bool PowerSnapshot::isPowered(int id) const {
+    return id >= 0 && ((wordAt(power, id / WORD_BITS) >> (id % WORD_BITS)) & 1);
+}
+
+size_t PowerSnapshot::count() const {
+    size_t n = 0;
+    for (size_t w = 0; w < present.size(); ++w) {
+        for (Word bits = present[w]; bits; bits &= bits - 1) {
+            ++n;
+        }
     }
+    return n;
 }
 
-void HomeMemento::addDeviceState(const std::string& deviceName, bool powerState) {
-    devicePowerStates[deviceName] = powerState;
+void PowerSnapshot::diff(const PowerSnapshot& from, const PowerSnapshot& to, std::vector<unsigned>& changes) {
+    changes.clear();
+    size_t words = std::max(from.present.size(), to.present.size());
+    for (size_t w = 0; w < words; ++w) {
+        Word nowPresent = wordAt(to.present, w);
+        Word nowPower = wordAt(to.power, w);
+        Word changed = (nowPresent ^ wordAt(from.present, w)) |
+                       (nowPresent & (nowPower ^ wordAt(from.power, w)));
+        while (changed) {
+            int bit = lowestBit(changed);
+            changed &= changed - 1;
+            unsigned id = (unsigned)(w * WORD_BITS + bit);
+            changes.push_back((id << 2) | (unsigned)((nowPresent >> bit) & 1) << 1 |
+                              (unsigned)((nowPower >> bit) & 1));
+        }
+    }
+}
+
+void PowerSnapshot::apply(const std::vector<unsigned>& changes) {
+    for (size_t i = 0; i < changes.size(); ++i) {
+        int id = (int)(changes[i] >> 2);
+        if (changes[i] & 2) {
+            set(id, (changes[i] & 1) != 0);
+        } else if ((size_t)id / WORD_BITS < present.size()) {
+            // Device was removed
+            Word bit = (Word)1 << (id % WORD_BITS);
+            present[id / WORD_BITS] &= ~bit;
+            power[id / WORD_BITS] &= ~bit;
+        }
+    }
+}
+
+// HomeMemento Implementation
+HomeMemento::HomeMemento(const std::string& state, const std::string& mode) {
+    reset(state, mode);
+}
+
+void HomeMemento::reset(const std::string& state, const std::string& mode) {
+    // Shared formatter - snapshots within the same second reuse the cached text
+    static TimestampFormatter formatter;
+    stateName = state;
+    modeName = mode;
+    formatter.formatNow(timestamp);
+    keyframe = true;
+    full.clear();
+    changes.clear();
+}
+
+void HomeMemento::setKeyframe(const PowerSnapshot& snapshot) {
+    keyframe = true;
+    full = snapshot;
+    changes.clear();
+}
+
+void HomeMemento::setDelta(const std::vector<unsigned>& deltaChanges) {
+    keyframe = false;
+    changes = deltaChanges;
+    // Bitsets are the large part - don't keep them around in a delta slot
+    PowerSnapshot().present.swap(full.present);
+    PowerSnapshot().power.swap(full.power);
+}
+
+bool HomeMemento::isKeyframe() const {
+    return keyframe;
+}
+
+size_t HomeMemento::getChangeCount() const {
+    return keyframe ? full.count() : changes.size();
+}
+
+size_t HomeMemento::getMemoryUsage() const {
+    return sizeof(*this) + stateName.capacity() + modeName.capacity() +
+           (full.present.capacity() + full.power.capacity()) * sizeof(PowerSnapshot::Word) +
+           changes.capacity() * sizeof(unsigned);
+}
+
+void HomeMemento::applyTo(PowerSnapshot& snapshot) const {
+    if (keyframe) {
+        snapshot = full;
+    } else {
+        snapshot.apply(changes);
+    }
 }
 
 std::string HomeMemento::getStateName() const {
@@ -29,10 +159,6 @@ std::string HomeMemento::getModeName() const {
     return modeName;
 }
 
-std::map<std::string, bool> HomeMemento::getDevicePowerStates() const {
-    return devicePowerStates;
-}
-
 std::string HomeMemento::getTimestamp() const {
     return timestamp;
 }
@@ -68,9 +194,9 @@ NormalState::NormalState()
 }
 
 void NormalState::apply() {
-    std::cout << "[STATE] System running in Normal mode." << std::endl;
-    std::cout << "  - All devices operating normally" << std::endl;
-    std::cout << "  - Full functionality available" << std::endl;
+    OutputSink::out() << "[STATE] System running in Normal mode." << std::endl;
+    OutputSink::out() << "  - All devices operating normally" << std::endl;
+    OutputSink::out() << "  - Full functionality available" << std::endl;
 }
 
 // High Performance State
@@ -79,9 +205,9 @@ HighPerformanceState::HighPerformanceState()
 }
 
 void HighPerformanceState::apply() {
-    std::cout << "[STATE] System running in High Performance mode." << std::endl;
-    std::cout << "  - Faster response times" << std::endl;
-    std::cout << "  - Higher energy consumption" << std::endl;
+    OutputSink::out() << "[STATE] System running in High Performance mode." << std::endl;
+    OutputSink::out() << "  - Faster response times" << std::endl;
+    OutputSink::out() << "  - Higher energy consumption" << std::endl;
 }
 
 // Low Power State
@@ -90,9 +216,9 @@ LowPowerState::LowPowerState()
 }
 
 void LowPowerState::apply() {
-    std::cout << "[STATE] System running in Low Power mode." << std::endl;
-    std::cout << "  - Reduced energy consumption" << std::endl;
-    std::cout << "  - Non-essential devices may be limited" << std::endl;
+    OutputSink::out() << "[STATE] System running in Low Power mode." << std::endl;
+    OutputSink::out() << "  - Reduced energy consumption" << std::endl;
+    OutputSink::out() << "  - Non-essential devices may be limited" << std::endl;
 }
 
 // Sleep State
@@ -101,13 +227,23 @@ SleepState::SleepState()
 }
 
 void SleepState::apply() {
-    std::cout << "[STATE] System running in Sleep mode." << std::endl;
-    std::cout << "  - Only security and detection systems active" << std::endl;
-    std::cout << "  - Minimal energy consumption" << std::endl;
+    OutputSink::out() << "[STATE] System running in Sleep mode." << std::endl;
+    OutputSink::out() << "  - Only security and detection systems active" << std::endl;
+    OutputSink::out() << "  - Minimal energy consumption" << std::endl;
 }
 
 // StateManager Implementation
-StateManager::StateManager() : currentHistoryIndex(-1) {
+StateManager::StateManager(size_t historyCapacity)
+    : capacity(historyCapacity), head(0), historyCount(0), currentHistoryIndex(-1), sinceKeyframe(0),
+      store(NULL) {
+    if (capacity == 0) {
+        const char* env = std::getenv("MSH_HISTORY");
+        long fromEnv = env ? std::atol(env) : 0;
+        capacity = fromEnv > 0 ? (size_t)fromEnv : DEFAULT_HISTORY;
+    }
+    // Storage for every slot is reserved up front; mementos are constructed on first use
+    slots.reserve(capacity);
+
     normalState = new NormalState();
     highPerfState = new HighPerformanceState();
     lowPowerState = new LowPowerState();
@@ -122,11 +258,7 @@ StateManager::~StateManager() {
     delete highPerfState;
     delete lowPowerState;
     delete sleepState;
-    
-    for (size_t i = 0; i < stateHistory.size(); ++i) {
-        delete stateHistory[i];
-    }
-    stateHistory.clear();
+    delete store;
 }
 
 void StateManager::setState(char stateChar) {
@@ -134,22 +266,22 @@ void StateManager::setState(char stateChar) {
         case 'N':
         case 'n':
             currentState = normalState;
-            std::cout << "[INFO] System state changed to Normal." << std::endl;
+            OutputSink::out() << "[INFO] System state changed to Normal." << std::endl;
             break;
         case 'H':
         case 'h':
             currentState = highPerfState;
-            std::cout << "[INFO] System state changed to High Performance." << std::endl;
+            OutputSink::out() << "[INFO] System state changed to High Performance." << std::endl;
             break;
         case 'L':
         case 'l':
             currentState = lowPowerState;
-            std::cout << "[INFO] System state changed to Low Power." << std::endl;
+            OutputSink::out() << "[INFO] System state changed to Low Power." << std::endl;
             break;
         case 'S':
         case 's':
             currentState = sleepState;
-            std::cout << "[INFO] System state changed to Sleep." << std::endl;
+            OutputSink::out() << "[INFO] System state changed to Sleep." << std::endl;
             break;
         case 'P':
         case 'p':
@@ -162,6 +294,17 @@ void StateManager::setState(char stateChar) {
     applyState();
 }
 
+bool StateManager::setStateByName(const std::string& name) {
+    SystemState* state = findState(name);
+    if (!state) {
+        return false;
+    }
+    currentState = state;
+    OutputSink::out() << "[INFO] System state changed to " << name << "." << std::endl;
+    applyState();
+    return true;
+}
+
 void StateManager::applyState() {
     if (currentState) {
         currentState->apply();
@@ -176,39 +319,150 @@ std::string StateManager::getCurrentStateName() const {
     return currentState ? currentState->getName() : "Unknown";
 }
 
+HomeMemento& StateManager::entry(int index) {
+    return slots[(head + index) % capacity];
+}
+
+const HomeMemento& StateManager::entry(int index) const {
+    return slots[(head + index) % capacity];
+}
+
 void StateManager::saveState(const std::string& modeName, const std::vector<Device*>& allDevices) {
-    // Remove any future states if we're not at the end
-    while (currentHistoryIndex < (int)stateHistory.size() - 1) {
-        delete stateHistory.back();
-        stateHistory.pop_back();
+    // Drop any future states if we're not at the end (their slots get reused)
+    if (currentHistoryIndex < historyCount - 1) {
+        historyCount = currentHistoryIndex + 1;
+        rebuildLatest();
     }
     
-    // Create new memento
-    HomeMemento* memento = new HomeMemento(getCurrentStateName(), modeName);
+    packDevices(allDevices, current);
+
+    // Devices that appeared, disappeared or flipped since the newest memento
+    PowerSnapshot::diff(latest, current, delta);
+    size_t words = std::max(current.present.size(), latest.present.size());
     
-    // Save all device states
-    for (size_t i = 0; i < allDevices.size(); ++i) {
-        memento->addDeviceState(allDevices[i]->getName(), allDevices[i]->isPoweredOn());
+    // Full ring: drop the oldest entry, after making sure the new oldest
+    // one does not depend on it
+    if (historyCount == (int)capacity) {
+        if (historyCount > 1 && !entry(1).isKeyframe()) {
+            PowerSnapshot base;
+            getSnapshot(1, base);
+            entry(1).setKeyframe(base);
+        }
+        head = (head + 1) % capacity;
+        --historyCount;
     }
-    
-    // Limit history size
-    if (stateHistory.size() >= MAX_HISTORY) {
-        delete stateHistory[0];
-        stateHistory.erase(stateHistory.begin());
+
+    // Fill the next slot - a delta while it stays smaller than the bitsets it replaces
+    size_t physical = (head + historyCount) % capacity;
+    if (physical == slots.size()) {
+        slots.push_back(HomeMemento(getCurrentStateName(), modeName));
+    } else {
+        slots[physical].reset(getCurrentStateName(), modeName);
+    }
+    HomeMemento& memento = slots[physical];
+    if (historyCount == 0 || sinceKeyframe >= KEYFRAME_INTERVAL ||
+        delta.size() * sizeof(unsigned) >= words * 2 * sizeof(PowerSnapshot::Word)) {
+        memento.setKeyframe(current);
+        sinceKeyframe = 0;
+    } else {
+        memento.setDelta(delta);
+        ++sinceKeyframe;
+    }
+    latest.present.swap(current.present);
+    latest.power.swap(current.power);
+    if (store) {
+        store->append(getCurrentStateName(), modeName, latest);
     }
     
-    stateHistory.push_back(memento);
-    currentHistoryIndex = stateHistory.size() - 1;
+    ++historyCount;
+    currentHistoryIndex = historyCount - 1;
     
-    std::cout << "[INFO] State saved to history. Total states: " << stateHistory.size() << std::endl;
+    OutputSink::out() << "[INFO] State saved to history. Total states: " << historyCount << std::endl;
+}
+
+void StateManager::packDevices(const std::vector<Device*>& allDevices, PowerSnapshot& snapshot) const {
+    snapshot.clear();
+    for (size_t i = 0; i < allDevices.size(); ++i) {
+        int id = allDevices[i]->getDeviceId();
+        if (id >= 0) {
+            snapshot.set(id, allDevices[i]->isPoweredOn());
+        }
+    }
+}
+
+void StateManager::rebuildLatest() {
+    latest.clear();
+    sinceKeyframe = 0;
+    if (historyCount == 0) {
+        return;
+    }
+    int last = historyCount - 1;
+    getSnapshot(last, latest);
+    for (int i = last; i > 0 && !entry(i).isKeyframe(); --i) {
+        ++sinceKeyframe;
+    }
+}
+
+bool StateManager::getSnapshot(int index, PowerSnapshot& snapshot) const {
+    if (index < 0 || index >= historyCount) {
+        return false;
+    }
+    // The oldest entry is always a keyframe
+    int start = index;
+    while (start > 0 && !entry(start).isKeyframe()) {
+        --start;
+    }
+    snapshot.clear();
+    for (int i = start; i <= index; ++i) {
+        entry(i).applyTo(snapshot);
+    }
+    return true;
+}
+
+bool StateManager::openStore(const std::string& path, StoredSnapshot& resumed, bool& found) {
+    if (!store) {
+        store = new SnapshotStore();
+    }
+    if (!store->open(path, resumed, found)) {
+        std::cout << "[WARNING] Snapshot store " << path << " could not be opened; history will not persist." << std::endl;
+        delete store;
+        store = NULL;
+        return false;
+    }
+    return true;
+}
+
+void StateManager::persistState(const std::string& modeName, const std::vector<Device*>& allDevices) {
+    if (store) {
+        packDevices(allDevices, current);
+        store->append(getCurrentStateName(), modeName, current);
+    }
+}
+
+void StateManager::syncStore() {
+    if (store) {
+        store->sync();
+    }
+}
+
+size_t StateManager::getHistoryMemoryUsage() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        bytes += slots[i].getMemoryUsage();
+    }
+    return bytes;
 }
 
 bool StateManager::restorePreviousState() {
     if (currentHistoryIndex > 0) {
         currentHistoryIndex--;
-        HomeMemento* memento = stateHistory[currentHistoryIndex];
-        std::cout << "[INFO] Restoring previous state..." << std::endl;
-        memento->display();
+        OutputSink::out() << "[INFO] Restoring previous state..." << std::endl;
+        entry(currentHistoryIndex).display();
+        SystemState* restored = findState(entry(currentHistoryIndex).getStateName());
+        if (restored) {
+            currentState = restored;
+            applyState();
+        }
         return true;
     } else {
         std::cout << "[WARNING] No previous state available." << std::endl;
@@ -217,11 +471,15 @@ bool StateManager::restorePreviousState() {
 }
 
 bool StateManager::restoreNextState() {
-    if (currentHistoryIndex < (int)stateHistory.size() - 1) {
+    if (currentHistoryIndex < historyCount - 1) {
         currentHistoryIndex++;
-        HomeMemento* memento = stateHistory[currentHistoryIndex];
-        std::cout << "[INFO] Restoring next state..." << std::endl;
-        memento->display();
+        OutputSink::out() << "[INFO] Restoring next state..." << std::endl;
+        entry(currentHistoryIndex).display();
+        SystemState* restored = findState(entry(currentHistoryIndex).getStateName());
+        if (restored) {
+            currentState = restored;
+            applyState();
+        }
         return true;
     } else {
         std::cout << "[WARNING] No next state available." << std::endl;
@@ -229,18 +487,43 @@ bool StateManager::restoreNextState() {
     }
 }
 
+int StateManager::getCurrentHistoryIndex() const {
+    return currentHistoryIndex;
+}
+
+const HomeMemento* StateManager::getMemento(int index) const {
+    if (index < 0 || index >= historyCount) {
+        return NULL;
+    }
+    return &entry(index);
+}
+
+SystemState* StateManager::findState(const std::string& name) const {
+    SystemState* states[] = { normalState, highPerfState, lowPowerState, sleepState };
+    for (size_t i = 0; i < sizeof(states) / sizeof(states[0]); ++i) {
+        if (states[i]->getName() == name) {
+            return states[i];
+        }
+    }
+    return NULL;
+}
+
 void StateManager::displayHistory() const {
     std::cout << "=== State History ===" << std::endl;
-    for (size_t i = 0; i < stateHistory.size(); ++i) {
-        std::cout << (i == (size_t)currentHistoryIndex ? " -> " : "    ");
+    for (int i = 0; i < historyCount; ++i) {
+        std::cout << (i == currentHistoryIndex ? " -> " : "    ");
         std::cout << "[" << i + 1 << "] ";
-        stateHistory[i]->display();
+        entry(i).display();
     }
-    std::cout << "Total: " << stateHistory.size() << " states" << std::endl;
+    std::cout << "Total: " << historyCount << " states" << std::endl;
 }
 
 int StateManager::getHistorySize() const {
-    return stateHistory.size();
+    return historyCount;
+}
+
+size_t StateManager::getHistoryCapacity() const {
+    return capacity;
 }
 
 void StateManager::displayCurrentState() const {
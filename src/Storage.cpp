@@ -1,11 +1,19 @@
 #include "Storage.h"
+#include "LogRingBuffer.h"
 #include <iostream>
-#include <ctime>
+#include <cstdio>
+#include <chrono>
 
 // Initialize static instance pointer
 Storage* Storage::instance = NULL;
 
-Storage::Storage() : isOpen(false) {}
+Storage::Storage()
+    : isOpen(false), eventLogEnabled(true),
+      rotationMaxBytes(0), rotationMaxAgeSeconds(0), rotationMaxSegments(10), rotationCompress(true),
+      segmentBytes(0), segmentOpenedAt(0), segmentFirstTime(0), segmentLastTime(0),
+      asyncMode(false), asyncBatchSize(256), asyncFlushIntervalMs(50), asyncQueueCapacity(8192),
+      ringBuffer(NULL), writerRunning(false), stopRequested(false), flushRequested(false),
+      enqueuedCount(0), writtenCount(0) {}
 
 Storage* Storage::getInstance() {
     if (instance == NULL) {
@@ -18,15 +26,14 @@ Storage::~Storage() {
     closeFile();
 }
 
-std::string Storage::getCurrentTimestamp() const {
-    time_t now = time(0);
-    char* dt = ctime(&now);
-    std::string timestamp(dt);
-    // Remove newline
-    if (!timestamp.empty() && timestamp[timestamp.length()-1] == '\n') {
-        timestamp.erase(timestamp.length()-1);
-    }
-    return timestamp;
+void Storage::appendLine(std::string& out, long long when, const std::string& message) {
+    char stamp[TimestampFormatter::BUFFER_SIZE];
+    size_t length = timestampFormatter.format(when, stamp);
+    out += '[';
+    out.append(stamp, length);
+    out += "] ";
+    out += message;
+    out += '\n';
 }
 
 bool Storage::openFile(const std::string& fname) {
@@ -39,6 +46,24 @@ bool Storage::openFile(const std::string& fname) {
     
     if (logFile.is_open()) {
         isOpen = true;
+
+        // Appending to an existing file continues its current segment
+        logFile.seekp(0, std::ios::end);
+        std::streamoff existing = logFile.tellp();
+        segmentBytes = existing > 0 ? (size_t)existing : 0;
+        segmentOpenedAt = segmentFirstTime = segmentLastTime = timestampFormatter.now();
+        // The rotator is stopped while no file is open, so its policy can change here
+        rotator.setPolicy(rotationMaxBytes, rotationMaxAgeSeconds, rotationMaxSegments, rotationCompress);
+        if (rotator.isEnabled()) {
+            rotator.start(filename);
+        }
+
+        if (eventLogEnabled) {
+            eventLog.open(eventLogFilename(filename), timestampFormatter.now());
+        }
+        if (asyncMode) {
+            startWriter();
+        }
         log("========================================");
         log("Log file opened: " + filename);
         return true;
@@ -52,7 +77,11 @@ void Storage::closeFile() {
     if (isOpen) {
         log("Log file closed.");
         log("========================================");
+        // Drain queued records before the stream goes away
+        stopWriter();
         logFile.close();
+        eventLog.close();
+        rotator.stop();
         isOpen = false;
     }
 }
@@ -61,10 +90,227 @@ bool Storage::isFileOpen() const {
     return isOpen;
 }
 
-void Storage::log(const std::string& message) {
+void Storage::setTimestampFormat(TimestampFormatter::Format format) {
+    // The formatter belongs to the writer thread while it runs
+    bool restart = writerRunning;
+    if (restart) {
+        stopWriter();
+    }
+    timestampFormatter.setFormat(format);
+    if (restart) {
+        startWriter();
+    }
+}
+
+TimestampFormatter::Format Storage::getTimestampFormat() const {
+    return timestampFormatter.getFormat();
+}
+
+void Storage::setEventLogEnabled(bool enabled) {
+    eventLogEnabled = enabled;
+}
+
+bool Storage::isEventLogEnabled() const {
+    return eventLogEnabled;
+}
+
+void Storage::setRotationPolicy(size_t maxBytes, int maxAgeSeconds, int maxSegments, bool compress) {
+    rotationMaxBytes = maxBytes;
+    rotationMaxAgeSeconds = maxAgeSeconds;
+    rotationMaxSegments = maxSegments;
+    rotationCompress = compress;
+}
+
+void Storage::noteWritten(size_t bytes, long long firstTime, long long lastTime) {
+    if (segmentBytes == 0) {
+        segmentFirstTime = firstTime;
+    }
+    segmentBytes += bytes;
+    segmentLastTime = lastTime;
+}
+
+void Storage::rotateIfNeeded(long long now) {
+    if (!rotator.isEnabled() || !rotator.shouldRotate(segmentBytes, segmentOpenedAt, now)) {
+        return;
+    }
+
+    // Only close/rename/reopen here - compression and pruning happen on the rotator thread
+    logFile.close();
+    std::string segmentPath = rotator.nextSegmentPath();
+    std::remove(segmentPath.c_str());
+    bool renamed = std::rename(filename.c_str(), segmentPath.c_str()) == 0;
+    logFile.open(filename.c_str(), std::ios::out | std::ios::app);
+
+    if (renamed) {
+        rotator.segmentClosed(segmentPath, segmentFirstTime, segmentLastTime);
+    }
+    segmentBytes = 0;
+    segmentOpenedAt = segmentFirstTime = segmentLastTime = now;
+}
+
+std::string Storage::eventLogFilename(const std::string& logFilename) {
+    // "msh_log.txt" -> "msh_log.bin"
+    std::string::size_type dot = logFilename.find_last_of('.');
+    std::string::size_type slash = logFilename.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        return logFilename.substr(0, dot) + ".bin";
+    }
+    return logFilename + ".bin";
+}
+
+void Storage::enableAsync(size_t batchSize, int flushIntervalMs, size_t queueCapacity) {
+    if (writerRunning) {
+        stopWriter();
+    }
+    asyncBatchSize = batchSize > 0 ? batchSize : 1;
+    asyncFlushIntervalMs = flushIntervalMs > 0 ? flushIntervalMs : 1;
+    asyncQueueCapacity = queueCapacity > 0 ? queueCapacity : 1;
+    asyncMode = true;
     if (isOpen) {
-        logFile << "[" << getCurrentTimestamp() << "] " << message << std::endl;
+        startWriter();
+    }
+}
+
+void Storage::disableAsync() {
+    stopWriter();
+    asyncMode = false;
+}
+
+bool Storage::isAsync() const {
+    return asyncMode;
+}
+
+void Storage::startWriter() {
+    if (writerRunning) {
+        return;
+    }
+    ringBuffer = new LogRingBuffer(asyncQueueCapacity);
+    stopRequested = false;
+    flushRequested = false;
+    enqueuedCount = 0;
+    writtenCount = 0;
+    writerRunning = true;
+    writerThread = std::thread(&Storage::writerLoop, this);
+}
+
+void Storage::stopWriter() {
+    if (!writerRunning) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        stopRequested = true;
+    }
+    writerWakeup.notify_one();
+    writerThread.join();
+    writerRunning = false;
+
+    delete ringBuffer;
+    ringBuffer = NULL;
+}
+
+void Storage::writerLoop() {
+    LogRecord record;
+    std::string batch;
+    batch.reserve(64 * 1024);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(writerMutex);
+            writerWakeup.wait_for(lock, std::chrono::milliseconds(asyncFlushIntervalMs), [this]() {
+                return stopRequested.load() || flushRequested.load() ||
+                       enqueuedCount.load() - writtenCount.load() >= asyncBatchSize;
+            });
+        }
+
+        // Group commit: one write + flush per batch instead of per line
+        bool drainedAny = false;
+        for (;;) {
+            size_t drained = 0;
+            long long batchFirst = 0;
+            while (drained < asyncBatchSize && ringBuffer->tryPop(record)) {
+                if (drained == 0) {
+                    batchFirst = record.timestamp;
+                }
+                appendLine(batch, record.timestamp, record.message);
+                ++drained;
+            }
+            if (drained == 0) {
+                break;
+            }
+            logFile.write(batch.data(), batch.size());
+            logFile.flush();
+            noteWritten(batch.size(), batchFirst, record.timestamp);
+            rotateIfNeeded(record.timestamp);
+            batch.clear();
+            drainedAny = true;
+
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writtenCount.fetch_add(drained);
+        }
+
+        if (drainedAny || flushRequested) {
+            {
+                std::lock_guard<std::mutex> lock(writerMutex);
+                flushRequested = false;
+            }
+            flushDone.notify_all();
+        }
+
+        if (stopRequested && enqueuedCount.load() == writtenCount.load()) {
+            break;
+        }
+        // Age-based rotation also applies while the log is idle
+        rotateIfNeeded(timestampFormatter.now());
+    }
+}
+
+void Storage::enqueue(long long when, const std::string& message) {
+    // Bounded queue: back off until the writer frees a slot rather than dropping lines
+    while (!ringBuffer->tryPush(when, message)) {
+        writerWakeup.notify_one();
+        std::this_thread::yield();
+    }
+    size_t pending = enqueuedCount.fetch_add(1) + 1 - writtenCount.load();
+    if (pending == asyncBatchSize) {
+        writerWakeup.notify_one();
+    }
+}
+
+void Storage::flush() {
+    if (!isOpen) {
+        return;
+    }
+    eventLog.flush();
+    if (!writerRunning) {
         logFile.flush();
+        return;
+    }
+
+    size_t target = enqueuedCount.load();
+    std::unique_lock<std::mutex> lock(writerMutex);
+    flushRequested = true;
+    writerWakeup.notify_one();
+    flushDone.wait(lock, [this, target]() {
+        return writtenCount.load() >= target;
+    });
+}
+
+void Storage::log(const std::string& message) {
+    if (isOpen) {
+        if (writerRunning) {
+            enqueue(timestampFormatter.now(), message);
+            return;
+        }
+        long long when = timestampFormatter.now();
+        char stamp[TimestampFormatter::BUFFER_SIZE];
+        size_t length = timestampFormatter.format(when, stamp);
+        logFile << '[';
+        logFile.write(stamp, length);
+        logFile << "] " << message << std::endl;
+
+        noteWritten(length + message.size() + 4, when, when);
+        rotateIfNeeded(when);
     }
 }
 
@@ -82,6 +328,8 @@ void Storage::logError(const std::string& message) {
 
 void Storage::logAlert(const std::string& message) {
     log("[ALERT] " + message);
+    // Alerts must be on disk before we return
+    flush();
 }
 
 void Storage::logMenuSelection(int option) {
@@ -90,18 +338,22 @@ void Storage::logMenuSelection(int option) {
     sprintf(buffer, "%d", option);
     optStr = buffer;
     logInfo("Menu option selected: " + optStr);
+    eventLog.recordMenuSelection(timestampFormatter.now(), option);
 }
 
 void Storage::logDeviceOperation(const std::string& deviceName, const std::string& operation) {
     logInfo("Device '" + deviceName + "': " + operation);
+    eventLog.recordDeviceOperation(timestampFormatter.now(), deviceName, operation);
 }
 
 void Storage::logModeChange(const std::string& fromMode, const std::string& toMode) {
     logInfo("Mode changed: " + fromMode + " -> " + toMode);
+    eventLog.recordModeChange(timestampFormatter.now(), fromMode, toMode);
 }
 
 void Storage::logStateChange(const std::string& fromState, const std::string& toState) {
     logInfo("State changed: " + fromState + " -> " + toState);
+    eventLog.recordStateChange(timestampFormatter.now(), fromState, toState);
 }
 
 void Storage::logSystemStart() {
@@ -118,6 +370,7 @@ void Storage::logSystemShutdown() {
     log("#      MY SWEET HOME SYSTEM SHUTDOWN      #");
     log("############################################");
     log("");
+    flush();
 }
 
 std::string Storage::getFilename() const {
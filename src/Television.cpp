@@ -1,20 +1,22 @@
 #include "Television.h"
+#include "OutputSink.h"
 #include <sstream>
 
 // Base Television implementation
 Television::Television(const std::string& brand, const std::string& model)
-    : Device(brand, model), screenSize(55), resolution("4K"), volume(30), channel(1), smartTV(true) {
+    : Device(brand, model), screenSize(55), resolution("4K"), channel(1), smartTV(true) {
+    setLevel(30);
 }
 
 Television::~Television() {}
 
 void Television::doPowerOn() {
-    std::cout << "  -> TV " << name << " displaying on channel " << channel 
-              << " at volume " << volume << std::endl;
+    OutputSink::out() << "  -> TV " << name << " displaying on channel " << channel 
+              << " at volume " << getLevel() << std::endl;
 }
 
 void Television::doPowerOff() {
-    std::cout << "  -> TV " << name << " display off." << std::endl;
+    OutputSink::out() << "  -> TV " << name << " display off." << std::endl;
 }
 
 std::string Television::getDeviceType() const {
@@ -24,7 +26,7 @@ std::string Television::getDeviceType() const {
 std::string Television::getStatus() const {
     std::ostringstream oss;
     oss << Device::getStatus() << " | Size: " << screenSize << "\", Resolution: " << resolution;
-    oss << ", Volume: " << volume << ", Channel: " << channel;
+    oss << ", Volume: " << getLevel() << ", Channel: " << channel;
     oss << ", Smart TV: " << (smartTV ? "Yes" : "No");
     return oss.str();
 }
@@ -33,26 +35,24 @@ void Television::copyConfigurationFrom(const Device* other) {
     Device::copyConfigurationFrom(other);
     const Television* otherTV = dynamic_cast<const Television*>(other);
     if (otherTV) {
-        this->volume = otherTV->volume;
+        setLevel(otherTV->getLevel());
         this->channel = otherTV->channel;
     }
 }
 
 void Television::setVolume(int vol) {
-    if (vol < 0) vol = 0;
-    if (vol > 100) vol = 100;
-    volume = vol;
-    std::cout << "[INFO] " << name << " volume set to: " << volume << std::endl;
+    setLevel(vol);  // Clamped to 0-100
+    OutputSink::out() << "[INFO] " << name << " volume set to: " << getLevel() << std::endl;
 }
 
 void Television::setChannel(int ch) {
     if (ch < 1) ch = 1;
     channel = ch;
-    std::cout << "[INFO] " << name << " channel set to: " << channel << std::endl;
+    OutputSink::out() << "[INFO] " << name << " channel set to: " << channel << std::endl;
 }
 
 int Television::getVolume() const {
-    return volume;
+    return getLevel();
 }
 
 int Television::getChannel() const {
@@ -87,6 +87,8 @@ Device* SamsungTV::clone() const {
     return newTV;
 }
 
+MSH_DEFINE_POOLED_DEVICE(SamsungTV)
+
 // LG TV
 LGTV::LGTV()
     : Television("LG", "OLED C3") {
@@ -102,3 +104,5 @@ Device* LGTV::clone() const {
     newTV->copyConfigurationFrom(this);
     return newTV;
 }
+
+MSH_DEFINE_POOLED_DEVICE(LGTV)
@@ -0,0 +1,88 @@
+#include "TimestampFormatter.h"
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+
+TimestampFormatter::TimestampFormatter(Format fmt)
+    : activeFormat(fmt), cachedSecond(-1), cachedLength(0) {
+    cachedPrefix[0] = '\0';
+}
+
+void TimestampFormatter::setFormat(Format fmt) {
+    if (fmt != activeFormat) {
+        activeFormat = fmt;
+        cachedSecond = -1;  // Invalidate cache
+    }
+}
+
+TimestampFormatter::Format TimestampFormatter::getFormat() const {
+    return activeFormat;
+}
+
+long long TimestampFormatter::wallClockMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+long long TimestampFormatter::monotonicMicros() {
+    // Anchor once, then only advance with the steady clock
+    static const long long wallAnchor = wallClockMicros();
+    static const std::chrono::steady_clock::time_point steadyAnchor = std::chrono::steady_clock::now();
+    return wallAnchor + std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - steadyAnchor).count();
+}
+
+long long TimestampFormatter::now() const {
+    return activeFormat == FORMAT_ISO8601_MICROS ? monotonicMicros() : wallClockMicros();
+}
+
+void TimestampFormatter::refreshPrefix(time_t second) {
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &second);
+#else
+    localtime_r(&second, &local);
+#endif
+
+    if (activeFormat == FORMAT_ISO8601_MICROS) {
+        cachedLength = strftime(cachedPrefix, BUFFER_SIZE, "%Y-%m-%dT%H:%M:%S", &local);
+    } else {
+        // Same layout as ctime() without the trailing newline
+        static const char* const days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+        static const char* const months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+        int written = snprintf(cachedPrefix, BUFFER_SIZE, "%s %s %2d %02d:%02d:%02d %d",
+                               days[local.tm_wday], months[local.tm_mon], local.tm_mday,
+                               local.tm_hour, local.tm_min, local.tm_sec, local.tm_year + 1900);
+        cachedLength = written > 0 ? (size_t)written : 0;
+    }
+    cachedSecond = second;
+}
+
+size_t TimestampFormatter::format(long long micros, char* buffer) {
+    time_t second = (time_t)(micros / 1000000);
+    if (second != cachedSecond) {
+        refreshPrefix(second);
+    }
+
+    memcpy(buffer, cachedPrefix, cachedLength);
+    size_t length = cachedLength;
+
+    if (activeFormat == FORMAT_ISO8601_MICROS) {
+        // Append ".uuuuuu" by hand - cheaper than another snprintf
+        int fraction = (int)(micros % 1000000);
+        buffer[length++] = '.';
+        for (int i = 5; i >= 0; --i) {
+            buffer[length + i] = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        length += 6;
+    }
+
+    buffer[length] = '\0';
+    return length;
+}
+
+size_t TimestampFormatter::formatNow(char* buffer) {
+    return format(now(), buffer);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file msh_eventdump.cpp
+ * @brief Offline decoder for the binary event log written by Storage
+ *
+ * Converts msh_log.bin back into the msh_log.txt line format.
+ *
+ * Usage: msh-eventdump [--iso] [--stats] <file.bin>
+ */
+
+#include "EventLog.h"
+#include "TimestampFormatter.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+static void printUsage() {
+    std::cerr << "Usage: msh-eventdump [--iso] [--stats] <file.bin>" << std::endl;
+    std::cerr << "  --iso    print ISO-8601 timestamps with microseconds" << std::endl;
+    std::cerr << "  --stats  print event counts and bytes/event instead of the records" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    bool iso = false;
+    bool statsOnly = false;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--iso") == 0) {
+            iso = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            statsOnly = true;
+        } else if (argv[i][0] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        printUsage();
+        return 2;
+    }
+
+    EventLogReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "[ERROR] " << reader.getError() << std::endl;
+        return 1;
+    }
+
+    TimestampFormatter formatter(iso ? TimestampFormatter::FORMAT_ISO8601_MICROS
+                                     : TimestampFormatter::FORMAT_CTIME);
+    char stamp[TimestampFormatter::BUFFER_SIZE];
+    unsigned long counts[EventLog::EVENT_STATE_CHANGE + 1] = { 0 };
+    unsigned long total = 0;
+    unsigned long long textBytes = 0;
+
+    DecodedEvent event;
+    while (reader.next(event)) {
+        ++total;
+        if (event.type <= EventLog::EVENT_STATE_CHANGE) {
+            ++counts[event.type];
+        }
+
+        formatter.format(event.timestamp, stamp);
+        std::string text = event.toText();
+        // "[" + stamp + "] " + text + "\n"
+        textBytes += strlen(stamp) + text.size() + 4;
+
+        if (!statsOnly) {
+            std::cout << '[' << stamp << "] " << text << '\n';
+        }
+    }
+
+    if (!reader.getError().empty()) {
+        std::cerr << "[WARNING] Stopped early: " << reader.getError() << std::endl;
+    }
+
+    if (statsOnly) {
+        std::printf("Events:            %lu\n", total);
+        std::printf("  Menu selections: %lu\n", counts[EventLog::EVENT_MENU_SELECTION]);
+        std::printf("  Device ops:      %lu\n", counts[EventLog::EVENT_DEVICE_OPERATION]);
+        std::printf("  Mode changes:    %lu\n", counts[EventLog::EVENT_MODE_CHANGE]);
+        std::printf("  State changes:   %lu\n", counts[EventLog::EVENT_STATE_CHANGE]);
+        if (total > 0) {
+            std::printf("Binary bytes/event: %.1f\n", (double)reader.getFileSize() / total);
+            std::printf("Text bytes/event:   %.1f\n", (double)textBytes / total);
+        }
+    }
+    return reader.getError().empty() ? 0 : 1;
+}
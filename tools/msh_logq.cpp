@@ -0,0 +1,119 @@
+/**
+ * @file msh_logq.cpp
+ * @brief Query tool for msh_log.txt files written by Storage
+ *
+ * Memory-maps each log, binary-searches the time range and scans it for
+ * the requested level / device / text.
+ *
+ * Usage: msh-logq [options] <msh_log.txt>...
+ *   --from TIME     first timestamp (inclusive)
+ *   --to TIME       last timestamp (inclusive)
+ *   --level LEVEL   INFO, WARNING, ERROR or ALERT
+ *   --device NAME   operations on one device
+ *   --grep TEXT     free substring
+ *   --count         print only the number of matching lines
+ *   --segments      also search rotated segments listed in the log's
+ *                   manifest that overlap the time range (oldest first)
+ *
+ * TIME is "2025-11-25 21:33:31", "2025-11-25T21:33:31" or the
+ * log's own "Tue Nov 25 21:33:31 2025" format.
+ */
+
+#include "LogReader.h"
+#include "LogRotator.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class StdoutSink : public LogLineSink {
+public:
+    virtual void onLine(const char* line, size_t length) {
+        fwrite(line, 1, length, stdout);
+        fputc('\n', stdout);
+    }
+};
+
+static void printUsage() {
+    std::cerr << "Usage: msh-logq [--from TIME] [--to TIME] [--level LEVEL] [--device NAME]" << std::endl;
+    std::cerr << "                [--grep TEXT] [--count] [--segments] <msh_log.txt>..." << std::endl;
+    std::cerr << "  TIME: \"2025-11-25 21:33:31\" or \"Tue Nov 25 21:33:31 2025\"" << std::endl;
+}
+
+static bool parseTimeArg(const char* arg, long long& out) {
+    out = LogReader::parseTime(arg, strlen(arg));
+    if (out == LogReader::NO_TIME) {
+        std::cerr << "[ERROR] Invalid time: " << arg << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    LogQuery query;
+    bool countOnly = false;
+    bool withSegments = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--from" && hasValue) {
+            if (!parseTimeArg(argv[++i], query.fromTime)) return 2;
+        } else if (arg == "--to" && hasValue) {
+            if (!parseTimeArg(argv[++i], query.toTime)) return 2;
+        } else if (arg == "--level" && hasValue) {
+            query.level = argv[++i];
+        } else if (arg == "--device" && hasValue) {
+            query.device = argv[++i];
+        } else if (arg == "--grep" && hasValue) {
+            query.text = argv[++i];
+        } else if (arg == "--count") {
+            countOnly = true;
+        } else if (arg == "--segments") {
+            withSegments = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    if (withSegments) {
+        // Closed segments first so output stays in time order
+        std::vector<std::string> expanded;
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::vector<LogSegment> segments;
+            LogManifest::load(LogManifest::manifestPath(files[i]), segments);
+            std::vector<LogSegment> overlapping =
+                LogManifest::findSegments(segments, query.fromTime, query.toTime);
+            for (size_t j = 0; j < overlapping.size(); ++j) {
+                expanded.push_back(overlapping[j].path);
+            }
+            expanded.push_back(files[i]);
+        }
+        files.swap(expanded);
+    }
+
+    StdoutSink sink;
+    size_t total = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        LogReader reader;
+        if (!reader.open(files[i])) {
+            std::cerr << "[ERROR] Could not open " << files[i] << std::endl;
+            return 1;
+        }
+        total += reader.query(query, countOnly ? NULL : &sink);
+    }
+
+    if (countOnly) {
+        std::printf("%lu\n", (unsigned long)total);
+    }
+    return 0;
+}